@@ -0,0 +1,155 @@
+#include "AnalogSensor.h"
+
+#ifdef ANALOG_SENSOR_AVR
+#include <util/atomic.h>
+#define ANALOG_SENSOR_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define ANALOG_SENSOR_ATOMIC
+#endif
+
+const uint8_t AnalogSensor::SAMPLES;
+const uint16_t AnalogSensor::FULL_SCALE;
+
+#ifdef ANALOG_SENSOR_AVR
+// F_CPU/128, about 9600 samples a second at 16MHz, as analogRead() uses
+#define ANALOG_SENSOR_PRESCALER (_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0))
+
+// The sensor whose burst is running, the ADC is free when none
+static AnalogSensor * volatile active_sensor = nullptr;
+
+ISR(ADC_vect)
+{
+    if (active_sensor && active_sensor->on_sample(ADC)) {
+        // The conversion started meanwhile still ends and sets ADIF, the next burst clears it
+        ADCSRA = _BV(ADEN) | ANALOG_SENSOR_PRESCALER;
+        active_sensor = nullptr;
+    }
+}
+#endif
+
+AnalogSensor::AnalogSensor(uint8_t pin, uint16_t range, bool inverted) :
+    m_pin{pin},
+    m_range{range},
+    m_inverted{inverted},
+    m_deadband{1},
+    m_min_interval{0},
+    m_max_interval{0}
+{
+    reset();
+}
+
+void AnalogSensor::set_reporting(uint16_t deadband, unsigned long min_interval, unsigned long max_interval)
+{
+    m_deadband = deadband;
+    m_min_interval = min_interval;
+    m_max_interval = max_interval;
+}
+
+void AnalogSensor::reset()
+{
+    ANALOG_SENSOR_ATOMIC {
+        m_sum = 0;
+        m_count = 0;
+        m_result = 0;
+        m_ready = false;
+    }
+    m_has_value = false;
+    m_value = 0;
+    m_reported = false;
+    m_reported_value = 0;
+    m_reported_at = 0;
+}
+
+bool AnalogSensor::on_sample(uint16_t sample)
+{
+    m_sum += sample;
+    if (++m_count < SAMPLES) {
+        return false;
+    }
+
+    m_result = m_sum >> ANALOG_SENSOR_OVERSAMPLING_BITS;
+    m_ready = true;
+    m_sum = 0;
+    m_count = 0;
+    return true;
+}
+
+bool AnalogSensor::process()
+{
+    return process(millis());
+}
+
+bool AnalogSensor::process(unsigned long now)
+{
+    sample();
+
+    ANALOG_SENSOR_ATOMIC {
+        if (m_ready) {
+            m_value = scale(m_result);
+            m_has_value = true;
+            m_ready = false;
+        }
+    }
+    if (!m_has_value) {
+        return false;
+    }
+
+    unsigned long elapsed = now - m_reported_at;
+    uint16_t change = m_value > m_reported_value ? m_value - m_reported_value : m_reported_value - m_value;
+
+    if (m_reported
+        && (change < m_deadband || elapsed < m_min_interval)
+        && (m_max_interval == 0 || elapsed < m_max_interval)) {
+        return false;
+    }
+
+    m_reported = true;
+    m_reported_value = m_value;
+    m_reported_at = now;
+    return true;
+}
+
+// Starts a burst when there is no block to read, or finishes it right away without the ADC interrupt
+void AnalogSensor::sample()
+{
+#ifdef ANALOG_SENSOR_AVR
+    // Pins are numbered from A0 as analogRead() does
+    uint8_t channel = m_pin >= A0 ? m_pin - A0 : m_pin;
+
+    ANALOG_SENSOR_ATOMIC {
+        // A sleep turns the ADC off, which stops the burst. It's started over, the samples taken
+        // before the sleep are stale anyway.
+        bool stalled = active_sensor == this && !(ADCSRA & _BV(ADSC));
+        if (!m_ready && (active_sensor == nullptr || stalled)) {
+            active_sensor = this;
+            m_sum = 0;
+            m_count = 0;
+            ADMUX = _BV(REFS0) | (channel & 0x07);  // AVcc reference
+            ADCSRB = 0;                             // free running
+            // Writing ADIF clears the flag of the last conversion, else it would be taken as the
+            // first sample, maybe of another channel
+            ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) | _BV(ADIF) | ANALOG_SENSOR_PRESCALER;
+        }
+    }
+#else
+    for (uint8_t i = 0; i < SAMPLES && !m_ready; i++) {
+        on_sample(analogRead(m_pin));
+    }
+#endif
+}
+
+uint16_t AnalogSensor::get_value() const
+{
+    return m_value;
+}
+
+uint16_t AnalogSensor::scale(uint16_t result) const
+{
+    if (result > FULL_SCALE) {
+        result = FULL_SCALE;
+    }
+    if (m_inverted) {
+        result = FULL_SCALE - result;
+    }
+    return ((uint32_t) result * m_range + FULL_SCALE / 2) / FULL_SCALE;
+}
@@ -0,0 +1,80 @@
+#ifndef ARDUINO_ANALOGSENSOR_H
+#define ARDUINO_ANALOGSENSOR_H
+
+#include <Arduino.h>
+
+#ifndef ANALOG_SENSOR_OVERSAMPLING_BITS
+#define ANALOG_SENSOR_OVERSAMPLING_BITS     2
+#endif
+#if ANALOG_SENSOR_OVERSAMPLING_BITS > 3
+#error "AnalogSensor counts the samples of a block in a byte, 3 oversampling bits at most"
+#endif
+
+// An analog input read in the background and reported only when it's worth the airtime.
+//
+// On AVR `process` starts a burst of 4^ANALOG_SENSOR_OVERSAMPLING_BITS conversions, about 1.7ms,
+// and the ADC interrupts after each sample, so the loop never waits for a conversion. The samples
+// are summed and decimated to ANALOG_SENSOR_OVERSAMPLING_BITS more bits than the ADC has, which
+// also filters the noise. The last sample of the burst stops the ADC, the next `process` reads
+// the result and starts another one, the ADC doesn't run between. Sensors take turns on the ADC,
+// a burst cut by a sleep is started over, and analogRead() works between the bursts. Elsewhere,
+// and in the unit tests, `process` takes the samples with analogRead().
+//
+// The result is scaled with integers to 0..`range`, counting from the top if `inverted`.
+// `process` reports a value when it moved by `deadband` or more and `min_interval` passed since
+// the last report, or when `max_interval` passed anyway, so the gateway hears from the sensor
+// regularly. The first value is reported at once. Intervals are in milliseconds, 0 for none.
+#if defined(__AVR__) && !defined(UNITTESTS)
+#define ANALOG_SENSOR_AVR
+#endif
+
+class AnalogSensor
+{
+public:
+    static const uint8_t SAMPLES = 1 << (2 * ANALOG_SENSOR_OVERSAMPLING_BITS);
+    static const uint16_t FULL_SCALE = 1023 << ANALOG_SENSOR_OVERSAMPLING_BITS;
+
+    AnalogSensor(uint8_t pin, uint16_t range, bool inverted = false);
+
+    void set_reporting(uint16_t deadband, unsigned long min_interval, unsigned long max_interval);
+
+    // Forgets the value and the last report, the next one is reported at once
+    void reset();
+
+    // The ADC interrupt, true when the sample completes a block
+    bool on_sample(uint16_t sample);
+
+    // From the loop. True when the value should be reported, it counts as reported then.
+    bool process();
+
+    // Same as process(), for callers with their own clock, like one that goes on while sleeping
+    bool process(unsigned long now);
+
+    // The last scaled value
+    uint16_t get_value() const;
+
+private:
+    void sample();
+    uint16_t scale(uint16_t result) const;
+
+    uint8_t m_pin;
+    uint16_t m_range;
+    bool m_inverted;
+    uint16_t m_deadband;
+    unsigned long m_min_interval;
+    unsigned long m_max_interval;
+
+    // Filled by the interrupt
+    uint32_t m_sum;
+    uint8_t m_count;
+    volatile uint16_t m_result;
+    volatile bool m_ready;
+
+    bool m_has_value;
+    uint16_t m_value;
+    bool m_reported;
+    uint16_t m_reported_value;
+    unsigned long m_reported_at;
+};
+
+#endif //ARDUINO_ANALOGSENSOR_H
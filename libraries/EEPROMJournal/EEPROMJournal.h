@@ -0,0 +1,132 @@
+#ifndef ARDUINO_EEPROMJOURNAL_H
+#define ARDUINO_EEPROMJOURNAL_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Ring of sequence numbered records spread over a window of `slots` records starting at `start`.
+// Every save goes to the next slot, so each cell is written once per lap instead of on every save.
+//
+// Record layout: | sequence, uint16 LE | T | crc8 of the preceding bytes |
+//
+// The CRC is written last, so a save interrupted by a reset leaves an invalid record and the
+// previous one is loaded instead. The CRC starts from 0xFF, so a zeroed window never checks out,
+// and sequence 0xFFFF is never used, so neither does an erased one.
+template <typename T, typename EEPROM_T>
+class EEPROMJournal
+{
+public:
+    static const uint8_t RECORD_SIZE = sizeof(uint16_t) + sizeof(T) + 1;
+
+    EEPROMJournal(EEPROM_T & eeprom, int start, uint8_t slots) :
+        m_eeprom(eeprom),
+        m_start{start},
+        m_slots{slots},
+        m_slot{(uint8_t)(slots - 1)},
+        m_sequence{ERASED_SEQUENCE},
+        m_record{},
+        m_position{RECORD_SIZE}
+    {
+    }
+
+    // Finds the newest valid record. Returns false if there is none, `value` is left untouched then.
+    bool load(T & value)
+    {
+        bool found = false;
+        uint8_t record[RECORD_SIZE];
+
+        for (uint8_t slot = 0; slot < m_slots; slot++) {
+            int address = slot_address(slot);
+            for (uint8_t i = 0; i < RECORD_SIZE; i++) {
+                record[i] = m_eeprom.read(address + i);
+            }
+
+            uint16_t sequence = record[0] | (uint16_t)record[1] << 8;
+            if (sequence == ERASED_SEQUENCE || crc8(record, RECORD_SIZE - 1) != record[RECORD_SIZE - 1]) {
+                continue;
+            }
+            // Sequence numbers wrap around, the newest is the one ahead of all others
+            if (found && (int16_t)(sequence - m_sequence) <= 0) {
+                continue;
+            }
+
+            found = true;
+            m_slot = slot;
+            m_sequence = sequence;
+            memcpy(&value, record + sizeof(uint16_t), sizeof(T));
+        }
+        return found;
+    }
+
+    void save(const T & value)
+    {
+        begin_save(value);
+        while (save_step()) {
+        }
+    }
+
+    // Incremental save, for callers that can't block for the whole record. `begin_save` takes a
+    // copy of the value, then each `save_step` writes one cell. Returns true while cells are left.
+    void begin_save(const T & value)
+    {
+        m_slot = (m_slot + 1) % m_slots;
+        m_sequence++;
+        if (m_sequence == ERASED_SEQUENCE) {
+            m_sequence = 0;
+        }
+
+        m_record[0] = m_sequence & 0xFF;
+        m_record[1] = m_sequence >> 8;
+        memcpy(m_record + sizeof(uint16_t), &value, sizeof(T));
+        m_record[RECORD_SIZE - 1] = crc8(m_record, RECORD_SIZE - 1);
+        m_position = 0;
+    }
+
+    bool save_step()
+    {
+        if (m_position < RECORD_SIZE) {
+            // `update` skips cells that already hold the value
+            m_eeprom.update(slot_address(m_slot) + m_position, m_record[m_position]);
+            m_position++;
+        }
+        return is_saving();
+    }
+
+    bool is_saving() const
+    {
+        return m_position < RECORD_SIZE;
+    }
+
+private:
+    static const uint16_t ERASED_SEQUENCE = 0xFFFF;
+
+    int slot_address(uint8_t slot) const
+    {
+        return m_start + (int)slot * RECORD_SIZE;
+    }
+
+    // Dallas/Maxim CRC-8, the same as `_crc_ibutton_update` from avr-libc
+    static uint8_t crc8(const uint8_t * data, uint8_t size)
+    {
+        uint8_t crc = 0xFF;
+        while (size--) {
+            crc ^= *data++;
+            for (uint8_t i = 0; i < 8; i++) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0x8C : crc >> 1;
+            }
+        }
+        return crc;
+    }
+
+    EEPROM_T & m_eeprom;
+    int m_start;
+    uint8_t m_slots;
+
+    uint8_t m_slot;
+    uint16_t m_sequence;
+
+    uint8_t m_record[RECORD_SIZE];
+    uint8_t m_position;
+};
+
+#endif //ARDUINO_EEPROMJOURNAL_H
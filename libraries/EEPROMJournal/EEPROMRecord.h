@@ -0,0 +1,75 @@
+#ifndef ARDUINO_EEPROMRECORD_H
+#define ARDUINO_EEPROMRECORD_H
+
+#include <stdint.h>
+#include <string.h>
+
+// A plain record at a fixed address, with the same incremental save interface as EEPROMJournal.
+// Every written cell is read back, cells that don't keep the value are counted in `get_failures`.
+template <typename T, typename EEPROM_T>
+class EEPROMRecord
+{
+public:
+    EEPROMRecord(EEPROM_T & eeprom, int address) :
+        m_eeprom(eeprom),
+        m_address{address},
+        m_record{},
+        m_position{sizeof(T)},
+        m_failures{0}
+    {
+    }
+
+    bool load(T & value)
+    {
+        uint8_t * ptr = (uint8_t *)&value;
+        for (uint8_t i = 0; i < sizeof(T); i++) {
+            ptr[i] = m_eeprom.read(m_address + i);
+        }
+        return true;
+    }
+
+    void save(const T & value)
+    {
+        begin_save(value);
+        while (save_step()) {
+        }
+    }
+
+    void begin_save(const T & value)
+    {
+        memcpy(m_record, &value, sizeof(T));
+        m_position = 0;
+    }
+
+    bool save_step()
+    {
+        if (m_position < sizeof(T)) {
+            m_eeprom.update(m_address + m_position, m_record[m_position]);
+            if (m_eeprom.read(m_address + m_position) != m_record[m_position]) {
+                m_failures++;
+            }
+            m_position++;
+        }
+        return is_saving();
+    }
+
+    bool is_saving() const
+    {
+        return m_position < sizeof(T);
+    }
+
+    uint8_t get_failures() const
+    {
+        return m_failures;
+    }
+
+private:
+    EEPROM_T & m_eeprom;
+    int m_address;
+
+    uint8_t m_record[sizeof(T)];
+    uint8_t m_position;
+    uint8_t m_failures;
+};
+
+#endif //ARDUINO_EEPROMRECORD_H
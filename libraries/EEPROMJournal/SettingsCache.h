@@ -0,0 +1,83 @@
+#ifndef ARDUINO_SETTINGSCACHE_H
+#define ARDUINO_SETTINGSCACHE_H
+
+#include <stdint.h>
+
+// Write-behind cache of settings kept in EEPROM. The sketch changes `value` in place and calls
+// `touch`; the value is saved once nothing has changed for `quiet_time` ms, one cell per `process`
+// call, so a burst of changes costs a single save and a loop iteration never waits for more than
+// one cell write (~3.3 ms). Changes not saved yet are lost on a power cut or reboot.
+//
+// STORE_T is EEPROMJournal, EEPROMRecord or anything with `load`, `begin_save`, `save_step` and
+// `is_saving`.
+template <typename T, typename STORE_T>
+class SettingsCache
+{
+public:
+    SettingsCache(T & value, STORE_T & store, unsigned long quiet_time) :
+        m_value(value),
+        m_store(store),
+        m_quiet_time{quiet_time},
+        m_touched{false},
+        m_dirty{false},
+        m_changed_at{0}
+    {
+    }
+
+    bool load()
+    {
+        m_touched = false;
+        m_dirty = false;
+        return m_store.load(m_value);
+    }
+
+    void touch()
+    {
+        m_touched = true;
+    }
+
+    // Returns true while there is something left to save
+    bool process(unsigned long now)
+    {
+        if (m_touched) {
+            m_touched = false;
+            m_dirty = true;
+            m_changed_at = now;
+        }
+
+        // A save in progress goes on with the copy it was started with, changes made meanwhile
+        // are saved by the next one
+        if (m_store.is_saving()) {
+            m_store.save_step();
+        }
+        else if (m_dirty && now - m_changed_at >= m_quiet_time) {
+            m_dirty = false;
+            m_store.begin_save(m_value);
+            m_store.save_step();
+        }
+        return is_dirty();
+    }
+
+    // Forgets changes not saved yet, a save in progress is still completed
+    void discard()
+    {
+        m_touched = false;
+        m_dirty = false;
+    }
+
+    bool is_dirty() const
+    {
+        return m_touched || m_dirty || m_store.is_saving();
+    }
+
+private:
+    T & m_value;
+    STORE_T & m_store;
+    unsigned long m_quiet_time;
+
+    bool m_touched;
+    bool m_dirty;
+    unsigned long m_changed_at;
+};
+
+#endif //ARDUINO_SETTINGSCACHE_H
@@ -0,0 +1,56 @@
+#ifndef ARDUINO_FASTPIN_H
+#define ARDUINO_FASTPIN_H
+
+#include <Arduino.h>
+
+// On AVR the pin number is resolved at compile time with the DigitalIO templates bundled with
+// MySensors, so a write is a single SBI/CBI instead of the table lookups of digitalWrite.
+// Elsewhere, and in the unit tests, it falls back to digitalWrite/digitalRead.
+#if defined(__AVR__) && !defined(UNITTESTS)
+#define FAST_PIN_AVR
+#include <drivers/AVR/DigitalIO/DigitalPin.h>
+#endif
+
+// A FastPin for code that gets its pins at run time, like a table of outputs. A call through it
+// costs an indirect call, still far less than digitalWrite.
+struct FastPinHandle
+{
+    uint8_t pin;
+    void (* write)(uint8_t value);
+    uint8_t (* read)();
+};
+
+template <uint8_t PIN>
+class FastPin
+{
+public:
+    static void mode(uint8_t mode)
+    {
+        pinMode(PIN, mode);
+    }
+
+    static inline void write(uint8_t value)
+    {
+#ifdef FAST_PIN_AVR
+        fastDigitalWrite(PIN, value != LOW);
+#else
+        digitalWrite(PIN, value);
+#endif
+    }
+
+    static inline uint8_t read()
+    {
+#ifdef FAST_PIN_AVR
+        return fastDigitalRead(PIN) ? HIGH : LOW;
+#else
+        return digitalRead(PIN);
+#endif
+    }
+
+    static constexpr FastPinHandle handle()
+    {
+        return FastPinHandle{PIN, &FastPin::write, &FastPin::read};
+    }
+};
+
+#endif //ARDUINO_FASTPIN_H
@@ -0,0 +1,113 @@
+/*
+ * FadeStepper.cpp
+ */
+
+#include <limits.h>
+
+#include "FadeStepper.h"
+
+FadeStepper::FadeStepper() {
+  value = 0;
+  target = 0;
+  duration = 0;
+  elapsed = 0;
+  next_ms = 0;
+  step_ms = 0;
+  next_frac = 0;
+  step_frac = 0;
+  step_denom = 1;
+}
+
+void FadeStepper::start(uint8_t from, uint8_t to, unsigned long time) {
+  value = from;
+  target = to;
+  duration = time;
+  elapsed = 0;
+
+  if (from == to || time == 0) {
+    value = to;
+    duration = 0;
+    return;
+  }
+
+  uint8_t steps = (from < to) ? to - from : from - to;
+  step_denom = 2 * steps;
+
+  // A step is duration / steps long, in halves of a step to keep the remainder exact
+  step_ms = duration / steps;
+  step_frac = 2 * (duration % steps);
+
+  // The first boundary is half a step in
+  next_ms = duration / step_denom;
+  next_frac = duration % step_denom;
+}
+
+void FadeStepper::stop() {
+  duration = 0;
+  elapsed = 0;
+}
+
+bool FadeStepper::advance(unsigned long time_diff) {
+  if (duration == 0) {
+    return false;
+  }
+
+  // We've hit 100%, jump to the final value
+  if (time_diff >= duration - elapsed) {
+    value = target;
+    stop();
+    return false;
+  }
+  elapsed += time_diff;
+
+  // Move the value by as many steps as there are boundaries passed
+  while (value != target && elapsed >= next_ms + (next_frac ? 1 : 0)) {
+    if (value < target) {
+      value++;
+    }
+    else {
+      value--;
+    }
+
+    next_ms += step_ms;
+    next_frac += step_frac;
+    if (next_frac >= step_denom) {
+      next_frac -= step_denom;
+      next_ms++;
+    }
+  }
+
+  return true;
+}
+
+bool FadeStepper::is_running() {
+  return duration > 0;
+}
+
+uint8_t FadeStepper::get_value() {
+  return value;
+}
+
+uint8_t FadeStepper::get_target() {
+  return target;
+}
+
+unsigned long FadeStepper::get_duration() {
+  return duration;
+}
+
+unsigned long FadeStepper::get_elapsed() {
+  return elapsed;
+}
+
+uint8_t FadeStepper::get_percent(unsigned long elapsed, unsigned long duration) {
+  if (duration == 0 || elapsed >= duration) {
+    return 100;
+  }
+
+  // Exact while elapsed * 100 fits, only fades of over 11 hours scale the duration down
+  if (duration <= ULONG_MAX / 100) {
+    return elapsed * 100 / duration;
+  }
+  return elapsed / (duration / 100);
+}
@@ -0,0 +1,65 @@
+/*
+ * FadeStepper.h
+ *
+ * Integer fade engine behind LEDFader. Moves a PWM value towards a target one step at a
+ * time, with the steps spread evenly over the fade time, Bresenham style: the step
+ * boundaries are tracked as a whole ms part plus a remainder, so start() does the only
+ * divisions and advance() only adds and compares. No float math, no heap.
+ */
+
+#include "Arduino.h"
+
+#ifndef FadeStepper_H_
+#define FadeStepper_H_
+
+class FadeStepper
+{
+private:
+  uint8_t value;
+  uint8_t target;
+  unsigned long duration;
+  unsigned long elapsed;
+
+  // The value moves to the next step at ceil((2k - 1) * duration / (2 * steps)) ms, which is
+  // where the exact line crosses the middle between two PWM values. The boundary is kept as
+  // `next_ms + next_frac / step_denom`, and moves on by `step_ms + step_frac / step_denom`.
+  unsigned long next_ms;
+  unsigned long step_ms;
+  uint16_t next_frac;
+  uint16_t step_frac;
+  uint16_t step_denom;
+
+  public:
+
+    FadeStepper();
+
+    // Start moving from one PWM value to another over a duration of time (milliseconds)
+    void start(uint8_t from, uint8_t to, unsigned long time);
+
+    // Stop where the value currently is
+    void stop();
+
+    // Move the time on by a number of milliseconds
+    // Returns TRUE if the fade is still in process
+    bool advance(unsigned long time_diff);
+
+    // Returns TRUE if there is an active fade process
+    bool is_running();
+
+    // Get the current PWM value
+    uint8_t get_value();
+
+    // Get the PWM value we're moving to
+    uint8_t get_target();
+
+    // Get the total time of the fade (milliseconds)
+    unsigned long get_duration();
+
+    // Get the time spent in the fade so far (milliseconds)
+    unsigned long get_elapsed();
+
+    // How much of a duration has elapsed in a percentage between 0 - 100
+    static uint8_t get_percent(unsigned long elapsed, unsigned long duration);
+};
+
+#endif /* FadeStepper_H_ */
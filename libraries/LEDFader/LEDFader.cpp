@@ -13,8 +13,8 @@ LEDFader::LEDFader(uint8_t pwm_pin) {
   to_color = 0;
   last_step_time = 0;
   interval = 0;
-  duration = 0;
   percent_done = 0;
+  progress_base = 0;
   curve = (curve_function)0;
 }
 
@@ -54,30 +54,32 @@ LEDFader::curve_function LEDFader::get_curve() {
 }
 
 void LEDFader::slower(int by) {
-  float cached_percent = percent_done;
-  duration += by;
-  fade(to_color, duration);
-  percent_done = cached_percent;
+  uint8_t cached_percent = get_progress();
+  unsigned long remaining = stepper.get_duration() - stepper.get_elapsed();
+  fade(to_color, remaining + by);
+  progress_base = cached_percent;
 }
 
 void LEDFader::faster(int by) {
-  float cached_percent = percent_done;
+  uint8_t cached_percent = get_progress();
+  unsigned long remaining = stepper.get_duration() - stepper.get_elapsed();
 
   // Ends the fade
-  if (duration <= by) {
+  if (by >= 0 && remaining <= (unsigned long)by) {
     stop_fade();
     set_value(to_color);
+    percent_done = cached_percent;
   }
   else {
-    duration -= by;
-    fade(to_color, duration);
+    fade(to_color, remaining - by);
+    progress_base = cached_percent;
   }
-  percent_done = cached_percent;
 }
 
 void LEDFader::fade(uint8_t value, unsigned long time) {
   stop_fade();
   percent_done = 0;
+  progress_base = 0;
 
   // No pin defined
   if (!pin) {
@@ -94,13 +96,13 @@ void LEDFader::fade(uint8_t value, unsigned long time) {
     return;
   }
 
-  duration = time;
-  to_color = (uint8_t)constrain(value, 0, 255);
+  to_color = value;
+  stepper.start(color, to_color, time);
 
   // Figure out what the interval should be so that we're chaning the color by at least 1 each cycle
   // (minimum interval is MIN_INTERVAL)
-  float color_diff = abs(color - to_color);
-  interval = round((float)duration / color_diff);
+  unsigned long color_diff = abs(color - to_color);
+  interval = (time + color_diff / 2) / color_diff;
   if (interval < MIN_INTERVAL) {
     interval = MIN_INTERVAL;
   }
@@ -111,21 +113,28 @@ void LEDFader::fade(uint8_t value, unsigned long time) {
 bool LEDFader::is_fading() {
   if (!pin)
     return false;
-  if (duration > 0)
-    return true;
-  return false;
+  return stepper.is_running();
 }
 
 void LEDFader::stop_fade() {
   percent_done = 100;
-  duration = 0;
+  stepper.stop();
 }
 
 uint8_t LEDFader::get_progress() {
-  return round(percent_done);
+  if (!stepper.is_running()) {
+    return percent_done;
+  }
+
+  uint8_t percent = FadeStepper::get_percent(stepper.get_elapsed(), stepper.get_duration());
+  return progress_base + (100 - progress_base) * percent / 100;
 }
 
 bool LEDFader::update() {
+  return update(millis());
+}
+
+bool LEDFader::update(unsigned long now) {
 
   // No pin defined
   if (!pin) {
@@ -133,37 +142,26 @@ bool LEDFader::update() {
   }
 
   // No fade
-  if (duration == 0) {
+  if (!stepper.is_running()) {
     return false;
   }
 
-  unsigned long now = millis();
   unsigned long time_diff = now - last_step_time;
 
   // Interval hasn't passed yet
   if (time_diff < interval) {
     return true;
   }
+  last_step_time = now;
 
-  // How far along have we gone since last update
-  float percent = (float)time_diff / (float)duration;
-  percent_done += percent;
-
-  // We've hit 100%, set LED to the final color
-  if (percent >= 1) {
+  // Move color to where it should be. We've hit 100% once the stepper stops.
+  bool fading = stepper.advance(time_diff);
+  if (!fading) {
     stop_fade();
-    set_value(to_color);
-    return false;
   }
 
-  // Move color to where it should be
-  int color_diff = to_color - color;
-  int increment = round(color_diff * percent);
-
-  set_value(color + increment);
-
-  // Update time and finish
-  duration -= time_diff;
-  last_step_time = millis();
-  return true;
+  if (stepper.get_value() != color) {
+    set_value(stepper.get_value());
+  }
+  return fading;
 }
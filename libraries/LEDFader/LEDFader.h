@@ -6,6 +6,7 @@
  */
 
 #include "Arduino.h"
+#include "FadeStepper.h"
 
 #ifndef LEDFader_H_
 #define LEDFader_H_
@@ -25,8 +26,9 @@ private:
   unsigned long interval;
   uint8_t color;
   uint8_t to_color;
-  unsigned long duration;
-  float percent_done;
+  FadeStepper stepper;
+  uint8_t percent_done;
+  uint8_t progress_base;
   curve_function curve;
 
   public:
@@ -67,6 +69,9 @@ private:
     // Returns TRUE if a fade is still in process
     bool update();
 
+    // Same as update(), for callers that already have the current millis()
+    bool update(unsigned long now);
+
     // Decrease the current fading speed by a number of milliseconds
     void slower(int by_seconds);
 
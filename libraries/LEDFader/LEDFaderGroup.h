@@ -0,0 +1,198 @@
+/*
+ * LEDFaderGroup.h
+ *
+ * Fades N LEDs, e.g. the channels of an RGB(W) strip, together as one vector: the group
+ * reads the clock once per update, steps all channels in one pass on a shared interval,
+ * and reports the end of the fade once for the whole group, so channels can't drift apart.
+ */
+
+#include "Arduino.h"
+#include "FadeStepper.h"
+#include "LEDFader.h"
+
+#ifndef LEDFaderGroup_H_
+#define LEDFaderGroup_H_
+
+template <uint8_t N>
+class LEDFaderGroup
+{
+public:
+  // The minimum time (milliseconds) the program will wait between LED adjustments
+  static const byte MIN_INTERVAL = LEDFader::MIN_INTERVAL;
+
+  typedef void (*on_complete_t)(void * user_data);
+  typedef LEDFader::curve_function curve_function;
+
+private:
+  uint8_t pins[N];
+  uint8_t colors[N];
+  FadeStepper steppers[N];
+  unsigned long last_step_time;
+  unsigned long interval;
+  unsigned long duration;
+  unsigned long elapsed;
+  on_complete_t complete_cb;
+  void * complete_data;
+  curve_function curve;
+
+  // Like LEDFader, a channel on pin 0 is tracked but not written, and the curve only
+  // transforms the output, the fade runs on the linear values
+  void write(uint8_t channel, uint8_t value) {
+    colors[channel] = value;
+    if (!pins[channel]) return;
+    if (curve)
+      analogWrite(pins[channel], curve(value));
+    else
+      analogWrite(pins[channel], value);
+  }
+
+  public:
+
+    // Create a new group for the PWM pins the LEDs are connected to
+    LEDFaderGroup(const uint8_t (&pwm_pins)[N]) {
+      for (uint8_t i = 0; i < N; i++) {
+        pins[i] = pwm_pins[i];
+        colors[i] = 0;
+      }
+      last_step_time = 0;
+      interval = 0;
+      duration = 0;
+      elapsed = 0;
+      complete_cb = (on_complete_t)0;
+      complete_data = (void *)0;
+      curve = (curve_function)0;
+    }
+
+    // Set all LEDs to absolute PWM values, stopping the current fade
+    void set_values(const uint8_t * values) {
+      stop_fade();
+      for (uint8_t i = 0; i < N; i++) {
+        write(i, values[i]);
+      }
+    }
+
+    // Get the current PWM value of one LED
+    uint8_t get_value(uint8_t channel) {
+      return colors[channel];
+    }
+
+    // Set curve to transform output
+    void set_curve(curve_function c) {
+      curve = c;
+    }
+
+    // Get the current curve function pointer
+    curve_function get_curve() {
+      return curve;
+    }
+
+    // Call back once each time a fade runs to its end
+    void on_complete(on_complete_t callback, void * user_data = (void *)0) {
+      complete_cb = callback;
+      complete_data = user_data;
+    }
+
+    // Fade all LEDs to PWM values over a duration of time (milliseconds).
+    // The fade takes the whole duration even if no value changes, so it can be used as a hold.
+    void fade(const uint8_t * values, unsigned long time) {
+      stop_fade();
+
+      // Too short to step, jump to the target. It still counts as a completed fade.
+      if (time <= MIN_INTERVAL) {
+        set_values(values);
+        if (complete_cb) {
+          complete_cb(complete_data);
+        }
+        return;
+      }
+
+      // One interval for the whole group, short enough for the channel with the most steps
+      uint8_t max_diff = 0;
+      for (uint8_t i = 0; i < N; i++) {
+        steppers[i].start(colors[i], values[i], time);
+        uint8_t diff = abs(colors[i] - values[i]);
+        if (diff > max_diff) {
+          max_diff = diff;
+        }
+      }
+
+      interval = max_diff ? (time + max_diff / 2) / max_diff : time;
+      if (interval < MIN_INTERVAL) {
+        interval = MIN_INTERVAL;
+      }
+
+      duration = time;
+      elapsed = 0;
+      last_step_time = millis();
+    }
+
+    // Returns TRUE if there is an active fade process
+    bool is_fading() {
+      return duration > 0;
+    }
+
+    // Stop the current fade where it's at
+    void stop_fade() {
+      for (uint8_t i = 0; i < N; i++) {
+        steppers[i].stop();
+      }
+      duration = 0;
+      elapsed = 0;
+    }
+
+    // Update the LEDs along the fade
+    // Returns TRUE if a fade is still in process
+    bool update() {
+      return update(millis());
+    }
+
+    // Same as update(), for callers that already have the current millis()
+    bool update(unsigned long now) {
+
+      // No fade
+      if (duration == 0) {
+        return false;
+      }
+
+      unsigned long time_diff = now - last_step_time;
+
+      // Interval hasn't passed yet
+      if (time_diff < interval) {
+        return true;
+      }
+      last_step_time = now;
+
+      // We've hit 100%, set LEDs to the final colors. The callback goes last, so it can start
+      // the next fade right away.
+      if (time_diff >= duration - elapsed) {
+        for (uint8_t i = 0; i < N; i++) {
+          if (colors[i] != steppers[i].get_target()) {
+            write(i, steppers[i].get_target());
+          }
+        }
+        stop_fade();
+
+        if (complete_cb) {
+          complete_cb(complete_data);
+        }
+        return is_fading();
+      }
+      elapsed += time_diff;
+
+      for (uint8_t i = 0; i < N; i++) {
+        steppers[i].advance(time_diff);
+        if (colors[i] != steppers[i].get_value()) {
+          write(i, steppers[i].get_value());
+        }
+      }
+      return true;
+    }
+
+    // Returns how much of the fade is complete in a percentage between 0 - 100
+    uint8_t get_progress() {
+      // The same as LEDFader, 100 when there is no fade
+      return FadeStepper::get_percent(elapsed, duration);
+    }
+};
+
+#endif /* LEDFaderGroup_H_ */
@@ -0,0 +1,437 @@
+#ifndef ARDUINO_LOGRING_H
+#define ARDUINO_LOGRING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#if defined(__AVR__) && !defined(UNITTESTS)
+#include <util/atomic.h>
+#define LOG_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define LOG_ATOMIC
+#endif
+
+#define LOG_ARGS_MAX        48      // bytes of arguments of a record
+#define LOG_STRING_MAX      24      // longer string arguments are cut
+#define LOG_PIECE_MAX       32      // longer conversions are cut
+
+// Arguments of a log call, stored raw in the way the format reads them back: integers as int or
+// long as the varargs promote them, strings copied with a length byte, as the buffers they come
+// from may be gone by the time the record is formatted.
+class LogArgs
+{
+public:
+    LogArgs() :
+        size{0}
+    {
+    }
+
+    void add(int value) { put(&value, sizeof(value)); }
+    void add(unsigned int value) { put(&value, sizeof(value)); }
+    void add(long value) { put(&value, sizeof(value)); }
+    void add(unsigned long value) { put(&value, sizeof(value)); }
+    void add(double value) { put(&value, sizeof(value)); }
+    void add(float value) { add((double)value); }
+    void add(const void * value) { put(&value, sizeof(value)); }
+
+    void add(const char * value)
+    {
+        uint8_t length = 0;
+        while (value && value[length] && length < LOG_STRING_MAX) {
+            length++;
+        }
+        put(&length, 1);
+        put(value, length);
+    }
+
+    void add(char * value) { add((const char *)value); }
+
+    template <typename T>
+    void add(T * value) { add((const void *)value); }
+
+    // chars, bools, enums and the like
+    template <typename T>
+    void add(T value) { add((typename Promoted<(sizeof(T) > sizeof(int))>::type)value); }
+
+    uint8_t data[LOG_ARGS_MAX];
+    uint8_t size;
+    bool truncated = false;
+
+private:
+    template <bool WIDE>
+    struct Promoted { typedef int type; };
+
+    void put(const void * value, uint8_t length)
+    {
+        if (size + length > LOG_ARGS_MAX) {
+            truncated = true;
+            return;
+        }
+        memcpy(data + size, value, length);
+        size += length;
+    }
+};
+
+template <>
+struct LogArgs::Promoted<true> { typedef long type; };
+
+// Output window of a line that is printed in pieces: the characters before `from` were printed
+// already and are only counted, then at most `room` characters go to the sink. SINK is anything
+// with write(uint8_t), like Serial.
+template <typename SINK>
+class LogOutput
+{
+public:
+    LogOutput(SINK & sink, uint16_t from, uint16_t room) :
+        m_sink(sink),
+        m_from{from},
+        m_room{room},
+        m_position{0}
+    {
+    }
+
+    void put(uint8_t c)
+    {
+        if (m_position >= m_from && m_position - m_from < m_room) {
+            m_sink.write(c);
+        }
+        m_position++;
+    }
+
+    void put(const char * text)
+    {
+        while (*text) {
+            put((uint8_t)*text++);
+        }
+    }
+
+    // Some of the line didn't fit and is left for the next time
+    bool is_cut() const
+    {
+        return m_position > m_from + m_room;
+    }
+
+    // Characters that went to the sink
+    uint16_t get_printed() const
+    {
+        uint16_t end = is_cut() ? m_from + m_room : m_position;
+        return end > m_from ? end - m_from : 0;
+    }
+
+    // Moves `from` past the printed characters, or back to the start once the line is done.
+    // Returns the characters printed.
+    uint16_t advance(uint16_t & from) const
+    {
+        uint16_t printed = get_printed();
+        from = is_cut() ? from + printed : 0;
+        return printed;
+    }
+
+private:
+    SINK & m_sink;
+    uint16_t m_from;
+    uint16_t m_room;
+    uint16_t m_position;
+};
+
+// Records of log calls kept unformatted in a ring of SIZE bytes:
+//
+// | header | arguments size, uint8 | arguments |
+//
+// A push takes the time of copying the arguments, the formatting is left to the printing. Records
+// that don't fit are dropped and counted, the caller never waits. Pushes may come from interrupts,
+// the ring is changed with them disabled.
+//
+// A record is printed straight from the ring and only leaves it once all of it is out, so there is
+// no line buffer: a record cut by a full serial buffer is formatted again by the next call, which
+// goes on from where the last one stopped.
+template <uint16_t SIZE>
+class LogQueue
+{
+public:
+    LogQueue() :
+        m_data{},
+        m_head{0},
+        m_tail{0},
+        m_used{0},
+        m_dropped{0},
+        m_reported{0}
+    {
+    }
+
+    bool is_empty() const
+    {
+        bool empty = false;
+        LOG_ATOMIC {
+            empty = m_used == 0 && m_dropped == 0 && m_reported == 0;
+        }
+        return empty;
+    }
+
+    uint16_t get_dropped() const
+    {
+        uint16_t dropped = 0;
+        LOG_ATOMIC {
+            dropped = m_dropped;
+        }
+        return dropped;
+    }
+
+protected:
+    template <typename HEADER, typename... Args>
+    bool push_record(const HEADER & header, Args... args)
+    {
+        LogArgs values;
+        int expand[] = {0, (values.add(args), 0)...};
+        (void)expand;
+
+        uint16_t size = sizeof(header) + 1 + values.size;
+        bool pushed = false;
+        LOG_ATOMIC {
+            if (values.truncated || SIZE - m_used < size) {
+                if (m_dropped < 0xFFFF) {
+                    m_dropped++;
+                }
+            }
+            else {
+                write(&header, sizeof(header));
+                write(&values.size, 1);
+                write(values.data, values.size);
+                pushed = true;
+            }
+        }
+        return pushed;
+    }
+
+    // Reads the oldest record and leaves it in the ring
+    template <typename HEADER>
+    bool peek_record(HEADER & header, LogArgs & values) const
+    {
+        uint16_t used = 0;
+        LOG_ATOMIC {
+            used = m_used;
+        }
+        if (used == 0) {
+            return false;
+        }
+
+        // Pushes only write past the head, the oldest record stays as it is
+        uint16_t at = m_tail;
+        read(at, &header, sizeof(header));
+        read(at, &values.size, 1);
+        read(at, values.data, values.size);
+        return true;
+    }
+
+    template <typename HEADER>
+    void drop_record(const HEADER & header, const LogArgs & values)
+    {
+        uint16_t size = sizeof(header) + 1 + values.size;
+        LOG_ATOMIC {
+            m_tail = (m_tail + size) % SIZE;
+            m_used -= size;
+        }
+    }
+
+    // Count of the dropped records to report. The count is taken once, between lines, so a report
+    // doesn't cut into a line being printed nor change while it's printed, and stays until
+    // `end_report`.
+    uint16_t get_report(bool between_lines)
+    {
+        LOG_ATOMIC {
+            if (m_reported == 0 && between_lines) {
+                m_reported = m_dropped;
+                m_dropped = 0;
+            }
+        }
+        return m_reported;
+    }
+
+    void end_report()
+    {
+        m_reported = 0;
+    }
+
+private:
+    void write(const void * data, uint16_t size)
+    {
+        const uint8_t * bytes = static_cast<const uint8_t *>(data);
+        while (size--) {
+            m_data[m_head] = *bytes++;
+            if (++m_head == SIZE) {
+                m_head = 0;
+            }
+            m_used++;
+        }
+    }
+
+    void read(uint16_t & at, void * data, uint16_t size) const
+    {
+        uint8_t * bytes = static_cast<uint8_t *>(data);
+        while (size--) {
+            *bytes++ = m_data[at];
+            if (++at == SIZE) {
+                at = 0;
+            }
+        }
+    }
+
+    uint8_t m_data[SIZE];
+    uint16_t m_head;
+    uint16_t m_tail;
+    volatile uint16_t m_used;
+    volatile uint16_t m_dropped;
+    uint16_t m_reported;
+};
+
+// Records of a PROGMEM format, the file and the line, printed as text
+template <uint16_t SIZE>
+class LogRing : public LogQueue<SIZE>
+{
+public:
+    template <typename... Args>
+    bool push(const char * format, const char * file, uint16_t line, Args... args)
+    {
+        return this->push_record(Site{format, file, line}, args...);
+    }
+
+    // Prints the line of the oldest record with a CRLF to `sink`, from its character `from` on and
+    // at most `room` characters. `from` goes along, back to 0 once the record is printed to its end.
+    // Returns the characters printed. Dropped records are reported first.
+    template <typename SINK>
+    uint16_t print(SINK & sink, uint16_t room, uint16_t & from)
+    {
+        LogOutput<SINK> out(sink, from, room);
+        char piece[LOG_PIECE_MAX];
+
+        uint16_t dropped = this->get_report(from == 0);
+        if (dropped) {
+            snprintf(piece, sizeof(piece), "%u", dropped);
+            out.put("[WARN] Log dropped ");
+            out.put(piece);
+            out.put(" records\r\n");
+            if (!out.is_cut()) {
+                this->end_report();
+            }
+            return out.advance(from);
+        }
+
+        Site site;
+        LogArgs values;
+        if (!this->peek_record(site, values)) {
+            return 0;
+        }
+
+        format_record(out, site.format, values);
+        out.put(" [");
+        out.put(site.file);
+        snprintf(piece, sizeof(piece), ":%u]\r\n", site.line);
+        out.put(piece);
+        if (!out.is_cut()) {
+            this->drop_record(site, values);
+        }
+        return out.advance(from);
+    }
+
+private:
+    struct Site
+    {
+        const char * format;
+        const char * file;
+        uint16_t line;
+    };
+
+    // printf of a PROGMEM format over stored arguments, one conversion at a time
+    template <typename SINK>
+    static void format_record(LogOutput<SINK> & out, const char * format, const LogArgs & values)
+    {
+        uint8_t position = 0;
+        char c;
+
+        while ((c = pgm_read_byte(format++)) && !out.is_cut()) {
+            if (c != '%') {
+                out.put((uint8_t)c);
+                continue;
+            }
+
+            // The conversion spec, copied to RAM for snprintf
+            char spec[12] = "%";
+            uint8_t spec_length = 1;
+            bool wide = false;
+            bool star = false;
+            do {
+                c = pgm_read_byte(format++);
+                if (c == 'l') {
+                    wide = true;
+                }
+                if (c == '*') {
+                    star = true;
+                }
+                if (spec_length < sizeof(spec) - 1) {
+                    spec[spec_length++] = c;
+                }
+            } while (c && !strchr("diouxXcspfeEgG%", c));
+            spec[spec_length] = '\0';
+            if (!c) {
+                break;
+            }
+
+            char to[LOG_PIECE_MAX];
+            size_t room = sizeof(to);
+            int written = 0;
+            int precision = 0;
+            if (star) {
+                take(values, position, &precision, sizeof(precision));
+            }
+
+            if (c == '%') {
+                written = snprintf(to, room, "%%");
+            }
+            else if (c == 's') {
+                char text[LOG_STRING_MAX + 1];
+                uint8_t text_length = 0;
+                take(values, position, &text_length, 1);
+                take(values, position, text, text_length);
+                text[text_length] = '\0';
+                written = star ? snprintf(to, room, spec, precision, text) : snprintf(to, room, spec, text);
+            }
+            else if (c == 'p') {
+                const void * value = nullptr;
+                take(values, position, &value, sizeof(value));
+                written = snprintf(to, room, spec, value);
+            }
+            else if (strchr("feEgG", c)) {
+                double value = 0;
+                take(values, position, &value, sizeof(value));
+                written = star ? snprintf(to, room, spec, precision, value) : snprintf(to, room, spec, value);
+            }
+            else if (wide) {
+                long value = 0;
+                take(values, position, &value, sizeof(value));
+                written = star ? snprintf(to, room, spec, precision, value) : snprintf(to, room, spec, value);
+            }
+            else {
+                int value = 0;
+                take(values, position, &value, sizeof(value));
+                written = star ? snprintf(to, room, spec, precision, value) : snprintf(to, room, spec, value);
+            }
+
+            if (written > 0) {
+                out.put(to);
+            }
+        }
+    }
+
+    static void take(const LogArgs & values, uint8_t & position, void * value, uint8_t size)
+    {
+        if (position + size > values.size) {
+            return;
+        }
+        memcpy(value, values.data + position, size);
+        position += size;
+    }
+};
+
+#endif //ARDUINO_LOGRING_H
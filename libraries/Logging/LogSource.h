@@ -0,0 +1,27 @@
+#ifndef ARDUINO_LOGSOURCE_H
+#define ARDUINO_LOGSOURCE_H
+
+#include <stddef.h>
+
+// The file name of a log call without the directories, found at compile time
+struct LogSource
+{
+    // Offset of the name in the path, after the last slash or backslash
+    static constexpr size_t basename_offset(const char * path, size_t position = 0, size_t offset = 0)
+    {
+        return path[position] == '\0' ? offset :
+               path[position] == '/' || path[position] == '\\' ? basename_offset(path, position + 1, position + 1) :
+               basename_offset(path, position + 1, offset);
+    }
+
+    // Turns a constant expression into a constant, so it isn't left to the run time
+    template <size_t VALUE>
+    struct Constant
+    {
+        static constexpr size_t value = VALUE;
+    };
+};
+
+#define LOG_BASENAME(_path) (_path + LogSource::Constant<LogSource::basename_offset(_path)>::value)
+
+#endif //ARDUINO_LOGSOURCE_H
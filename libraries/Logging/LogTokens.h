@@ -0,0 +1,112 @@
+#ifndef ARDUINO_LOGTOKENS_H
+#define ARDUINO_LOGTOKENS_H
+
+#include "LogRing.h"
+#include "LogSource.h"
+
+// Tokenized logging: a log call is sent as the token of its site and the raw arguments, the text
+// is put back on the host by libraries/Logging/tools/logtokens.py from the sources it was built of.
+//
+// A token is FNV-1a of the file name, without the directories, followed by the two bytes of the line,
+// computed at compile time. Token 0 is kept for the count of dropped records.
+struct LogToken
+{
+    static constexpr uint32_t OFFSET = 2166136261UL;
+    static constexpr uint32_t PRIME = 16777619UL;
+
+    static constexpr uint32_t mix(uint32_t hash, uint8_t byte)
+    {
+        return (uint32_t)((hash ^ byte) * PRIME);
+    }
+
+    static constexpr uint32_t hash(const char * text, uint32_t hash_value)
+    {
+        return *text ? hash(text + 1, mix(hash_value, *text)) : hash_value;
+    }
+
+    static constexpr uint32_t nonzero(uint32_t token)
+    {
+        return token ? token : 1;
+    }
+
+    static constexpr uint32_t make(const char * path, uint16_t line)
+    {
+        return nonzero(mix(mix(hash(path + LogSource::basename_offset(path), OFFSET), line & 0xFF), line >> 8));
+    }
+};
+
+#define LOG_TOKEN(_file, _line) LogToken::make(_file, _line)
+
+// Records of a token, sent as frames:
+//
+// | 0x7E | length, uint8 | token, uint32 LE | arguments | checksum |
+//
+// The length counts the token and the arguments. The checksum makes the sum of all bytes from the
+// length on 0 mod 256, so the host finds the frames again after noise or text printed around them.
+// The arguments are the bytes of LogArgs as the node has them, ints and pointers of 2 bytes,
+// longs and doubles of 4 on AVR.
+template <uint16_t SIZE>
+class LogTokens : public LogQueue<SIZE>
+{
+public:
+    static const uint8_t FRAME_START = 0x7E;
+    static const uint8_t FRAME_OVERHEAD = 3;
+    static const uint32_t DROPPED = 0;
+    static const uint8_t FRAME_SIZE_MAX = FRAME_OVERHEAD + sizeof(uint32_t) + LOG_ARGS_MAX;
+
+    template <typename... Args>
+    bool push(uint32_t token, Args... args)
+    {
+        return this->push_record(token, args...);
+    }
+
+    // Prints the frame of the oldest record to `sink`, from its byte `from` on and at most `room`
+    // bytes, the same way as LogRing::print. Dropped records are reported first.
+    template <typename SINK>
+    uint16_t print(SINK & sink, uint16_t room, uint16_t & from)
+    {
+        uint32_t token = DROPPED;
+        LogArgs values;
+        uint16_t dropped = this->get_report(from == 0);
+        if (dropped) {
+            values.data[values.size++] = dropped & 0xFF;
+            values.data[values.size++] = dropped >> 8;
+        }
+        else if (!this->peek_record(token, values)) {
+            return 0;
+        }
+
+        uint8_t header[2 + sizeof(token)] = {FRAME_START, (uint8_t)(sizeof(token) + values.size)};
+        for (uint8_t i = 0; i < sizeof(token); i++) {
+            header[2 + i] = token >> (8 * i);
+        }
+        uint8_t sum = 0;
+        for (uint8_t i = 1; i < sizeof(header); i++) {
+            sum += header[i];
+        }
+        for (uint8_t i = 0; i < values.size; i++) {
+            sum += values.data[i];
+        }
+
+        LogOutput<SINK> out(sink, from, room);
+        for (uint8_t i = 0; i < sizeof(header); i++) {
+            out.put(header[i]);
+        }
+        for (uint8_t i = 0; i < values.size; i++) {
+            out.put(values.data[i]);
+        }
+        out.put((uint8_t)(0 - sum));
+
+        if (!out.is_cut()) {
+            if (dropped) {
+                this->end_report();
+            }
+            else {
+                this->drop_record(token, values);
+            }
+        }
+        return out.advance(from);
+    }
+};
+
+#endif //ARDUINO_LOGTOKENS_H
@@ -1,15 +1,26 @@
 #include "Logging.h"
 
-#include <string.h>
+#ifdef LOGGING_TOKENIZED
+LogTokens<LOGGING_BUFFER_SIZE> log_ring;
+#else
+LogRing<LOGGING_BUFFER_SIZE> log_ring;
+#endif
 
-void log(const __FlashStringHelper *fmt, ...)
+// How far the oldest record has been printed, it's printed straight from the ring
+static uint16_t line_position = 0;
+
+void logging_process()
 {
-    static char buf[128];
+    int room = Serial.availableForWrite();
+    if (room > 0) {
+        log_ring.print(Serial, room, line_position);
+    }
+}
 
-    va_list args;
-    va_start (args, fmt);
-    vsnprintf_P(buf, sizeof(buf), (const char *)fmt, args); // progmem for AVR
-    va_end(args);
-    Serial.println(buf);
+void logging_flush()
+{
+    while (!log_ring.is_empty()) {
+        logging_process();
+    }
     Serial.flush();
 }
@@ -3,15 +3,90 @@
 
 #include <Arduino.h>
 
-void log(const __FlashStringHelper *fmt, ...);
+#include "LogRing.h"
+#include "LogSource.h"
+#include "LogTokens.h"
 
-#define __FILENAME__ (strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__)
+// The LOG_* calls only queue a record, formatting and printing are left to LOGGING_PROCESS, which
+// the sketch calls in its loop. It prints as much as fits in the serial buffer and never waits.
+//
+// With LOGGING_TOKENIZED the format strings are left out of the firmware, a record is sent as the
+// token of its call and binary arguments, see LogTokens.h. Read such a port with
+// `logtokens.py table <sources> -o tokens.json` and `logtokens.py decode tokens.json <port>`.
+//
+// Calls below LOG_LEVEL are left out at compile time, arguments included, so they must have no
+// side effects. A file sets its own level by defining LOG_LEVEL before including Logging.h:
+//
+//     #define LOG_LEVEL LOG_LEVEL_INFO
+//     #include <Logging.h>
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE  4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#ifndef LOGGING_BUFFER_SIZE
+#define LOGGING_BUFFER_SIZE 128
+#endif
+
+#ifdef LOGGING_TOKENIZED
+extern LogTokens<LOGGING_BUFFER_SIZE> log_ring;
+
+template <uint32_t TOKEN, typename... Args>
+void log_token(Args... args)
+{
+    log_ring.push(TOKEN, args...);
+}
+#else
+extern LogRing<LOGGING_BUFFER_SIZE> log_ring;
+
+template <typename... Args>
+void log(const __FlashStringHelper * fmt, const char * file, uint16_t line, Args... args)
+{
+    log_ring.push((const char *)fmt, file, line, args...);
+}
+#endif
+
+void logging_process();
+// Prints everything queued, waiting for the serial port. For the time before a sleep or a reset.
+void logging_flush();
+
+#define __FILENAME__ LOG_BASENAME(__FILE__)
 
 #define LOGGING_SETUP(_speed) Serial.begin(_speed)
-#define LOG_DEBUG(_msg, ...) log(F("[DEBUG] " _msg " [%s:%d]") , ##__VA_ARGS__, __FILENAME__, __LINE__);
-#define LOG_INFO(_msg, ...)  log(F("[INFO]  " _msg " [%s:%d]") , ##__VA_ARGS__, __FILENAME__, __LINE__);
-#define LOG_WARN(_msg, ...)  log(F("[WARN] " _msg " [%s:%d]") , ##__VA_ARGS__, __FILENAME__, __LINE__);
-#define LOG_ERROR(_msg, ...) log(F("[ERROR] " _msg " [%s:%d]") , ##__VA_ARGS__, __FILENAME__, __LINE__);
+#define LOGGING_PROCESS() logging_process()
+#define LOGGING_FLUSH() logging_flush()
 
-#endif // _LOGGING_
+#ifdef LOGGING_TOKENIZED
+// The level and the format are looked up by the token
+#define LOG_CALL(_level, _msg, ...) log_token<LOG_TOKEN(__FILE__, __LINE__)>(__VA_ARGS__);
+#else
+#define LOG_CALL(_level, _msg, ...) log(F(_level _msg), __FILENAME__, __LINE__, ##__VA_ARGS__);
+#endif
 
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(_msg, ...) LOG_CALL("[DEBUG] ", _msg, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(_msg, ...)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(_msg, ...)  LOG_CALL("[INFO]  ", _msg, ##__VA_ARGS__)
+#else
+#define LOG_INFO(_msg, ...)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(_msg, ...)  LOG_CALL("[WARN] ", _msg, ##__VA_ARGS__)
+#else
+#define LOG_WARN(_msg, ...)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(_msg, ...) LOG_CALL("[ERROR] ", _msg, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(_msg, ...)
+#endif
+
+#endif // _LOGGING_
@@ -0,0 +1,291 @@
+#!/usr/bin/env python3
+"""Host side of the tokenized logging, see LogTokens.h.
+
+    logtokens.py table SOURCES... -o tokens.json
+        Collects the LOG_* calls of the sources into a table of tokens. Run it on the sources the
+        node was built of, the tokens go with the file names and the lines.
+
+    logtokens.py decode tokens.json [INPUT]
+        Prints the log of a serial port, or a file, `-` for stdin. Bytes out of frames are printed
+        as they are, so text written next to the log is kept.
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+FNV_OFFSET = 2166136261
+FNV_PRIME = 16777619
+
+FRAME_START = 0x7E
+DROPPED = 0
+
+LEVELS = {
+    'DEBUG': '[DEBUG] ',
+    'INFO': '[INFO]  ',
+    'WARN': '[WARN] ',
+    'ERROR': '[ERROR] ',
+}
+
+SOURCE_EXTENSIONS = ('.ino', '.cpp', '.h')
+
+CALL = re.compile(r'\bLOG_(DEBUG|INFO|WARN|ERROR)\s*\(')
+LITERAL = re.compile(r'\s*"((?:[^"\\]|\\.)*)"')
+CONVERSION = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l)?([diouxXcspfeEgG%])')
+ESCAPES = {'n': '\n', 'r': '\r', 't': '\t', '\\': '\\', '"': '"', "'": "'", '0': '\0'}
+
+
+def mix(value, byte):
+    return ((value ^ byte) * FNV_PRIME) & 0xFFFFFFFF
+
+
+def make_token(path, line):
+    value = FNV_OFFSET
+    for byte in os.path.basename(path.replace('\\', '/')).encode():
+        value = mix(value, byte)
+    value = mix(mix(value, line & 0xFF), (line >> 8) & 0xFF)
+    return value or 1
+
+
+def unescape(text):
+    return re.sub(r'\\(.)', lambda match: ESCAPES.get(match.group(1), match.group(1)), text)
+
+
+def find_close(text, position):
+    """Position of the parenthesis closing the call opened before `position`."""
+    depth = 1
+    quote = None
+    while position < len(text):
+        c = text[position]
+        if quote:
+            if c == '\\':
+                position += 1
+            elif c == quote:
+                quote = None
+        elif c in '"\'':
+            quote = c
+        elif c == '(':
+            depth += 1
+        elif c == ')':
+            depth -= 1
+            if depth == 0:
+                return position
+        position += 1
+    return position
+
+
+def scan_file(path):
+    with open(path, encoding='utf-8', errors='replace') as source:
+        text = source.read()
+
+    for call in CALL.finditer(text):
+        position = call.end()
+        parts = []
+        while True:
+            literal = LITERAL.match(text, position)
+            if not literal:
+                break
+            parts.append(unescape(literal.group(1)))
+            position = literal.end()
+        if not parts:
+            # The macro definitions and calls with a format that isn't a literal
+            continue
+
+        # The compilers differ in the __LINE__ of a call over several lines, the first or the last
+        first = text.count('\n', 0, call.start()) + 1
+        last = first + text.count('\n', call.start(), find_close(text, call.end()))
+        for line in sorted({first, last}):
+            yield {
+                'token': make_token(path, line),
+                'format': LEVELS[call.group(1)] + ''.join(parts),
+                'file': os.path.basename(path),
+                'line': first,
+            }
+
+
+def scan(paths):
+    for path in paths:
+        if os.path.isfile(path):
+            yield from scan_file(path)
+            continue
+        for directory, _, files in os.walk(path):
+            for name in sorted(files):
+                if name.endswith(SOURCE_EXTENSIONS):
+                    yield from scan_file(os.path.join(directory, name))
+
+
+def command_table(args):
+    table = {}
+    failed = False
+    for site in scan(args.sources):
+        known = table.get(site['token'])
+        if known and (known['file'], known['line']) != (site['file'], site['line']):
+            print('Token %08x of %s:%d is taken by %s:%d, rename or move one of the calls'
+                  % (site['token'], site['file'], site['line'], known['file'], known['line']), file=sys.stderr)
+            failed = True
+        table[site['token']] = site
+
+    tokens = {'%08x' % token: site for token, site in sorted(table.items())}
+    with open(args.output, 'w') as output:
+        json.dump(tokens, output, indent=1, sort_keys=True)
+    print('%d log calls' % len({(site['file'], site['line']) for site in table.values()}), file=sys.stderr)
+    return 1 if failed else 0
+
+
+class Arguments:
+    """Reads the arguments of a record the way LogArgs stored them."""
+
+    def __init__(self, data, sizes):
+        self.data = data
+        self.position = 0
+        self.sizes = sizes
+
+    def number(self, kind, signed):
+        return int.from_bytes(self.take(self.sizes[kind]), 'little', signed=signed)
+
+    def real(self):
+        size = self.sizes['double']
+        return struct.unpack('<f' if size == 4 else '<d', self.take(size))[0]
+
+    def string(self):
+        length = self.take(1)
+        return self.take(length[0] if length else 0).decode('latin-1')
+
+    def take(self, size):
+        if self.position + size > len(self.data):
+            raise ValueError('the arguments are short of the format')
+        value = self.data[self.position:self.position + size]
+        self.position += size
+        return value
+
+
+def format_record(pattern, data, sizes):
+    values = Arguments(data, sizes)
+
+    def conversion(match):
+        flags, width, precision, length, kind = match.groups()
+        if kind == '%':
+            return '%'
+        spec = '%' + flags
+        if width == '*':
+            spec += str(values.number('int', True))
+        elif width:
+            spec += width
+        if precision == '*':
+            spec += '.' + str(values.number('int', True))
+        elif precision is not None:
+            spec += '.' + precision
+
+        wide = 'long' if length and length.startswith('l') else 'int'
+        if kind == 's':
+            return (spec + 's') % values.string()
+        if kind == 'c':
+            return (spec + 'c') % chr(values.number('int', True) & 0xFF)
+        if kind == 'p':
+            return (spec + 'x') % values.number('pointer', False)
+        if kind in 'feEgG':
+            return (spec + kind) % values.real()
+        if kind in 'di':
+            return (spec + 'd') % values.number(wide, True)
+        if kind == 'u':
+            return (spec + 'd') % values.number(wide, False)
+        return (spec + kind) % values.number(wide, False)
+
+    return CONVERSION.sub(conversion, pattern)
+
+
+def decode(stream, table, sizes, output):
+    """Writes the text of the frames in `stream`, bytes out of frames are written as they are."""
+    pending = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        pending += chunk
+
+        while pending:
+            if pending[0] != FRAME_START:
+                output.write(pending[:1].decode('latin-1'))
+                del pending[0]
+                continue
+            if len(pending) < 2 or len(pending) < pending[1] + 3:
+                break
+
+            length = pending[1]
+            frame = pending[:length + 3]
+            if length < 4 or sum(frame[1:]) & 0xFF:
+                # Not a frame after all
+                output.write(pending[:1].decode('latin-1'))
+                del pending[0]
+                continue
+            del pending[:length + 3]
+
+            token = int.from_bytes(frame[2:6], 'little')
+            data = bytes(frame[6:-1])
+            output.write(describe(token, data, table, sizes) + '\r\n')
+        output.flush()
+
+
+def describe(token, data, table, sizes):
+    if token == DROPPED:
+        return '[WARN] Log dropped %d records' % int.from_bytes(data[:2], 'little')
+    site = table.get(token)
+    if not site:
+        return '[?] Unknown log token %08x, args %s' % (token, data.hex())
+    try:
+        text = format_record(site['format'], data, sizes)
+    except (ValueError, TypeError) as error:
+        text = '%s <%s, args %s>' % (site['format'], error, data.hex())
+    return '%s [%s:%d]' % (text, site['file'], site['line'])
+
+
+def open_input(name, baud):
+    if name == '-':
+        return sys.stdin.buffer
+    if os.path.isfile(name):
+        return open(name, 'rb')
+    import serial
+    return serial.Serial(name, baud)
+
+
+def command_decode(args):
+    with open(args.table) as tokens:
+        table = {int(token, 16): site for token, site in json.load(tokens).items()}
+    sizes = {'int': args.int_size, 'long': args.long_size, 'double': args.double_size,
+             'pointer': args.pointer_size}
+    try:
+        decode(open_input(args.input, args.baud), table, sizes, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    table = commands.add_parser('table', help='collect the tokens of the sources')
+    table.add_argument('sources', nargs='+', help='files or directories')
+    table.add_argument('-o', '--output', default='tokens.json')
+    table.set_defaults(run=command_table)
+
+    decode_parser = commands.add_parser('decode', help='print a tokenized log')
+    decode_parser.add_argument('table', help='table made by the table command')
+    decode_parser.add_argument('input', nargs='?', default='-', help='serial port, file or - for stdin')
+    decode_parser.add_argument('--baud', type=int, default=115200)
+    # The sizes of the node, AVR by default
+    decode_parser.add_argument('--int-size', type=int, default=2)
+    decode_parser.add_argument('--long-size', type=int, default=4)
+    decode_parser.add_argument('--double-size', type=int, default=4)
+    decode_parser.add_argument('--pointer-size', type=int, default=2)
+    decode_parser.set_defaults(run=command_decode)
+
+    args = parser.parse_args()
+    return args.run(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
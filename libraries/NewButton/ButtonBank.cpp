@@ -0,0 +1,187 @@
+#include "ButtonBank.h"
+
+#include <Arduino.h>
+#include <Logging.h>
+
+const uint8_t ButtonBank::TICK_MS;
+
+ButtonBank::ButtonBank(const uint8_t * pins, uint8_t count, unsigned int short_press_time,
+                       unsigned int long_press_time) :
+    m_pins{pins},
+    m_count{count},
+    m_short_press_time{short_press_time},
+    m_long_press_time{long_press_time},
+#if defined(__AVR__) && !defined(UNITTESTS)
+    m_ports{},
+    m_port_count{0},
+    m_port_index{},
+    m_masks{},
+#endif
+    m_last_tick{0},
+    m_state{0},
+    m_counter0{0xFFFF},
+    m_counter1{0xFFFF},
+    m_short{0},
+    m_long{0},
+    m_pressed_time{},
+    m_events{}
+{
+    if (m_count > BUTTON_BANK_MAX_BUTTONS) {
+        m_count = BUTTON_BANK_MAX_BUTTONS;
+    }
+}
+
+void ButtonBank::on_short_press(uint8_t button, on_event_t callback, void * user_data)
+{
+    if (button < m_count) {
+        m_events[button].set(ButtonEvents::SHORT_PRESS, callback, user_data);
+    }
+}
+
+void ButtonBank::on_long_press(uint8_t button, on_event_t callback, void * user_data)
+{
+    if (button < m_count) {
+        m_events[button].set(ButtonEvents::LONG_PRESS, callback, user_data);
+    }
+}
+
+void ButtonBank::on_short_release(uint8_t button, on_event_t callback, void * user_data)
+{
+    if (button < m_count) {
+        m_events[button].set(ButtonEvents::SHORT_RELEASE, callback, user_data);
+    }
+}
+
+void ButtonBank::on_long_release(uint8_t button, on_event_t callback, void * user_data)
+{
+    if (button < m_count) {
+        m_events[button].set(ButtonEvents::LONG_RELEASE, callback, user_data);
+    }
+}
+
+void ButtonBank::setup()
+{
+    for (uint8_t i = 0; i < m_count; i++) {
+        pinMode(m_pins[i], INPUT);
+
+#if defined(__AVR__) && !defined(UNITTESTS)
+        // The input registers to read on each tick, the buttons usually share one or two
+        volatile uint8_t * port = portInputRegister(digitalPinToPort(m_pins[i]));
+        uint8_t index = 0;
+        while (index < m_port_count && m_ports[index] != port) {
+            index++;
+        }
+        if (index == m_port_count) {
+            if (m_port_count == BUTTON_BANK_MAX_PORTS) {
+                // No room for another port, the button never reads as pressed
+                LOG_ERROR("Button %d is left out, the buttons take more than %d ports", m_pins[i], BUTTON_BANK_MAX_PORTS);
+                m_port_index[i] = 0;
+                m_masks[i] = 0;
+                continue;
+            }
+            m_ports[m_port_count++] = port;
+        }
+        m_port_index[i] = index;
+        m_masks[i] = digitalPinToBitMask(m_pins[i]);
+#endif
+    }
+}
+
+void ButtonBank::process()
+{
+    unsigned long now = millis();
+    if (now - m_last_tick < TICK_MS) {
+        return;
+    }
+    m_last_tick = now;
+
+    // Vertical counters, see the header. The counters of the buttons that agree with their state
+    // are kept at 3, the others count down and the state toggles when they wrap.
+    uint16_t changed = m_state ^ sample();
+    m_counter0 = ~(m_counter0 & changed);
+    m_counter1 = m_counter0 ^ (m_counter1 & changed);
+    changed &= m_counter0 & m_counter1;
+    m_state ^= changed;
+
+    if (changed) {
+        for (uint8_t i = 0; i < m_count; i++) {
+            uint16_t bit = (uint16_t)1 << i;
+            if (!(changed & bit)) {
+                continue;
+            }
+
+            if (m_state & bit) {
+                m_pressed_time[i] = now;
+            }
+            else if (m_long & bit) {
+                LOG_DEBUG("Button %d long release", m_pins[i]);
+                m_events[i].fire(ButtonEvents::LONG_RELEASE);
+            }
+            else if (m_short & bit) {
+                LOG_DEBUG("Button %d short release", m_pins[i]);
+                m_events[i].fire(ButtonEvents::SHORT_RELEASE);
+            }
+        }
+        m_short &= m_state;
+        m_long &= m_state;
+    }
+
+    if (m_state & ~m_long) {
+        update_holds(now);
+    }
+}
+
+uint16_t ButtonBank::get_pressed() const
+{
+    return m_state;
+}
+
+// Raw states of all buttons, from one read of each port
+uint16_t ButtonBank::sample()
+{
+    uint16_t raw = 0;
+
+#if defined(__AVR__) && !defined(UNITTESTS)
+    uint8_t ports[BUTTON_BANK_MAX_PORTS];
+    for (uint8_t i = 0; i < m_port_count; i++) {
+        ports[i] = *m_ports[i];
+    }
+    for (uint8_t i = 0; i < m_count; i++) {
+        if (ports[m_port_index[i]] & m_masks[i]) {
+            raw |= (uint16_t)1 << i;
+        }
+    }
+#else
+    for (uint8_t i = 0; i < m_count; i++) {
+        if (digitalRead(m_pins[i]) == HIGH) {
+            raw |= (uint16_t)1 << i;
+        }
+    }
+#endif
+
+    return raw;
+}
+
+// Press events of the held buttons that haven't reached the long press yet
+void ButtonBank::update_holds(unsigned long now)
+{
+    uint16_t held = m_state & ~m_long;
+    for (uint8_t i = 0; held; i++, held >>= 1) {
+        if (!(held & 1)) {
+            continue;
+        }
+
+        uint16_t bit = (uint16_t)1 << i;
+        unsigned long hold_time = now - m_pressed_time[i];
+        if (hold_time >= m_long_press_time) {
+            m_long |= bit;
+            LOG_DEBUG("Button %d long press", m_pins[i]);
+            m_events[i].fire(ButtonEvents::LONG_PRESS);
+        }
+        else if (hold_time >= m_short_press_time && !(m_short & bit)) {
+            m_short |= bit;
+            LOG_DEBUG("Button %d short press", m_pins[i]);
+            m_events[i].fire(ButtonEvents::SHORT_PRESS);
+        }
+    }
+}
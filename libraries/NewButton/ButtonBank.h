@@ -0,0 +1,75 @@
+#ifndef ARDUINO_BUTTONBANK_H
+#define ARDUINO_BUTTONBANK_H
+
+#include <stdint.h>
+
+#include "ButtonEvents.h"
+
+#ifndef BUTTON_BANK_MAX_BUTTONS
+#define BUTTON_BANK_MAX_BUTTONS     8       // up to 16
+#endif
+#define BUTTON_BANK_MAX_PORTS       4
+
+// A button is a bit of the 16-bit state and counter words
+static_assert(BUTTON_BANK_MAX_BUTTONS <= 16, "ButtonBank handles up to 16 buttons");
+
+// Many buttons polled as one. Every tick the input ports are read once and all the buttons are
+// debounced together with vertical counters: bit i of each counter word belongs to button i, so a
+// tick costs the same few word operations however many buttons there are. A button changes its
+// debounced state after 4 ticks in a row that disagree with it.
+//
+// The timing and events are the ones of NewButton, a button is HIGH while pressed.
+class ButtonBank
+{
+public:
+    typedef ButtonEvents::on_event_t on_event_t;
+
+    static const uint8_t TICK_MS = 5;
+
+    ButtonBank(const uint8_t * pins, uint8_t count,
+               unsigned int short_press_time = 40,
+               unsigned int long_press_time = 2000);
+
+    void on_short_press(uint8_t button, on_event_t callback, void * user_data = nullptr);
+    void on_long_press(uint8_t button, on_event_t callback, void * user_data = nullptr);
+    void on_short_release(uint8_t button, on_event_t callback, void * user_data = nullptr);
+    void on_long_release(uint8_t button, on_event_t callback, void * user_data = nullptr);
+
+    void setup();
+    void process();
+
+    // Debounced states, bit i is set while button i is pressed
+    uint16_t get_pressed() const;
+
+private:
+    uint16_t sample();
+    void update_holds(unsigned long now);
+
+    const uint8_t * m_pins;
+    uint8_t m_count;
+    unsigned int m_short_press_time;
+    unsigned int m_long_press_time;
+
+#if defined(__AVR__) && !defined(UNITTESTS)
+    volatile uint8_t * m_ports[BUTTON_BANK_MAX_PORTS];
+    uint8_t m_port_count;
+    uint8_t m_port_index[BUTTON_BANK_MAX_BUTTONS];
+    uint8_t m_masks[BUTTON_BANK_MAX_BUTTONS];
+#endif
+
+    unsigned long m_last_tick;
+
+    // Debouncing, a 2-bit counter per button
+    uint16_t m_state;
+    uint16_t m_counter0;
+    uint16_t m_counter1;
+
+    // Buttons held past the short and the long press time
+    uint16_t m_short;
+    uint16_t m_long;
+
+    unsigned long m_pressed_time[BUTTON_BANK_MAX_BUTTONS];
+    ButtonEvents m_events[BUTTON_BANK_MAX_BUTTONS];
+};
+
+#endif //ARDUINO_BUTTONBANK_H
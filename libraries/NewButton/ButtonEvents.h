@@ -0,0 +1,50 @@
+#ifndef ARDUINO_BUTTONEVENTS_H
+#define ARDUINO_BUTTONEVENTS_H
+
+// Callback table of one button, shared by NewButton and ButtonBank
+class ButtonEvents
+{
+public:
+    typedef void(* on_event_t)(void * user_data);
+
+    // A callback with its user data, also used by ButtonGestures
+    struct Callback {
+        on_event_t cb;
+        void * user_data;
+
+        void call() const
+        {
+            if (cb) {
+                cb(user_data);
+            }
+        }
+    };
+
+    enum Type {
+        SHORT_PRESS,
+        LONG_PRESS,
+        SHORT_RELEASE,
+        LONG_RELEASE,
+        SIZE
+    };
+
+    ButtonEvents() :
+        m_callbacks{}
+    {
+    }
+
+    void set(Type type, on_event_t callback, void * user_data)
+    {
+        m_callbacks[type] = {callback, user_data};
+    }
+
+    void fire(Type type) const
+    {
+        m_callbacks[type].call();
+    }
+
+private:
+    Callback m_callbacks[SIZE];
+};
+
+#endif //ARDUINO_BUTTONEVENTS_H
@@ -0,0 +1,147 @@
+#include "ButtonGestures.h"
+
+#include <Arduino.h>
+#include <Logging.h>
+
+const uint8_t ButtonGestures::DEBOUNCE_MS;
+
+ButtonGestures::ButtonGestures(uint8_t pin, unsigned int click_gap_time, unsigned int hold_time) :
+    m_pin{pin},
+    m_click_gap_time{click_gap_time},
+    m_hold_time{hold_time},
+    m_polling{true},
+    m_edges{},
+    m_head{0},
+    m_tail{0},
+    m_overflows{0},
+    m_raw{false},
+    m_raw_time{0},
+    m_pressed{false},
+    m_edge_time{0},
+    m_clicks{0},
+    m_holding{false},
+    m_callbacks{}
+{
+}
+
+void ButtonGestures::on_gesture(Gesture gesture, on_event_t callback, void * user_data)
+{
+    m_callbacks[gesture] = {callback, user_data};
+}
+
+void ButtonGestures::setup(void (* isr)())
+{
+    pinMode(m_pin, INPUT);
+    m_polling = !isr;
+    if (!isr) {
+        return;
+    }
+
+    int interrupt = digitalPinToInterrupt(m_pin);
+    if (interrupt != NOT_AN_INTERRUPT) {
+        attachInterrupt(interrupt, isr, CHANGE);
+    }
+    else {
+#if defined(__AVR__) && !defined(UNITTESTS)
+        *digitalPinToPCMSK(m_pin) |= _BV(digitalPinToPCMSKbit(m_pin));
+        PCICR |= _BV(digitalPinToPCICRbit(m_pin));
+#endif
+    }
+}
+
+void ButtonGestures::on_interrupt()
+{
+    on_edge(digitalRead(m_pin) == HIGH, millis());
+}
+
+void ButtonGestures::on_edge(bool pressed, unsigned long time)
+{
+    uint8_t head = m_head;
+    uint8_t next = (head + 1) & (BUTTON_GESTURES_EDGES - 1);
+    if (next == m_tail) {
+        m_overflows++;
+        return;
+    }
+
+    m_edges[head].time = time;
+    m_edges[head].pressed = pressed;
+    // Published only once the edge is written
+    m_head = next;
+}
+
+void ButtonGestures::process()
+{
+    if (m_polling) {
+        bool pressed = digitalRead(m_pin) == HIGH;
+        if (pressed != m_raw) {
+            on_edge(pressed, millis());
+        }
+    }
+
+    uint8_t tail = m_tail;
+    while (tail != m_head) {
+        unsigned long time = m_edges[tail].time;
+        bool pressed = m_edges[tail].pressed;
+        tail = (tail + 1) & (BUTTON_GESTURES_EDGES - 1);
+        m_tail = tail;
+
+        // Everything that timed out before this edge happened first
+        expire(time);
+
+        m_raw = pressed;
+        m_raw_time = time;
+        if (pressed != m_pressed && time - m_edge_time >= DEBOUNCE_MS) {
+            accept(pressed, time);
+        }
+    }
+
+    unsigned long now = millis();
+    // The level settled on a bounce ignored above
+    if (m_raw != m_pressed && now - m_edge_time >= DEBOUNCE_MS) {
+        expire(m_raw_time);
+        accept(m_raw, m_raw_time);
+    }
+    expire(now);
+}
+
+uint8_t ButtonGestures::get_overflows() const
+{
+    return m_overflows;
+}
+
+void ButtonGestures::accept(bool pressed, unsigned long time)
+{
+    m_pressed = pressed;
+    m_edge_time = time;
+    if (pressed) {
+        return;
+    }
+
+    if (m_holding) {
+        m_holding = false;
+        m_clicks = 0;
+        fire(HOLD_RELEASE);
+    }
+    else if (m_clicks < 0xFF) {
+        m_clicks++;
+    }
+}
+
+// Gestures completed by the time `time` with no further edges
+void ButtonGestures::expire(unsigned long time)
+{
+    if (m_pressed && !m_holding && time - m_edge_time >= m_hold_time) {
+        m_holding = true;
+        fire(m_clicks > 0 ? CLICK_HOLD : HOLD);
+    }
+    else if (!m_pressed && m_clicks > 0 && time - m_edge_time >= m_click_gap_time) {
+        fire(m_clicks == 1 ? CLICK : m_clicks == 2 ? DOUBLE_CLICK : TRIPLE_CLICK);
+        m_clicks = 0;
+    }
+}
+
+void ButtonGestures::fire(Gesture gesture)
+{
+    LOG_DEBUG("Button %d gesture %d", m_pin, gesture);
+    m_callbacks[gesture].call();
+}
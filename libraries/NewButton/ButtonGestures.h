@@ -0,0 +1,90 @@
+#ifndef ARDUINO_BUTTONGESTURES_H
+#define ARDUINO_BUTTONGESTURES_H
+
+#include <stdint.h>
+
+#include "ButtonEvents.h"
+
+#ifndef BUTTON_GESTURES_EDGES
+#define BUTTON_GESTURES_EDGES   8       // a power of 2
+#endif
+
+// Multi-click and click-and-hold recognition from timestamped edges.
+//
+// With an interrupt the edges are stamped when they happen and queued into a ring shared with
+// `process`: the interrupt only writes the head and `process` only writes the tail, so neither
+// blocks the other. The gestures are then decoded from the stamps, not from the time `process`
+// gets to run, so a loop stalled in a radio send or an EEPROM write still sees a double click.
+// Without an interrupt `process` polls the pin and stamps the edges itself.
+//
+// A button is HIGH while pressed. Edges closer than DEBOUNCE_MS to the previous one are bounces.
+class ButtonGestures
+{
+public:
+    typedef ButtonEvents::on_event_t on_event_t;
+
+    enum Gesture {
+        CLICK,
+        DOUBLE_CLICK,
+        TRIPLE_CLICK,   // or more clicks
+        HOLD,
+        CLICK_HOLD,     // clicks followed by a hold
+        HOLD_RELEASE,
+        SIZE
+    };
+
+    static const uint8_t DEBOUNCE_MS = 20;
+
+    ButtonGestures(uint8_t pin,
+                   unsigned int click_gap_time = 300,
+                   unsigned int hold_time = 800);
+
+    void on_gesture(Gesture gesture, on_event_t callback, void * user_data = nullptr);
+
+    // With `isr`, the edges come from an interrupt that calls `on_interrupt`. On a pin with an
+    // external interrupt `isr` is attached to it. Other pins get their pin change interrupt enabled
+    // instead; its vector is shared by the whole port, so the sketch defines ISR(PCINTn_vect) and
+    // calls `on_interrupt` of the buttons on that port from it. With no `isr` the pin is polled.
+    void setup(void (* isr)() = nullptr);
+    void on_interrupt();
+    // Queues an edge, safe in an interrupt
+    void on_edge(bool pressed, unsigned long time);
+
+    void process();
+
+    // Edges dropped because the ring was full
+    uint8_t get_overflows() const;
+
+private:
+    struct Edge {
+        unsigned long time;
+        bool pressed;
+    };
+
+    void accept(bool pressed, unsigned long time);
+    void expire(unsigned long time);
+    void fire(Gesture gesture);
+
+    uint8_t m_pin;
+    unsigned int m_click_gap_time;
+    unsigned int m_hold_time;
+    bool m_polling;
+
+    volatile Edge m_edges[BUTTON_GESTURES_EDGES];
+    volatile uint8_t m_head;
+    volatile uint8_t m_tail;
+    volatile uint8_t m_overflows;
+
+    // Level of the latest edge, accepted or not
+    bool m_raw;
+    unsigned long m_raw_time;
+
+    bool m_pressed;
+    unsigned long m_edge_time;
+    uint8_t m_clicks;
+    bool m_holding;
+
+    ButtonEvents::Callback m_callbacks[SIZE];
+};
+
+#endif //ARDUINO_BUTTONGESTURES_H
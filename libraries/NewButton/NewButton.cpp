@@ -1,6 +1,7 @@
 #include "NewButton.h"
 
 #include <Arduino.h>
+#include <Logging.h>
 
 NewButton::NewButton(unsigned int pin, unsigned int short_press_time, unsigned int long_press_time):
     m_pin{pin},
@@ -11,28 +12,28 @@ NewButton::NewButton(unsigned int pin, unsigned int short_press_time, unsigned i
     m_pressed_time{0},
     m_prev_press_status{Status::NONE},
     m_press_status{Status::NONE},
-    m_callbacks{}
+    m_events{}
 {
 }
 
 void NewButton::on_short_press(on_event_t callback, void * user_data)
 {
-    m_callbacks[EventType::SHORT_PRESS] = {callback, user_data};
+    m_events.set(ButtonEvents::SHORT_PRESS, callback, user_data);
 }
 
 void NewButton::on_long_press(on_event_t callback, void * user_data)
 {
-    m_callbacks[EventType::LONG_PRESS] = {callback, user_data};
+    m_events.set(ButtonEvents::LONG_PRESS, callback, user_data);
 }
 
 void NewButton::on_short_release(on_event_t callback, void * user_data)
 {
-    m_callbacks[EventType::SHORT_RELEASE] = {callback, user_data};
+    m_events.set(ButtonEvents::SHORT_RELEASE, callback, user_data);
 }
 
 void NewButton::on_long_release(on_event_t callback, void * user_data)
 {
-    m_callbacks[EventType::LONG_RELEASE] = {callback, user_data};
+    m_events.set(ButtonEvents::LONG_RELEASE, callback, user_data);
 }
 
 void NewButton::setup()
@@ -52,15 +53,11 @@ void NewButton::process()
         m_pressed_time = 0;
         if (m_press_status == Status::SHORT) {
             LOG_DEBUG("Button %d short release", m_pin);
-            if (m_callbacks[EventType::SHORT_RELEASE].cb) {
-                m_callbacks[EventType::SHORT_RELEASE].cb(m_callbacks[EventType::SHORT_RELEASE].user_data);
-            }
+            m_events.fire(ButtonEvents::SHORT_RELEASE);
         }
         if (m_press_status == Status::LONG) {
             LOG_DEBUG("Button %d long release", m_pin);
-            if (m_callbacks[EventType::LONG_RELEASE].cb) {
-                m_callbacks[EventType::LONG_RELEASE].cb(m_callbacks[EventType::LONG_RELEASE].user_data);
-            }
+            m_events.fire(ButtonEvents::LONG_RELEASE);
         }
         m_press_status = Status::NONE;
     }
@@ -78,15 +75,11 @@ void NewButton::process()
     if (m_prev_press_status != m_press_status) {
         LOG_DEBUG("Button %d short press", m_pin);
         if (m_press_status == Status::SHORT) {
-            if (m_callbacks[EventType::SHORT_PRESS].cb) {
-                m_callbacks[EventType::SHORT_PRESS].cb(m_callbacks[EventType::SHORT_PRESS].user_data);
-            }
+            m_events.fire(ButtonEvents::SHORT_PRESS);
         }
         if (m_press_status == Status::LONG) {
             LOG_DEBUG("Button %d long press", m_pin);
-            if (m_callbacks[EventType::LONG_PRESS].cb) {
-                m_callbacks[EventType::LONG_PRESS].cb(m_callbacks[EventType::LONG_PRESS].user_data);
-            }
+            m_events.fire(ButtonEvents::LONG_PRESS);
         }
     }
 
@@ -1,10 +1,12 @@
 #ifndef ARDUINO_NEWBUTTON_H
 #define ARDUINO_NEWBUTTON_H
 
+#include "ButtonEvents.h"
+
 class NewButton
 {
 public:
-    typedef void(* on_event_t)(void * user_data);
+    typedef ButtonEvents::on_event_t on_event_t;
 
     NewButton(unsigned int pin,
               unsigned int short_press_time = 40,
@@ -25,19 +27,6 @@ private:
         LONG,
     };
 
-    enum EventType {
-        SHORT_PRESS,
-        LONG_PRESS,
-        SHORT_RELEASE,
-        LONG_RELEASE,
-        SIZE
-    };
-
-    struct Callback {
-        on_event_t cb;
-        void * user_data;
-    };
-
     unsigned int m_pin;
     unsigned int m_short_press_time;
     unsigned int m_long_press_time;
@@ -47,7 +36,7 @@ private:
     Status m_prev_press_status;
     Status m_press_status;
 
-    Callback m_callbacks[EventType::SIZE];
+    ButtonEvents m_events;
 };
 
 #endif //ARDUINO_NEWBUTTON_H
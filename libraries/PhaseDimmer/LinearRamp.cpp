@@ -0,0 +1,69 @@
+#include "LinearRamp.h"
+
+LinearRamp::LinearRamp() :
+    m_from{0},
+    m_to{0},
+    m_value{0},
+    m_start{0},
+    m_duration{0}
+{
+}
+
+void LinearRamp::start(int16_t from, int16_t to, unsigned long duration, unsigned long now)
+{
+    m_from = from;
+    m_to = to;
+    m_value = from;
+    m_start = now;
+    m_duration = duration;
+    if (from == to || duration == 0) {
+        jump(to);
+    }
+}
+
+void LinearRamp::jump(int16_t value)
+{
+    m_from = value;
+    m_to = value;
+    m_value = value;
+    m_duration = 0;
+}
+
+int16_t LinearRamp::update(unsigned long now)
+{
+    if (m_duration == 0) {
+        return m_value;
+    }
+
+    unsigned long elapsed = now - m_start;
+    if (elapsed >= m_duration) {
+        jump(m_to);
+        return m_value;
+    }
+
+    // Scale the time down to 15 bits, so the 17 bits delta times it fits int32_t
+    unsigned long duration = m_duration;
+    while (duration > 0x7FFF) {
+        duration >>= 1;
+        elapsed >>= 1;
+    }
+
+    int32_t delta = (int32_t)m_to - m_from;
+    m_value = m_from + (int16_t)(delta * (int32_t)elapsed / (int32_t)duration);
+    return m_value;
+}
+
+bool LinearRamp::is_running() const
+{
+    return m_duration > 0;
+}
+
+int16_t LinearRamp::get_value() const
+{
+    return m_value;
+}
+
+int16_t LinearRamp::get_target() const
+{
+    return m_to;
+}
@@ -0,0 +1,33 @@
+#ifndef ARDUINO_LINEARRAMP_H
+#define ARDUINO_LINEARRAMP_H
+
+#include <stdint.h>
+
+// Straight move between two values over a time, computed from the time elapsed since the start
+// rather than stepped: a late call lands where the ramp should be by then, so stalls of the loop
+// don't stretch it. Values are limited to int16_t, durations are any ms.
+class LinearRamp
+{
+public:
+    LinearRamp();
+
+    void start(int16_t from, int16_t to, unsigned long duration, unsigned long now);
+    // Stops at the value
+    void jump(int16_t value);
+
+    // Value at `now`, the ramp ends once its time is over
+    int16_t update(unsigned long now);
+
+    bool is_running() const;
+    int16_t get_value() const;
+    int16_t get_target() const;
+
+private:
+    int16_t m_from;
+    int16_t m_to;
+    int16_t m_value;
+    unsigned long m_start;
+    unsigned long m_duration;
+};
+
+#endif //ARDUINO_LINEARRAMP_H
@@ -0,0 +1,37 @@
+#include "PhaseCurve.h"
+#include "PhaseDimmer.h"
+
+const unsigned int PhaseCurve::GUARD_US;
+
+PhaseCurve::PhaseCurve(const uint16_t * table, uint16_t steps) :
+    m_table{table},
+    m_steps{steps}
+{
+}
+
+unsigned int PhaseCurve::get_delay(uint16_t position, unsigned int half_period) const
+{
+    uint16_t level = position >> 8;
+    if (level >= m_steps) {
+        return PhaseDimmer::OFF;
+    }
+
+    uint16_t from = get_entry(level);
+    uint16_t to = get_entry(level + 1);
+    uint16_t fraction = from + (uint16_t)((uint32_t)(to - from) * (position & 0xFF) >> 8);
+    unsigned int delay = (uint32_t)fraction * half_period >> 16;
+
+    // The dimmest levels would fire right at the next zero cross, late enough to miss it once shifted
+    unsigned int latest = half_period > GUARD_US ? half_period - GUARD_US : 0;
+    return delay < latest ? delay : latest;
+}
+
+uint16_t PhaseCurve::get_entry(uint16_t level) const
+{
+    return pgm_read_word(&m_table[level]);
+}
+
+uint16_t PhaseCurve::get_steps() const
+{
+    return m_steps;
+}
@@ -0,0 +1,150 @@
+#ifndef ARDUINO_PHASECURVE_H
+#define ARDUINO_PHASECURVE_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// Maps a dimmer level to the firing delay of a triac.
+//
+// A lamp gets the power of the part of the half-cycle after the firing, which goes with the sine
+// integral over it: P(a) = 1 - a/pi + sin(2a)/(2pi) for a firing angle `a`. So firing delays
+// linear in the level leave the ends of the range flat and put most of the change in the middle.
+// The tables are generated at compile time into flash:
+//  - PHASE_CURVE_LINEAR, the delay is linear in the level
+//  - PHASE_CURVE_POWER, the power is linear in the level
+//  - PHASE_CURVE_CIE, the lightness (CIE 1976 L*) is linear in the level, the power is its luminance
+//
+// Levels go from 0, full power, to `steps`, off. A table holds steps + 1 delays as a fraction of
+// the half-cycle in 1/65536.
+enum PhaseCurveKind
+{
+    PHASE_CURVE_LINEAR,
+    PHASE_CURVE_POWER,
+    PHASE_CURVE_CIE,
+};
+
+// C++11 constexpr, so every function is a single expression. Angles are in radians, HALF_TURN
+// instead of PI, as Arduino.h defines that as a macro.
+struct PhaseCurveMath
+{
+    static constexpr double HALF_TURN = 3.14159265358979323846;
+    static constexpr uint8_t BISECTIONS = 24;
+
+    static constexpr double sin_series(double x2, double term, uint8_t n)
+    {
+        // term is x^(2n-1)/(2n-1)!, the rest is below the double precision after 12 terms
+        return n > 12 ? term : term + sin_series(x2, -term * x2 / ((2 * n) * (2 * n + 1)), n + 1);
+    }
+
+    // sin(x) for x in [0, 2pi]
+    static constexpr double sin(double x)
+    {
+        return x > HALF_TURN ? -sin(x - HALF_TURN) :
+               x > HALF_TURN / 2 ? sin(HALF_TURN - x) :
+               sin_series(x * x, x, 1);
+    }
+
+    // Part of the full power delivered when firing at the angle in [0, pi]
+    static constexpr double power(double firing)
+    {
+        return 1 - firing / HALF_TURN + sin(2 * firing) / (2 * HALF_TURN);
+    }
+
+    // Firing angle for the part of the full power, the power goes down with the angle
+    static constexpr double angle(double part, double low = 0, double high = HALF_TURN, uint8_t depth = BISECTIONS)
+    {
+        return depth == 0 ? (low + high) / 2 :
+               power((low + high) / 2) > part ? angle(part, (low + high) / 2, high, depth - 1) :
+               angle(part, low, (low + high) / 2, depth - 1);
+    }
+
+    // Relative luminance of the CIE 1976 lightness in [0, 100]
+    static constexpr double luminance(double lightness)
+    {
+        return lightness <= 8 ? lightness / 903.3 :
+               (lightness + 16) / 116 * ((lightness + 16) / 116) * ((lightness + 16) / 116);
+    }
+
+    // Firing delay as a fraction of the half-cycle, for the brightness in [0, 1]
+    static constexpr double delay(PhaseCurveKind kind, double brightness)
+    {
+        return kind == PHASE_CURVE_LINEAR ? 1 - brightness :
+               kind == PHASE_CURVE_POWER ? angle(brightness) / HALF_TURN :
+               angle(luminance(brightness * 100)) / HALF_TURN;
+    }
+
+    static constexpr uint16_t fixed(double fraction)
+    {
+        return fraction * 65536 + 0.5 >= 0xFFFF ? 0xFFFF : (uint16_t)(fraction * 65536 + 0.5);
+    }
+
+    static constexpr uint16_t entry(PhaseCurveKind kind, uint16_t level, uint16_t steps)
+    {
+        return level == 0 ? 0 :
+               level == steps ? 0xFFFF :
+               fixed(delay(kind, (double)(steps - level) / steps));
+    }
+};
+
+template <uint16_t... LEVELS>
+struct PhaseCurveLevels
+{
+};
+
+// PhaseCurveLevels<0, 1, ... COUNT - 1>
+template <uint16_t COUNT, uint16_t... LEVELS>
+struct PhaseCurveSequence : PhaseCurveSequence<COUNT - 1, COUNT - 1, LEVELS...>
+{
+};
+
+template <uint16_t... LEVELS>
+struct PhaseCurveSequence<0, LEVELS...>
+{
+    typedef PhaseCurveLevels<LEVELS...> type;
+};
+
+template <PhaseCurveKind KIND, uint16_t STEPS, typename = typename PhaseCurveSequence<STEPS + 1>::type>
+struct PhaseCurveTable;
+
+template <PhaseCurveKind KIND, uint16_t STEPS, uint16_t... LEVELS>
+struct PhaseCurveTable<KIND, STEPS, PhaseCurveLevels<LEVELS...>>
+{
+    static const uint16_t values[STEPS + 1];
+};
+
+template <PhaseCurveKind KIND, uint16_t STEPS, uint16_t... LEVELS>
+const uint16_t PhaseCurveTable<KIND, STEPS, PhaseCurveLevels<LEVELS...>>::values[STEPS + 1] PROGMEM = {
+    PhaseCurveMath::entry(KIND, LEVELS, STEPS)...
+};
+
+// A table picked for an output. Each output of a sketch can use its own.
+class PhaseCurve
+{
+public:
+    // The latest firing is this much before the next zero cross. It covers the largest shift
+    // ZeroCrossTracker puts on a half-cycle, 3/4 of its window (~470 us at 50 Hz), plus a gate
+    // pulse long enough for the triac to latch.
+    static const unsigned int GUARD_US = 600;
+
+    PhaseCurve(const uint16_t * table, uint16_t steps);
+
+    template <PhaseCurveKind KIND, uint16_t STEPS>
+    static PhaseCurve make()
+    {
+        return PhaseCurve(PhaseCurveTable<KIND, STEPS>::values, STEPS);
+    }
+
+    // Delay in microseconds for a level in 1/256 steps, interpolated between the table entries
+    // and at most `half_period` - GUARD_US, or PhaseDimmer::OFF from `steps` on
+    unsigned int get_delay(uint16_t position, unsigned int half_period) const;
+
+    // Table entry, for checks
+    uint16_t get_entry(uint16_t level) const;
+    uint16_t get_steps() const;
+
+private:
+    const uint16_t * m_table;
+    uint16_t m_steps;
+};
+
+#endif //ARDUINO_PHASECURVE_H
@@ -0,0 +1,127 @@
+#include "PhaseDimmer.h"
+
+#include <Arduino.h>
+
+#if defined(__AVR__) && !defined(UNITTESTS)
+#include <util/atomic.h>
+#define PHASE_DIMMER_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define PHASE_DIMMER_ATOMIC
+#endif
+
+const unsigned int PhaseDimmer::OFF;
+const unsigned int PhaseDimmer::MIN_STEP_US;
+
+PhaseDimmer::PhaseDimmer(const FastPinHandle * gates, uint8_t channels, TimerService & timers) :
+    m_gates{gates},
+    m_channels{channels},
+    m_timers{timers},
+    m_timer{TimerService::NONE},
+    m_delays{},
+    m_schedule{},
+    m_count{0},
+    m_position{0},
+    m_elapsed{0}
+{
+    if (m_channels > PHASE_DIMMER_MAX_CHANNELS) {
+        m_channels = PHASE_DIMMER_MAX_CHANNELS;
+    }
+    for (uint8_t i = 0; i < m_channels; i++) {
+        m_delays[i] = OFF;
+    }
+}
+
+void PhaseDimmer::setup()
+{
+    for (uint8_t i = 0; i < m_channels; i++) {
+        pinMode(m_gates[i].pin, OUTPUT);
+    }
+
+    if (m_timer == TimerService::NONE) {
+        m_timer = m_timers.add(on_timer, this, TimerService::IN_ISR);
+    }
+}
+
+void PhaseDimmer::set_delay(uint8_t channel, unsigned int delay)
+{
+    if (channel >= m_channels) {
+        return;
+    }
+
+    PHASE_DIMMER_ATOMIC {
+        m_delays[channel] = delay;
+    }
+}
+
+unsigned int PhaseDimmer::get_delay(uint8_t channel) const
+{
+    if (channel >= m_channels) {
+        return OFF;
+    }
+
+    unsigned int delay;
+    PHASE_DIMMER_ATOMIC {
+        delay = m_delays[channel];
+    }
+    return delay;
+}
+
+void PhaseDimmer::on_zero_cross(int shift)
+{
+    m_timers.disarm(m_timer);
+
+    // Insertion sort, there are just a few channels
+    m_count = 0;
+    for (uint8_t channel = 0; channel < m_channels; channel++) {
+        m_gates[channel].write(LOW);
+
+        unsigned int delay = m_delays[channel];
+        if (delay == OFF) {
+            continue;
+        }
+        if (shift < 0 && delay < (unsigned int)-shift) {
+            delay = 0;
+        }
+        else {
+            delay += shift;
+        }
+
+        uint8_t i = m_count++;
+        while (i > 0 && m_schedule[i - 1].time > delay) {
+            m_schedule[i] = m_schedule[i - 1];
+            i--;
+        }
+        m_schedule[i] = Event{delay, channel};
+    }
+
+    m_position = 0;
+    m_elapsed = 0;
+    fire_due();
+}
+
+void PhaseDimmer::on_timer()
+{
+    fire_due();
+}
+
+void PhaseDimmer::on_timer(void * dimmer)
+{
+    static_cast<PhaseDimmer *>(dimmer)->on_timer();
+}
+
+// Fires the events that are due and arms the timer for the next one
+void PhaseDimmer::fire_due()
+{
+    while (m_position < m_count) {
+        const Event & event = m_schedule[m_position];
+        if (event.time - m_elapsed >= MIN_STEP_US) {
+            unsigned int delay = event.time - m_elapsed;
+            m_elapsed = event.time;
+            m_timers.arm(m_timer, delay);
+            return;
+        }
+
+        m_gates[event.channel].write(HIGH);
+        m_position++;
+    }
+}
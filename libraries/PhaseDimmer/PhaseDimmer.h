@@ -0,0 +1,64 @@
+#ifndef ARDUINO_PHASEDIMMER_H
+#define ARDUINO_PHASEDIMMER_H
+
+#include <stdint.h>
+#include <FastPin.h>
+#include <TimerService.h>
+
+#define PHASE_DIMMER_MAX_CHANNELS   4
+
+// Phase-angle control of several triacs from one zero cross input and an IN_ISR timer of
+// TimerService.
+//
+// The zero cross interrupt sorts the firing times of the channels into a schedule, and the
+// timer is armed as a one-shot for each distinct time in turn. So a half-cycle costs one
+// interrupt plus one per distinct firing time, however many channels there are. Gates stay on
+// till the next zero cross.
+//
+// The sketch attaches the zero cross interrupt and forwards it to `on_zero_cross`, the timer calls
+// `on_timer`. The gates are given as FastPin handles, so the interrupts don't go through
+// digitalWrite.
+class PhaseDimmer
+{
+public:
+    static const unsigned int OFF = 0xFFFF;
+    // Firing times closer than this to the previous event are served by the same interrupt
+    static const unsigned int MIN_STEP_US = 20;
+
+    PhaseDimmer(const FastPinHandle * gates, uint8_t channels, TimerService & timers);
+
+    void setup();
+
+    // Delay from the zero cross to firing, in microseconds, or OFF. Applies from the next half-cycle.
+    void set_delay(uint8_t channel, unsigned int delay);
+    unsigned int get_delay(uint8_t channel) const;
+
+    // `shift` moves the firing times of this half-cycle, to measure them from a filtered crossing
+    // instead of the edge that raised the interrupt, see ZeroCrossTracker
+    void on_zero_cross(int shift = 0);
+    void on_timer();
+
+private:
+    struct Event {
+        unsigned int time;
+        uint8_t channel;
+    };
+
+    static void on_timer(void * dimmer);
+    void fire_due();
+
+    const FastPinHandle * m_gates;
+    uint8_t m_channels;
+    TimerService & m_timers;
+    TimerService::id_t m_timer;
+
+    volatile unsigned int m_delays[PHASE_DIMMER_MAX_CHANNELS];
+
+    // Schedule of the current half-cycle, owned by the interrupts
+    Event m_schedule[PHASE_DIMMER_MAX_CHANNELS];
+    uint8_t m_count;
+    uint8_t m_position;
+    unsigned int m_elapsed;
+};
+
+#endif //ARDUINO_PHASEDIMMER_H
@@ -0,0 +1,220 @@
+#include "ZeroCrossTracker.h"
+
+#include <Arduino.h>
+
+#if defined(__AVR__) && !defined(UNITTESTS)
+#include <util/atomic.h>
+#define ZERO_CROSS_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define ZERO_CROSS_ATOMIC
+#endif
+
+const unsigned int ZeroCrossTracker::HALF_PERIOD_50HZ;
+const unsigned int ZeroCrossTracker::HALF_PERIOD_60HZ;
+const uint8_t ZeroCrossTracker::LOCK_EDGES;
+const uint8_t ZeroCrossTracker::MAX_MISSED;
+const uint8_t ZeroCrossTracker::MAX_REJECTED;
+
+// Half-cycles within 1/8 of a nominal one count while acquiring, shorter ones are glitches
+#define ACQUIRE_TOLERANCE(_period)  ((_period) >> 3)
+// Edges within 1/16 of a half-cycle of the prediction are taken once locked
+#define TRACK_WINDOW(_period)       ((_period) >> 4)
+// The period may drift 1/32 off the nominal one
+#define PERIOD_RANGE(_period)       ((_period) >> 5)
+
+static bool is_near(unsigned long interval, unsigned int period, unsigned int tolerance)
+{
+    return interval + tolerance >= period && interval <= (unsigned long)period + tolerance;
+}
+
+ZeroCrossTracker::ZeroCrossTracker()
+{
+    reset();
+}
+
+void ZeroCrossTracker::reset()
+{
+    // Also run by the constructor, before the interrupts are enabled, so they're restored as found
+    ZERO_CROSS_ATOMIC {
+        m_locked = false;
+        m_nominal = 0;
+        m_period = HALF_PERIOD_50HZ;
+        m_crossing = 0;
+        m_shift = 0;
+        m_started = false;
+        m_matches = 0;
+        m_rejected_row = 0;
+        m_accepted = 0;
+        m_rejected = 0;
+    }
+}
+
+bool ZeroCrossTracker::on_edge(unsigned long now)
+{
+    if (m_locked) {
+        return track(now);
+    }
+
+    if (m_started && now - m_crossing < HALF_PERIOD_60HZ - ACQUIRE_TOLERANCE(HALF_PERIOD_60HZ)) {
+        m_rejected++;
+        return false;
+    }
+    acquire(now);
+    m_accepted++;
+    return true;
+}
+
+void ZeroCrossTracker::acquire(unsigned long now)
+{
+    unsigned long interval = now - m_crossing;
+    unsigned int nominal = 0;
+    if (!m_started) {
+        m_started = true;
+    }
+    else if (is_near(interval, HALF_PERIOD_50HZ, ACQUIRE_TOLERANCE(HALF_PERIOD_50HZ))) {
+        nominal = HALF_PERIOD_50HZ;
+    }
+    else if (is_near(interval, HALF_PERIOD_60HZ, ACQUIRE_TOLERANCE(HALF_PERIOD_60HZ))) {
+        nominal = HALF_PERIOD_60HZ;
+    }
+
+    m_crossing = now;
+    m_shift = 0;
+    if (nominal == 0 || nominal != m_nominal) {
+        m_nominal = nominal;
+        m_matches = nominal ? 1 : 0;
+        return;
+    }
+
+    if (++m_matches >= LOCK_EDGES) {
+        m_locked = true;
+        m_period = nominal;
+        m_rejected_row = 0;
+    }
+}
+
+bool ZeroCrossTracker::track(unsigned long now)
+{
+    unsigned int window = TRACK_WINDOW(m_nominal);
+
+    // Coast over missed edges
+    unsigned long expected = m_crossing + m_period;
+    uint8_t missed = 0;
+    while ((long)(now - expected) > (long)window && missed < MAX_MISSED) {
+        expected += m_period;
+        missed++;
+    }
+
+    long error = (long)(now - expected);
+    if (error > (long)window || error < -(long)window) {
+        m_rejected++;
+        if (++m_rejected_row > MAX_REJECTED || (long)(now - expected) > (long)window) {
+            unlock(now);
+        }
+        return false;
+    }
+
+    m_rejected_row = 0;
+    m_accepted++;
+
+    // The phase follows quickly, the period slowly and only from back to back edges
+    m_crossing = expected + error / 4;
+    m_shift = (int)(m_crossing - now);
+    if (missed == 0) {
+        long period = (long)m_period + error / 16;
+        long range = PERIOD_RANGE(m_nominal);
+        if (period > (long)m_nominal + range) {
+            period = m_nominal + range;
+        }
+        else if (period < (long)m_nominal - range) {
+            period = m_nominal - range;
+        }
+        m_period = period;
+    }
+    return true;
+}
+
+void ZeroCrossTracker::unlock(unsigned long now)
+{
+    m_locked = false;
+    m_nominal = 0;
+    m_matches = 0;
+    m_started = true;
+    m_crossing = now;
+    m_shift = 0;
+}
+
+int ZeroCrossTracker::get_edge_shift() const
+{
+    return m_shift;
+}
+
+bool ZeroCrossTracker::is_locked() const
+{
+    return m_locked;
+}
+
+uint8_t ZeroCrossTracker::get_frequency() const
+{
+    uint8_t frequency = 0;
+    ZERO_CROSS_ATOMIC {
+        if (m_locked) {
+            frequency = (m_nominal == HALF_PERIOD_60HZ) ? 60 : 50;
+        }
+    }
+    return frequency;
+}
+
+unsigned int ZeroCrossTracker::get_nominal_period() const
+{
+    unsigned int period;
+    ZERO_CROSS_ATOMIC {
+        period = m_locked ? m_nominal : HALF_PERIOD_50HZ;
+    }
+    return period;
+}
+
+unsigned int ZeroCrossTracker::get_period() const
+{
+    unsigned int period;
+    ZERO_CROSS_ATOMIC {
+        period = m_period;
+    }
+    return period;
+}
+
+unsigned long ZeroCrossTracker::get_crossing() const
+{
+    unsigned long crossing;
+    ZERO_CROSS_ATOMIC {
+        crossing = m_crossing;
+    }
+    return crossing;
+}
+
+unsigned long ZeroCrossTracker::predict_next() const
+{
+    unsigned long next;
+    ZERO_CROSS_ATOMIC {
+        next = m_crossing + m_period;
+    }
+    return next;
+}
+
+unsigned long ZeroCrossTracker::get_accepted() const
+{
+    unsigned long accepted;
+    ZERO_CROSS_ATOMIC {
+        accepted = m_accepted;
+    }
+    return accepted;
+}
+
+unsigned long ZeroCrossTracker::get_rejected() const
+{
+    unsigned long rejected;
+    ZERO_CROSS_ATOMIC {
+        rejected = m_rejected;
+    }
+    return rejected;
+}
@@ -0,0 +1,68 @@
+#ifndef ARDUINO_ZEROCROSSTRACKER_H
+#define ARDUINO_ZEROCROSSTRACKER_H
+
+#include <stdint.h>
+
+// Follows the zero cross edges of the mains, detects 50 or 60 Hz and filters the edge jitter.
+//
+// While unlocked, edges are timed until LOCK_EDGES half-cycles in a row match one of the mains
+// frequencies. Once locked, an edge is only taken within a window around the predicted crossing;
+// glitches and bounces outside of it are rejected. Taken edges pull the predicted phase and period
+// like a PLL, and a few missed edges are coasted through. Lots of rejected edges in a row mean the
+// signal changed, and the tracker starts over.
+//
+// `on_edge` is called from the zero cross interrupt, so there are no divisions in it.
+class ZeroCrossTracker
+{
+public:
+    static const unsigned int HALF_PERIOD_50HZ = 10000;
+    static const unsigned int HALF_PERIOD_60HZ = 8333;
+
+    static const uint8_t LOCK_EDGES = 8;
+    static const uint8_t MAX_MISSED = 3;
+    static const uint8_t MAX_REJECTED = 8;
+
+    ZeroCrossTracker();
+
+    void reset();
+
+    // Returns true if the edge is taken as a zero cross
+    bool on_edge(unsigned long now);
+    // Filtered crossing relative to the last taken edge, in microseconds. Meant for the zero cross
+    // interrupt right after `on_edge`, as the `shift` of PhaseDimmer::on_zero_cross
+    int get_edge_shift() const;
+
+    bool is_locked() const;
+    // 50 or 60 once locked, 0 before
+    uint8_t get_frequency() const;
+    // Nominal half-cycle of the detected frequency, 50 Hz before the lock
+    unsigned int get_nominal_period() const;
+    // Filtered half-cycle, in microseconds
+    unsigned int get_period() const;
+    // Filtered time of the last crossing and the prediction of the next one, in micros()
+    unsigned long get_crossing() const;
+    unsigned long predict_next() const;
+
+    unsigned long get_accepted() const;
+    unsigned long get_rejected() const;
+
+private:
+    void acquire(unsigned long now);
+    bool track(unsigned long now);
+    void unlock(unsigned long now);
+
+    volatile bool m_locked;
+    volatile unsigned int m_nominal;
+    volatile unsigned int m_period;
+    volatile unsigned long m_crossing;
+    int m_shift;
+
+    bool m_started;
+    uint8_t m_matches;
+    uint8_t m_rejected_row;
+
+    volatile unsigned long m_accepted;
+    volatile unsigned long m_rejected;
+};
+
+#endif //ARDUINO_ZEROCROSSTRACKER_H
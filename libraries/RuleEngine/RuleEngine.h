@@ -0,0 +1,329 @@
+#ifndef ARDUINO_RULEENGINE_H
+#define ARDUINO_RULEENGINE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef RULE_ENGINE_MAX_RULES
+#define RULE_ENGINE_MAX_RULES   8
+#endif
+#ifndef RULE_ENGINE_INPUTS
+#define RULE_ENGINE_INPUTS      4
+#endif
+
+// A rule switches a local output while its conditions hold, so the node acts on its own sensors
+// without a round trip to the controller, and also while the gateway is down.
+//
+// Up to two conditions compare inputs, set by the sketch, to thresholds and must both hold. An
+// optional window limits the rule to a time of day, known once the controller sent the time. When
+// the conditions start to hold, the output is set to the rule value. When they stop, it's set back
+// after `hold` seconds, or left as is if `hold` is 0. Outputs are only touched on these edges, so a
+// command from the controller stays until a rule fires again.
+struct Rule
+{
+    enum Op
+    {
+        ALWAYS,
+        LESS,
+        GREATER,
+        EQUAL,
+        NOT_EQUAL,
+        OP_COUNT,
+    };
+
+    struct Condition
+    {
+        uint8_t input;
+        uint8_t op;
+        int16_t threshold;
+    };
+
+    // Window bounds are in tens of minutes of the day, 0..143. The end is excluded, a window that
+    // ends before it starts goes over midnight.
+    static const uint8_t ANY_TIME = 0xFF;
+
+    Condition conditions[2];
+    uint8_t window_start;
+    uint8_t window_end;
+    uint8_t output;
+    bool value;
+    uint16_t hold;
+};
+
+// Rules are stored at `address` one after another, and uploaded one per message.
+//
+// Layout: | input << 4 | op, threshold int16 LE | the second condition | window start | window end |
+//         | value << 7 | output | hold uint16 LE | crc8 of the preceding bytes |
+//
+// An upload is a rule index followed by the layout without the CRC, the index alone deletes the
+// rule. The CRC starts from 0xFF, so neither an erased nor a zeroed slot is taken for a rule.
+template <typename EEPROM_T>
+class RuleEngine
+{
+public:
+    typedef void (* action_t)(uint8_t output, bool value);
+
+    static const uint8_t RULE_SIZE = 12;
+    static const uint8_t PAYLOAD_SIZE = RULE_SIZE - 1;
+
+    RuleEngine(EEPROM_T & eeprom, int address, action_t action) :
+        m_eeprom(eeprom),
+        m_address{address},
+        m_action{action},
+        m_rules{},
+        m_states{},
+        m_inputs{},
+        m_has_time{false},
+        m_day_seconds{0},
+        m_time_set_at{0}
+    {
+    }
+
+    // Reads the rules, returns how many there are
+    uint8_t load()
+    {
+        uint8_t count = 0;
+        for (uint8_t index = 0; index < RULE_ENGINE_MAX_RULES; index++) {
+            uint8_t record[RULE_SIZE];
+            for (uint8_t i = 0; i < RULE_SIZE; i++) {
+                record[i] = m_eeprom.read(rule_address(index) + i);
+            }
+
+            m_states[index] = State{};
+            m_states[index].valid = crc8(record, PAYLOAD_SIZE) == record[PAYLOAD_SIZE]
+                && decode(record, m_rules[index]);
+            count += m_states[index].valid;
+        }
+        return count;
+    }
+
+    // Stores an uploaded rule, `data` is the index and the rule as described above. Returns false
+    // if it doesn't make a rule.
+    bool upload(const uint8_t * data, uint8_t size)
+    {
+        if (size == 0 || data[0] >= RULE_ENGINE_MAX_RULES) {
+            return false;
+        }
+        uint8_t index = data[0];
+
+        uint8_t record[RULE_SIZE];
+        if (size == 1) {
+            memset(record, 0xFF, RULE_SIZE);
+            m_states[index] = State{};
+        }
+        else {
+            Rule rule;
+            if (size != 1 + PAYLOAD_SIZE || !decode(data + 1, rule)) {
+                return false;
+            }
+            memcpy(record, data + 1, PAYLOAD_SIZE);
+            record[PAYLOAD_SIZE] = crc8(record, PAYLOAD_SIZE);
+
+            m_rules[index] = rule;
+            m_states[index] = State{};
+            m_states[index].valid = true;
+        }
+
+        for (uint8_t i = 0; i < RULE_SIZE; i++) {
+            m_eeprom.update(rule_address(index) + i, record[i]);
+        }
+        return true;
+    }
+
+    // Encodes a rule for `upload`, `data` takes 1 + PAYLOAD_SIZE bytes
+    static void encode(uint8_t index, const Rule & rule, uint8_t * data)
+    {
+        data[0] = index;
+        for (uint8_t i = 0; i < 2; i++) {
+            const Rule::Condition & condition = rule.conditions[i];
+            data[1 + i * 3] = condition.input << 4 | condition.op;
+            data[2 + i * 3] = (uint16_t)condition.threshold & 0xFF;
+            data[3 + i * 3] = (uint16_t)condition.threshold >> 8;
+        }
+        data[7] = rule.window_start;
+        data[8] = rule.window_end;
+        data[9] = rule.value << 7 | rule.output;
+        data[10] = rule.hold & 0xFF;
+        data[11] = rule.hold >> 8;
+    }
+
+    bool has_rule(uint8_t index) const
+    {
+        return index < RULE_ENGINE_MAX_RULES && m_states[index].valid;
+    }
+
+    void set_input(uint8_t input, int16_t value)
+    {
+        if (input < RULE_ENGINE_INPUTS) {
+            m_inputs[input] = value;
+        }
+    }
+
+    // The time of day from the controller, in seconds since midnight, and `now` when it was taken
+    void set_time(unsigned long day_seconds, unsigned long now)
+    {
+        m_has_time = true;
+        m_day_seconds = day_seconds % SECONDS_PER_DAY;
+        m_time_set_at = now;
+    }
+
+    // Fires the rules whose conditions changed, from the loop
+    void process(unsigned long now)
+    {
+        for (uint8_t index = 0; index < RULE_ENGINE_MAX_RULES; index++) {
+            State & state = m_states[index];
+            if (!state.valid) {
+                continue;
+            }
+            const Rule & rule = m_rules[index];
+
+            if (is_met(rule, now)) {
+                state.last_met = now;
+                if (!state.active) {
+                    state.active = true;
+                    m_action(rule.output, rule.value);
+                }
+            }
+            else if (state.active && rule.hold == 0) {
+                state.active = false;
+            }
+            else if (state.active && now - state.last_met >= rule.hold * 1000UL) {
+                state.active = false;
+                m_action(rule.output, !rule.value);
+            }
+        }
+    }
+
+    // The time until the first running hold sets its output back, 0 if none runs. A sleeping node
+    // wakes up then, so process() fires it on time.
+    unsigned long get_hold_left(unsigned long now) const
+    {
+        unsigned long left = 0;
+        for (uint8_t index = 0; index < RULE_ENGINE_MAX_RULES; index++) {
+            const State & state = m_states[index];
+            const Rule & rule = m_rules[index];
+            if (!state.valid || !state.active || rule.hold == 0 || is_met(rule, now)) {
+                continue;
+            }
+
+            unsigned long elapsed = now - state.last_met;
+            unsigned long hold_ms = rule.hold * 1000UL;
+            unsigned long rule_left = elapsed < hold_ms ? hold_ms - elapsed : 1;
+            if (left == 0 || rule_left < left) {
+                left = rule_left;
+            }
+        }
+        return left;
+    }
+
+private:
+    static const unsigned long SECONDS_PER_DAY = 24 * 60 * 60UL;
+    static const uint8_t WINDOWS_PER_DAY = 24 * 6;
+
+    struct State
+    {
+        bool valid;
+        bool active;
+        unsigned long last_met;
+    };
+
+    int rule_address(uint8_t index) const
+    {
+        return m_address + (int)index * RULE_SIZE;
+    }
+
+    static bool decode(const uint8_t * data, Rule & rule)
+    {
+        for (uint8_t i = 0; i < 2; i++) {
+            Rule::Condition & condition = rule.conditions[i];
+            condition.input = data[i * 3] >> 4;
+            condition.op = data[i * 3] & 0x0F;
+            condition.threshold = (int16_t)(data[1 + i * 3] | (uint16_t)data[2 + i * 3] << 8);
+            if (condition.op >= Rule::OP_COUNT || condition.input >= RULE_ENGINE_INPUTS) {
+                return false;
+            }
+        }
+        rule.window_start = data[6];
+        rule.window_end = data[7];
+        rule.value = data[8] >> 7;
+        rule.output = data[8] & 0x7F;
+        rule.hold = data[9] | (uint16_t)data[10] << 8;
+
+        if (rule.window_start != Rule::ANY_TIME
+            && (rule.window_start >= WINDOWS_PER_DAY || rule.window_end >= WINDOWS_PER_DAY)) {
+            return false;
+        }
+        return true;
+    }
+
+    bool is_met(const Rule & rule, unsigned long now) const
+    {
+        for (uint8_t i = 0; i < 2; i++) {
+            const Rule::Condition & condition = rule.conditions[i];
+            int16_t value = m_inputs[condition.input];
+
+            switch (condition.op) {
+                case Rule::LESS:
+                    if (!(value < condition.threshold)) return false;
+                    break;
+                case Rule::GREATER:
+                    if (!(value > condition.threshold)) return false;
+                    break;
+                case Rule::EQUAL:
+                    if (value != condition.threshold) return false;
+                    break;
+                case Rule::NOT_EQUAL:
+                    if (value == condition.threshold) return false;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (rule.window_start == Rule::ANY_TIME) {
+            return true;
+        }
+        // Without the time a window is never open
+        if (!m_has_time) {
+            return false;
+        }
+        uint8_t window = (m_day_seconds + (now - m_time_set_at) / 1000) % SECONDS_PER_DAY / 600;
+        if (rule.window_start <= rule.window_end) {
+            return window >= rule.window_start && window < rule.window_end;
+        }
+        return window >= rule.window_start || window < rule.window_end;
+    }
+
+    // Dallas/Maxim CRC-8, the same as EEPROMJournal
+    static uint8_t crc8(const uint8_t * data, uint8_t size)
+    {
+        uint8_t crc = 0xFF;
+        while (size--) {
+            crc ^= *data++;
+            for (uint8_t i = 0; i < 8; i++) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0x8C : crc >> 1;
+            }
+        }
+        return crc;
+    }
+
+    EEPROM_T & m_eeprom;
+    int m_address;
+    action_t m_action;
+
+    Rule m_rules[RULE_ENGINE_MAX_RULES];
+    State m_states[RULE_ENGINE_MAX_RULES];
+    int16_t m_inputs[RULE_ENGINE_INPUTS];
+
+    bool m_has_time;
+    unsigned long m_day_seconds;
+    unsigned long m_time_set_at;
+};
+
+template <typename EEPROM_T>
+const uint8_t RuleEngine<EEPROM_T>::RULE_SIZE;
+
+template <typename EEPROM_T>
+const uint8_t RuleEngine<EEPROM_T>::PAYLOAD_SIZE;
+
+#endif //ARDUINO_RULEENGINE_H
@@ -0,0 +1,304 @@
+/*
+ * SimpleTimerQueue.h
+ *
+ * A SimpleTimer with the timers kept in a binary heap by their next deadline,
+ * so run() only looks at the earliest one and costs a single comparison when
+ * nothing is due. The number of timers is a template parameter.
+ *
+ * The API is the one of SimpleTimer, plus timeUntilNext() for callers that
+ * want to sleep until the next timer.
+ *
+ * This library is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser
+ * General Public License as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ */
+
+
+#ifndef SIMPLETIMERQUEUE_H
+#define SIMPLETIMERQUEUE_H
+
+#include <Arduino.h>
+
+typedef void (*timer_callback)(void);
+
+template <uint8_t CAPACITY>
+class SimpleTimerQueue {
+
+public:
+    // maximum number of timers
+    const static int MAX_TIMERS = CAPACITY;
+
+    // setTimer() constants
+    const static int RUN_FOREVER = 0;
+    const static int RUN_ONCE = 1;
+
+    // timeUntilNext() value when there are no timers
+    const static unsigned long NEVER = 0xFFFFFFFFUL;
+
+    SimpleTimerQueue() :
+        numTimers{0},
+        heapSize{0}
+    {
+        for (int i = 0; i < MAX_TIMERS; i++) {
+            callbacks[i] = 0;
+            enabled[i] = false;
+            numRuns[i] = 0;
+            positions[i] = 0;
+        }
+    }
+
+    // this function must be called inside loop()
+    void run() {
+        unsigned long current_millis = millis();
+
+        if (heapSize == 0 || (long)(current_millis - deadlines[heap[0]]) < 0) {
+            return;
+        }
+
+        // Take the due timers out of the heap first, so each runs once per
+        // call, and put them back with their next deadlines
+        uint8_t due[CAPACITY];
+        uint8_t numDue = 0;
+        while (heapSize && (long)(current_millis - deadlines[heap[0]]) >= 0) {
+            due[numDue++] = heap[0];
+            remove(heap[0]);
+        }
+        for (uint8_t i = 0; i < numDue; i++) {
+            deadlines[due[i]] = current_millis + delays[due[i]];
+            insert(due[i]);
+        }
+
+        for (uint8_t i = 0; i < numDue; i++) {
+            uint8_t slot = due[i];
+
+            // disabled, or deleted by an earlier callback
+            if (!enabled[slot] || !callbacks[slot]) {
+                continue;
+            }
+
+            if (maxNumRuns[slot] == RUN_FOREVER) {
+                (*callbacks[slot])();
+            }
+            else if (numRuns[slot] < maxNumRuns[slot]) {
+                numRuns[slot]++;
+                bool last = numRuns[slot] >= maxNumRuns[slot];
+
+                (*callbacks[slot])();
+
+                // after the last run, delete the timer
+                if (last) {
+                    deleteTimer(slot);
+                }
+            }
+        }
+    }
+
+    // call function f every d milliseconds
+    int setInterval(long d, timer_callback f) {
+        return setTimer(d, f, RUN_FOREVER);
+    }
+
+    // call function f once after d milliseconds
+    int setTimeout(long d, timer_callback f) {
+        return setTimer(d, f, RUN_ONCE);
+    }
+
+    // call function f every d milliseconds for n times
+    int setTimer(long d, timer_callback f, int n) {
+        if (!f || numTimers >= MAX_TIMERS) {
+            return -1;
+        }
+
+        int freeTimer = 0;
+        while (callbacks[freeTimer]) {
+            freeTimer++;
+        }
+
+        delays[freeTimer] = d;
+        callbacks[freeTimer] = f;
+        maxNumRuns[freeTimer] = n;
+        numRuns[freeTimer] = 0;
+        enabled[freeTimer] = true;
+        deadlines[freeTimer] = millis() + d;
+        insert(freeTimer);
+
+        numTimers++;
+
+        return freeTimer;
+    }
+
+    // destroy the specified timer
+    void deleteTimer(int numTimer) {
+        if (!isValid(numTimer)) {
+            return;
+        }
+
+        remove(numTimer);
+        callbacks[numTimer] = 0;
+        enabled[numTimer] = false;
+        numRuns[numTimer] = 0;
+
+        numTimers--;
+    }
+
+    // restart the specified timer
+    void restartTimer(int numTimer) {
+        if (!isValid(numTimer)) {
+            return;
+        }
+
+        remove(numTimer);
+        deadlines[numTimer] = millis() + delays[numTimer];
+        insert(numTimer);
+    }
+
+    // returns true if the specified timer is enabled
+    bool isEnabled(int numTimer) {
+        return isValid(numTimer) && enabled[numTimer];
+    }
+
+    // enables the specified timer
+    void enable(int numTimer) {
+        if (isValid(numTimer)) {
+            enabled[numTimer] = true;
+        }
+    }
+
+    // disables the specified timer, it keeps its deadlines to go on in
+    // phase when enabled again
+    void disable(int numTimer) {
+        if (isValid(numTimer)) {
+            enabled[numTimer] = false;
+        }
+    }
+
+    // enables the specified timer if it's currently disabled,
+    // and vice-versa
+    void toggle(int numTimer) {
+        if (isValid(numTimer)) {
+            enabled[numTimer] = !enabled[numTimer];
+        }
+    }
+
+    // milliseconds until the earliest timer is due, 0 if one is due
+    // already, NEVER if there are no timers. Disabled timers count.
+    unsigned long timeUntilNext() {
+        if (heapSize == 0) {
+            return NEVER;
+        }
+
+        long remaining = (long)(deadlines[heap[0]] - millis());
+        return remaining > 0 ? remaining : 0;
+    }
+
+    // returns the number of used timers
+    int getNumTimers() { return numTimers; };
+
+    // returns the number of available timers
+    int getNumAvailableTimers() { return MAX_TIMERS - numTimers; };
+
+private:
+    bool isValid(int numTimer) {
+        return numTimer >= 0 && numTimer < MAX_TIMERS && callbacks[numTimer];
+    }
+
+    // deadlines are compared by their distance, so the heap keeps working
+    // across the millis() overflow
+    bool isEarlier(uint8_t a, uint8_t b) {
+        return (long)(deadlines[a] - deadlines[b]) < 0;
+    }
+
+    void place(uint8_t index, uint8_t slot) {
+        heap[index] = slot;
+        positions[slot] = index;
+    }
+
+    void siftUp(uint8_t index) {
+        uint8_t slot = heap[index];
+        while (index > 0) {
+            uint8_t parent = (index - 1) / 2;
+            if (!isEarlier(slot, heap[parent])) {
+                break;
+            }
+            place(index, heap[parent]);
+            index = parent;
+        }
+        place(index, slot);
+    }
+
+    void siftDown(uint8_t index) {
+        uint8_t slot = heap[index];
+        while (true) {
+            uint8_t child = 2 * index + 1;
+            if (child >= heapSize) {
+                break;
+            }
+            if (child + 1 < heapSize && isEarlier(heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!isEarlier(heap[child], slot)) {
+                break;
+            }
+            place(index, heap[child]);
+            index = child;
+        }
+        place(index, slot);
+    }
+
+    void insert(uint8_t slot) {
+        place(heapSize, slot);
+        siftUp(heapSize++);
+    }
+
+    void remove(uint8_t slot) {
+        uint8_t index = positions[slot];
+        if (index >= heapSize || heap[index] != slot) {
+            return;
+        }
+
+        uint8_t last = heap[--heapSize];
+        if (index == heapSize) {
+            return;
+        }
+        place(index, last);
+        siftUp(index);
+        siftDown(positions[last]);
+    }
+
+    // pointers to the callback functions, zero for a free slot
+    timer_callback callbacks[CAPACITY];
+
+    // delay values
+    long delays[CAPACITY];
+
+    // next time to process each timer
+    unsigned long deadlines[CAPACITY];
+
+    // number of runs to be executed for each timer
+    int maxNumRuns[CAPACITY];
+
+    // number of executed runs for each timer
+    int numRuns[CAPACITY];
+
+    // which timers are enabled
+    bool enabled[CAPACITY];
+
+    // slots ordered by deadlines, heap[0] is the earliest
+    uint8_t heap[CAPACITY];
+
+    // index in the heap of each slot
+    uint8_t positions[CAPACITY];
+
+    // actual number of timers in use
+    int numTimers;
+
+    // number of timers in the heap, all of them but in run()
+    uint8_t heapSize;
+};
+
+template <uint8_t CAPACITY>
+const unsigned long SimpleTimerQueue<CAPACITY>::NEVER;
+
+#endif
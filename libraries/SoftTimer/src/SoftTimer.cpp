@@ -27,6 +27,10 @@
 #include "Arduino.h"
 #include "SoftTimer.h"
 
+#ifdef __AVR__
+#include <avr/sleep.h>
+#endif
+
 /**
  * The main loop is implemented here. You do not ever need to call implement this function
  * if you think in event driven programing.
@@ -94,6 +98,14 @@ void SoftTimerClass::remove(Task* task) {
  */
 void SoftTimerClass::run() {
   while(true) {
+    if(this->_idle != NULL) {
+      unsigned long waitMicros = this->runDue();
+      if(waitMicros > 0) {
+        this->_idle(waitMicros);
+      }
+      continue;
+    }
+
     Task* task = this->_tasks;
     // -- (If this->_tasks is NULL, than nothing is registered.)
     while(task != NULL) {
@@ -103,6 +115,48 @@ void SoftTimerClass::run() {
   }
 }
 
+/**
+ * Switch to the idle mode, or back to polling with NULL.
+ */
+void SoftTimerClass::setIdle(SoftTimerIdle idle) {
+  this->_idle = idle;
+}
+
+/**
+ * Call the due tasks, then look for the nearest deadline. The chain is walked again for the deadline,
+ * as the callbacks, and some interrupts, change the periods and the start times of the tasks.
+ */
+unsigned long SoftTimerClass::runDue() {
+  Task* task = this->_tasks;
+  while(task != NULL) {
+    this->testAndCall(task);
+    task = task->nextTask;
+  }
+
+  unsigned long now = micros();
+  unsigned long waitMicros = SOFTTIMER_WAIT_FOREVER;
+  for(task = this->_tasks; task != NULL && waitMicros > 0; task = task->nextTask) {
+    // -- The elapsed time is right across the micros() overflow.
+    unsigned long elapsed = now - task->lastCallTimeMicros;
+    unsigned long remaining = elapsed >= task->periodMicros ? 0 : task->periodMicros - elapsed;
+    if(remaining < waitMicros) {
+      waitMicros = remaining;
+    }
+  }
+  return waitMicros;
+}
+
+/**
+ * Sleep until the next interrupt, the Timer0 overflow at the latest.
+ */
+void SoftTimerClass::sleepUntilInterrupt(unsigned long waitMicros) {
+#ifdef __AVR__
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_mode();
+#endif
+  (void)waitMicros;
+}
+
 /**
  * Test a task and call the callback if its period was passed since last call.
  */
@@ -29,6 +29,14 @@
 
 #include "Task.h"
 
+/**
+ * Handler of the time between the tasks in the idle mode, see setIdle().
+ *  waitMicros - Time until the nearest task is due, SOFTTIMER_WAIT_FOREVER if no tasks are registered.
+ */
+typedef void (*SoftTimerIdle)(unsigned long waitMicros);
+
+#define SOFTTIMER_WAIT_FOREVER 0xFFFFFFFFUL
+
 class SoftTimerClass
 {
   public:
@@ -43,6 +51,26 @@ class SoftTimerClass
     */
     void remove(Task* task);
     
+    /**
+     * Switch to the idle mode: instead of polling the tasks in a busy loop, the nearest deadline is
+     * computed after the due tasks are called, and the idle handler is given the time until then.
+     * Pass SoftTimerClass::sleepUntilInterrupt to put an AVR into idle sleep between interrupts, or a
+     * handler of your own that sleeps for the given time. Pass NULL to go back to polling.
+     */
+    void setIdle(SoftTimerIdle idle);
+
+    /**
+     * Call the due tasks, and return the time until the nearest task is due. For internal use only.
+     */
+    unsigned long runDue();
+
+    /**
+     * Idle handler putting an AVR to SLEEP_MODE_IDLE until the next interrupt. It doesn't use
+     * waitMicros: the Timer0 overflow, running micros(), still wakes it up every 1024us, so the CPU
+     * rests between the ticks but the ticks go on.
+     */
+    static void sleepUntilInterrupt(unsigned long waitMicros);
+
     /**
      * For internal use only. You do not need to call this function.
      */
@@ -50,6 +78,7 @@ class SoftTimerClass
   private:
     void testAndCall(Task* task);
     Task* _tasks;
+    SoftTimerIdle _idle;
 };
 
 extern SoftTimerClass SoftTimer;
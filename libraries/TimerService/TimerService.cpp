@@ -0,0 +1,264 @@
+#include "TimerService.h"
+
+#ifdef TIMER_SERVICE_AVR
+#include <util/atomic.h>
+#define TIMER_SERVICE_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define TIMER_SERVICE_ATOMIC
+#endif
+
+// Deadlines closer than this are fired right away, the compare could miss them
+#define MIN_COMPARE_TICKS   (8 * TIMER_SERVICE_TICKS_PER_US)
+
+const TimerService::id_t TimerService::NONE;
+const unsigned long TimerService::NEVER;
+
+TimerService timer_service;
+
+#ifdef TIMER_SERVICE_AVR
+ISR(TIMER1_COMPA_vect)
+{
+    timer_service.on_compare();
+}
+
+ISR(TIMER1_OVF_vect)
+{
+    timer_service.on_overflow();
+}
+#endif
+
+TimerService::TimerService() :
+    m_timers{},
+    m_overflows{0},
+    m_in_update{false}
+{
+}
+
+void TimerService::setup()
+{
+#ifdef TIMER_SERVICE_AVR
+    TIMER_SERVICE_ATOMIC {
+        TCCR1A = 0;
+        TCCR1B = _BV(CS11);     // normal mode, F_CPU/8
+        TCNT1 = 0;
+        TIFR1 = _BV(OCF1A) | _BV(TOV1);
+        TIMSK1 = _BV(TOIE1);
+        m_overflows = 0;
+    }
+#endif
+}
+
+TimerService::id_t TimerService::add(callback_t callback, void * data, Delivery delivery)
+{
+    TIMER_SERVICE_ATOMIC {
+        for (id_t id = 0; id < TIMER_SERVICE_MAX_TIMERS; id++) {
+            Timer & timer = m_timers[id];
+            if (timer.used) {
+                continue;
+            }
+            timer.callback = callback;
+            timer.data = data;
+            timer.delivery = delivery;
+            timer.armed = false;
+            timer.pending = false;
+            timer.used = true;
+            return id;
+        }
+    }
+    return NONE;
+}
+
+void TimerService::remove(id_t id)
+{
+    if (!is_valid(id)) {
+        return;
+    }
+
+    TIMER_SERVICE_ATOMIC {
+        m_timers[id].used = false;
+        m_timers[id].armed = false;
+        m_timers[id].pending = false;
+    }
+}
+
+void TimerService::arm(id_t id, unsigned long delay, unsigned long period)
+{
+    if (!is_valid(id)) {
+        return;
+    }
+
+    TIMER_SERVICE_ATOMIC {
+        Timer & timer = m_timers[id];
+        timer.deadline = get_ticks() + delay * TIMER_SERVICE_TICKS_PER_US;
+        timer.period = period * TIMER_SERVICE_TICKS_PER_US;
+        timer.armed = true;
+        update();
+    }
+}
+
+void TimerService::disarm(id_t id)
+{
+    if (!is_valid(id)) {
+        return;
+    }
+
+    // The compare may still come, and find nothing to do
+    TIMER_SERVICE_ATOMIC {
+        m_timers[id].armed = false;
+    }
+}
+
+bool TimerService::is_armed(id_t id) const
+{
+    return is_valid(id) && m_timers[id].armed;
+}
+
+unsigned long TimerService::get_next_delay() const
+{
+    unsigned long delay = NEVER;
+    TIMER_SERVICE_ATOMIC {
+        uint32_t ticks = get_ticks();
+        for (const Timer & timer : m_timers) {
+            if (!timer.armed) {
+                continue;
+            }
+            int32_t remaining = timer.deadline - ticks;
+            unsigned long timer_delay = remaining > 0 ? remaining / TIMER_SERVICE_TICKS_PER_US : 0;
+            if (timer_delay < delay) {
+                delay = timer_delay;
+            }
+        }
+    }
+    return delay;
+}
+
+void TimerService::on_compare()
+{
+    update();
+}
+
+void TimerService::on_overflow()
+{
+    m_overflows++;
+    update();
+}
+
+void TimerService::process()
+{
+    for (Timer & timer : m_timers) {
+        bool pending;
+        callback_t callback;
+        void * data;
+        TIMER_SERVICE_ATOMIC {
+            pending = timer.pending && timer.used;
+            timer.pending = false;
+            callback = timer.callback;
+            data = timer.data;
+        }
+
+        if (pending) {
+            callback(data);
+        }
+    }
+}
+
+uint32_t TimerService::get_ticks() const
+{
+#ifdef TIMER_SERVICE_AVR
+    uint16_t low;
+    uint16_t high;
+    TIMER_SERVICE_ATOMIC {
+        low = TCNT1;
+        high = m_overflows;
+        // An overflow not served yet, as in an interrupt or with them disabled
+        if ((TIFR1 & _BV(TOV1)) && low < 0x8000) {
+            high++;
+        }
+    }
+    return (uint32_t)high << 16 | low;
+#else
+    return micros();
+#endif
+}
+
+// Fires the due timers and sets the compare for the next one, with the interrupts disabled
+void TimerService::update()
+{
+    if (m_in_update) {
+        return;
+    }
+
+    m_in_update = true;
+    do {
+        fire_due();
+    } while (!arm_next());
+    m_in_update = false;
+}
+
+void TimerService::fire_due()
+{
+    uint32_t ticks = get_ticks();
+    for (Timer & timer : m_timers) {
+        if (!timer.armed || (int32_t)(ticks - timer.deadline) < 0) {
+            continue;
+        }
+
+        if (timer.period) {
+            timer.deadline += timer.period;
+            // Too late for a whole period, start over instead of catching up
+            if ((int32_t)(ticks - timer.deadline) >= 0) {
+                timer.deadline = ticks + timer.period;
+            }
+        }
+        else {
+            timer.armed = false;
+        }
+
+        if (timer.delivery == IN_ISR) {
+            timer.callback(timer.data);
+        }
+        else {
+            timer.pending = true;
+        }
+    }
+}
+
+// Sets the compare for the earliest timer, false if that is due already
+bool TimerService::arm_next()
+{
+    const Timer * next = nullptr;
+    for (const Timer & timer : m_timers) {
+        if (timer.armed && (!next || (int32_t)(timer.deadline - next->deadline) < 0)) {
+            next = &timer;
+        }
+    }
+
+#ifdef TIMER_SERVICE_AVR
+    if (!next) {
+        TIMSK1 &= ~_BV(OCIE1A);
+        return true;
+    }
+
+    int32_t remaining = next->deadline - get_ticks();
+    if (remaining < MIN_COMPARE_TICKS) {
+        return false;
+    }
+    if (remaining > 0xFFFF) {
+        // Further than the next overflow, which comes back here
+        TIMSK1 &= ~_BV(OCIE1A);
+        return true;
+    }
+
+    OCR1A = (uint16_t)next->deadline;
+    TIFR1 = _BV(OCF1A);
+    TIMSK1 |= _BV(OCIE1A);
+    return true;
+#else
+    return !next || (int32_t)(next->deadline - get_ticks()) > 0;
+#endif
+}
+
+bool TimerService::is_valid(id_t id) const
+{
+    return id >= 0 && id < TIMER_SERVICE_MAX_TIMERS && m_timers[id].used;
+}
@@ -0,0 +1,100 @@
+#ifndef ARDUINO_TIMERSERVICE_H
+#define ARDUINO_TIMERSERVICE_H
+
+#include <Arduino.h>
+
+#ifndef TIMER_SERVICE_MAX_TIMERS
+#define TIMER_SERVICE_MAX_TIMERS    6
+#endif
+
+// Many one-shot and periodic timers on one hardware compare channel, so a sketch doesn't give a
+// whole hardware timer to each job.
+//
+// On AVR Timer1 runs free at F_CPU/8, its overflows extend it to 32 bits, and OCR1A is set to the
+// earliest deadline, so there is an interrupt only when a timer is due. Timers further than an
+// overflow away are picked up by the overflow interrupt, every 32ms at 16MHz.
+// Elsewhere, and in the unit tests, the time is micros() and `on_compare` is called by hand.
+//
+// A timer is delivered either:
+//  - IN_ISR, the callback runs in the compare interrupt with microsecond precision. It must be short.
+//  - IN_LOOP, the interrupt only marks it, `process` runs the callback from the loop. Periods missed
+//    by a slow loop are merged into one call.
+//
+// Times are in microseconds, delays up to 15 minutes. IN_ISR callbacks run with the interrupts
+// disabled, from the compare interrupt, or from `arm` if the timer is due already.
+#if defined(__AVR__) && !defined(UNITTESTS)
+#define TIMER_SERVICE_AVR
+#define TIMER_SERVICE_TICKS_PER_US  (F_CPU / 8000000UL)
+#if F_CPU % 8000000UL
+#error "TimerService needs a clock of 8MHz or 16MHz"
+#endif
+#else
+#define TIMER_SERVICE_TICKS_PER_US  1
+#endif
+
+class TimerService
+{
+public:
+    typedef void (* callback_t)(void * data);
+    typedef int8_t id_t;
+
+    enum Delivery
+    {
+        IN_ISR,
+        IN_LOOP,
+    };
+
+    static const id_t NONE = -1;
+    static const unsigned long NEVER = 0xFFFFFFFFUL;
+
+    TimerService();
+
+    void setup();
+
+    // Reserves a timer, NONE if all are taken. It starts disarmed.
+    id_t add(callback_t callback, void * data, Delivery delivery);
+    void remove(id_t id);
+
+    // Fires after `delay`, then every `period` if that isn't 0
+    void arm(id_t id, unsigned long delay, unsigned long period = 0);
+    void disarm(id_t id);
+    bool is_armed(id_t id) const;
+
+    // Time until the earliest armed timer, NEVER if none is armed
+    unsigned long get_next_delay() const;
+
+    // The compare and the overflow interrupts
+    void on_compare();
+    void on_overflow();
+
+    // Runs the IN_LOOP callbacks that are due, from the loop
+    void process();
+
+private:
+    struct Timer
+    {
+        callback_t callback;
+        void * data;
+        uint32_t deadline;
+        uint32_t period;
+        uint8_t delivery;
+        bool used;
+        bool armed;
+        volatile bool pending;
+    };
+
+    uint32_t get_ticks() const;
+    void update();
+    void fire_due();
+    bool arm_next();
+    bool is_valid(id_t id) const;
+
+    Timer m_timers[TIMER_SERVICE_MAX_TIMERS];
+    volatile uint16_t m_overflows;
+    // Set while the due timers are fired, the callbacks arming timers leave the compare to it
+    bool m_in_update;
+};
+
+extern TimerService timer_service;
+
+#endif //ARDUINO_TIMERSERVICE_H
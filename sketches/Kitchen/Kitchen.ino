@@ -57,6 +57,8 @@ void loop()
 {
     button.process();
     leds_process();
+    storage_process();
+    LOGGING_PROCESS();
 }
 
 void on_btn_short_release(void *)
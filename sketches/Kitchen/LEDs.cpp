@@ -1,82 +1,81 @@
 #include "LEDs.h"
 
-#include <LEDFader.h>
+#include <LEDFaderGroup.h>
 #include <Logging.h>
 
 #include "Types.h"
 #include "Parsing.h"
 #include "Networking.h"
+#include "Sequence.h"
 
 #define PIN_IN_RED      3
 #define PIN_IN_GREEN    5
 #define PIN_IN_BLUE     6
 #define PIN_IN_WHITE    9
 
-static struct TransitionRunning
+static struct SequenceRunning
 {
     bool running;
-    Transition transition;
-    bool direction;
-} trans_run[LedType::TYPES_MAX_SIZE];
+    bool appending;
+    StepSequence sequence;
+} seq_run[LedType::TYPES_MAX_SIZE];
 
-LEDFader ledR(PIN_IN_RED);
-LEDFader ledG(PIN_IN_GREEN);
-LEDFader ledB(PIN_IN_BLUE);
-LEDFader ledW(PIN_IN_WHITE);
+static const uint8_t color_pins[] = {PIN_IN_RED, PIN_IN_GREEN, PIN_IN_BLUE};
+static const uint8_t white_pins[] = {PIN_IN_WHITE};
 
-static void led_process_loop();
+LEDFaderGroup<3> leds_color(color_pins);
+LEDFaderGroup<1> leds_white(white_pins);
+
+static void on_color_fade_complete(void * data);
+static void on_white_fade_complete(void * data);
 
 void leds_reset()
 {
-    memset(trans_run, 0, sizeof(trans_run));
+    memset(seq_run, 0, sizeof(seq_run));
 }
 
 void leds_setup()
 {
     leds_reset();
+    leds_color.on_complete(on_color_fade_complete, nullptr);
+    leds_white.on_complete(on_white_fade_complete, nullptr);
     switch_leds_off();
 }
 
 void leds_process()
 {
-    ledR.update();
-    ledG.update();
-    ledB.update();
-    ledW.update();
-
-    led_process_loop();
+    unsigned long now = millis();
+    leds_color.update(now);
+    leds_white.update(now);
 }
 
 void leds_color_fade(const RGBW & start, const RGBW & stop, unsigned long time)
 {
     LOG_INFO("LEDs are fading R=0x%x, G=0x%x, B=0x%x => R=0x%x, G=0x%x, B=0x%x, time=%lums",
              start.R, start.G, start.B, stop.R, stop.G, stop.B, time);
-    ledR.set_value(start.R);
-    ledG.set_value(start.G);
-    ledB.set_value(start.B);
-    ledR.fade(stop.R, time);
-    ledG.fade(stop.G, time);
-    ledB.fade(stop.B, time);
+    const uint8_t from[] = {start.R, start.G, start.B};
+    const uint8_t to[] = {stop.R, stop.G, stop.B};
+    leds_color.set_values(from);
+    leds_color.fade(to, time);
 }
 
 void leds_white_fade(const RGBW & start, const RGBW & stop, unsigned long time)
 {
     LOG_INFO("LEDs are fading W=0x%x => W=0x%x, time=%lums", start.W, stop.W, time);
-    ledW.set_value(start.W);
-    ledW.fade(stop.W, time);
+    leds_white.set_values(&start.W);
+    leds_white.fade(&stop.W, time);
 }
 
 void leds_color_fade(byte R, byte G, byte B, unsigned long time)
 {
-    ledR.fade(R, time);
-    ledG.fade(G, time);
-    ledB.fade(B, time);
+    const uint8_t to[] = {R, G, B};
+    leds_color.fade(to, time);
     LOG_INFO("LEDs are fading to R=0x%x, G=0x%x, B=0x%x, time=%lums", R, G, B, time);
 }
 
 void leds_white_fade(byte W, unsigned long time)
 {
-    ledW.fade(W, time);
+    leds_white.fade(&W, time);
     LOG_INFO("LED are fading to W=0x%x, time=%lums", W, time);
 }
 
@@ -100,69 +99,95 @@ void switch_white_leds_off()
 
 RGBW led_values()
 {
-    return RGBW{ledR.get_value(), ledG.get_value(), ledB.get_value(), ledW.get_value()};
+    return RGBW{leds_color.get_value(0), leds_color.get_value(1), leds_color.get_value(2), leds_white.get_value(0)};
 };
 
 bool leds_is_transition(LedType led_type)
 {
-    return trans_run[led_type].running;
+    return seq_run[led_type].running;
 }
 
 void leds_set_transition(LedType led_type, const Transition & transition_)
 {
-    trans_run[led_type].transition = transition_;
+    sequence_from_transition(seq_run[led_type].sequence, transition_);
+    seq_run[led_type].appending = false;
 }
 
-void leds_start_transition(LedType led_type, bool start)
+bool leds_add_keyframe(LedType led_type, const Keyframe & keyframe)
 {
-    if (start) {
-        auto trans = trans_run[led_type].transition;
-        if (led_type == LedType::Color) {
-            leds_color_fade(trans.start, trans.stop, trans.time);
-        }
-        else if (led_type == LedType::White) {
-            leds_white_fade(trans.start, trans.stop, trans.time);
-        }
-
-        trans_run[led_type].direction = true;
+    auto & run = seq_run[led_type];
 
+    // The first keyframe after a program has been run starts a new one
+    if (!run.appending) {
+        leds_start_transition(led_type, false);
+        sequence_clear(run.sequence);
+        run.appending = true;
     }
-    trans_run[led_type].running = start;
-}
 
-static bool is_leds_has_colors(const RGBW & color)
-{
-    return ledR.get_value() == color.R && ledG.get_value() == color.G && ledB.get_value() == color.B;
+    return sequence_add_keyframe(run.sequence, keyframe);
 }
 
-static bool is_leds_has_white(const RGBW & color)
+void leds_run_sequence(LedType led_type, SequenceMode mode)
 {
-    return ledW.get_value() == color.W;
+    seq_run[led_type].sequence.mode = mode;
+    leds_start_transition(led_type, true);
 }
 
-static void led_process_loop()
+static bool leds_sequence_next(LedType led_type)
 {
-    auto & trans_color = trans_run[LedType::Color];
-    if (trans_color.running && trans_color.transition.is_loop) {
-        if (trans_color.direction && is_leds_has_colors(trans_color.transition.stop)) {
-            leds_color_fade(trans_color.transition.stop, trans_color.transition.start, trans_color.transition.time);
-            trans_color.direction = false;
+    SequenceFade fade;
+    if (!sequence_next(seq_run[led_type].sequence, fade)) {
+        return false;
+    }
+
+    if (led_type == LedType::Color) {
+        if (fade.from) {
+            leds_color_fade(*fade.from, fade.to, fade.time);
         }
-        else if (!trans_color.direction && is_leds_has_colors(trans_color.transition.start)) {
-            leds_color_fade(trans_color.transition.start, trans_color.transition.stop, trans_color.transition.time);
-            trans_color.direction = true;
+        else {
+            leds_color_fade(fade.to.R, fade.to.G, fade.to.B, fade.time);
         }
     }
-
-    auto & trans_white = trans_run[LedType::White];
-    if (trans_white.running && trans_white.transition.is_loop) {
-        if (trans_white.direction && is_leds_has_white(trans_white.transition.stop)) {
-            leds_white_fade(trans_white.transition.stop, trans_white.transition.start, trans_white.transition.time);
-            trans_white.direction = false;
+    else if (led_type == LedType::White) {
+        if (fade.from) {
+            leds_white_fade(*fade.from, fade.to, fade.time);
         }
-        else if (!trans_white.direction && is_leds_has_white(trans_white.transition.start)) {
-            leds_white_fade(trans_white.transition.start, trans_white.transition.stop, trans_white.transition.time);
-            trans_white.direction = true;
+        else {
+            leds_white_fade(fade.to.W, fade.time);
         }
     }
+    return true;
+}
+
+void leds_start_transition(LedType led_type, bool start)
+{
+    auto & run = seq_run[led_type];
+    run.appending = false;
+
+    if (start) {
+        sequence_rewind(run.sequence);
+        start = leds_sequence_next(led_type);
+    }
+    run.running = start;
+}
+
+void leds_fade_complete(LedType led_type)
+{
+    auto & run = seq_run[led_type];
+    if (!run.running) {
+        return;
+    }
+
+    // A segment has ended, the next one is already in the table
+    run.running = leds_sequence_next(led_type);
+}
+
+static void on_color_fade_complete(void * data)
+{
+    leds_fade_complete(LedType::Color);
+}
+
+static void on_white_fade_complete(void * data)
+{
+    leds_fade_complete(LedType::White);
 }
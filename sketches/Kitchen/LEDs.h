@@ -26,5 +26,9 @@ bool leds_is_transition(LedType led_type);
 
 void leds_set_transition(LedType led_type, const Transition & transition_);
 void leds_start_transition(LedType led_type, bool start);
+void leds_fade_complete(LedType led_type);
+
+bool leds_add_keyframe(LedType led_type, const Keyframe & keyframe);
+void leds_run_sequence(LedType led_type, SequenceMode mode);
 
 #endif //ARDUINO_LEDS_H
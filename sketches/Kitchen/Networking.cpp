@@ -62,6 +62,29 @@ void on_message_set_transition(uint8_t sensor, const Transition & transition)
     }
 }
 
+void on_message_add_keyframes(uint8_t sensor, const KeyframeList & keyframes)
+{
+    LedType led_type = (sensor == MS_SENSOR_COLOR_LEDS_ID) ? LedType::Color : LedType::White;
+
+    for (uint8_t i = 0; i < keyframes.count; i++) {
+        if (!leds_add_keyframe(led_type, keyframes.items[i])) {
+            break;
+        }
+    }
+}
+
+void on_message_run_sequence(uint8_t sensor, SequenceMode mode)
+{
+    if (sensor == MS_SENSOR_COLOR_LEDS_ID) {
+        leds_run_sequence(LedType::Color, mode);
+        network_send_color_status(true);
+    }
+    else if (sensor == MS_SENSOR_WHITE_LED_ID) {
+        leds_run_sequence(LedType::White, mode);
+        network_send_white_status(true);
+    }
+}
+
 void on_message_light_off(uint8_t sensor)
 {
     if (sensor == MS_SENSOR_COLOR_LEDS_ID) {
@@ -101,11 +124,33 @@ void on_message_light(const MyMessage & message)
     }
 }
 
-void on_message_var1(const MyMessage & message)
+void on_message_command(uint8_t sensor, const CommandData & data)
 {
-    const char * payload = message.getString();
-    LOG_DEBUG("=> Message: sensor=%d, type=%d, data=%s", message.sensor, message.type, payload);
+    switch (data.command) {
+    case Command::LIGHT_SET_EXT_LIMIT:
+        on_message_set_limit(sensor, data.limit, SwitchingSource::External);
+        break;
+    case Command::LIGHT_SET_BUTTON_LIMIT:
+        on_message_set_limit(sensor, data.limit, SwitchingSource::Button);
+        break;
+    case Command::TRANSITION_ONE_SHOT:
+    case Command::TRANSITION_LOOP:
+        on_message_set_transition(sensor, data.transition);
+        break;
+    case Command::SEQUENCE_ADD_KEYFRAME:
+        on_message_add_keyframes(sensor, data.keyframes);
+        break;
+    case Command::SEQUENCE_RUN:
+        on_message_run_sequence(sensor, data.mode);
+        break;
+    default:
+        break;
+    case NONE:break;
+    }
+}
 
+void on_message_var1(const MyMessage & message)
+{
     LedType led_type;
     if (message.sensor == MS_SENSOR_COLOR_LEDS_ID) {
         led_type = LedType::Color;
@@ -118,21 +163,15 @@ void on_message_var1(const MyMessage & message)
         return;
     }
 
-    CommandData data = parse_command(payload, led_type);
-    switch (data.command) {
-    case Command::LIGHT_SET_EXT_LIMIT:
-        on_message_set_limit(message.sensor, data.limit, SwitchingSource::External);
-        break;
-    case Command::LIGHT_SET_BUTTON_LIMIT:
-        on_message_set_limit(message.sensor, data.limit, SwitchingSource::Button);
-        break;
-    case Command::TRANSITION_ONE_SHOT:
-    case Command::TRANSITION_LOOP:
-        on_message_set_transition(message.sensor, data.transition);
-        break;
-    default:
-        break;
-    case NONE:break;
+    // Binary commands first, text ones are kept for controllers that can't send them
+    if (mGetPayloadType(message) == P_CUSTOM) {
+        LOG_DEBUG("=> Message: sensor=%d, type=%d, length=%d", message.sensor, message.type, mGetLength(message));
+        on_message_command(message.sensor, parse_binary_command(message.getCustom(), mGetLength(message), led_type));
+    }
+    else {
+        const char * payload = message.getString();
+        LOG_DEBUG("=> Message: sensor=%d, type=%d, data=%s", message.sensor, message.type, payload);
+        on_message_command(message.sensor, parse_command(payload, led_type));
     }
 }
 
@@ -1,12 +1,31 @@
 #include "Parsing.h"
 
-#include <errno.h>
+#include <avr/pgmspace.h>
 
+// The traces of every command are too much for the serial port
+#define LOG_LEVEL LOG_LEVEL_INFO
 #include <Logging.h>
 #include <LEDFader.h>
 
-#define MAX_FIELD_COUNT 4
+#define MAX_FIELD_COUNT  4
 #define MAX_PAYLOAD_SIZE 50
+#define MAX_ULONG_DIGITS 10
+#define MAX_ULONG_VALUE  0xFFFFFFFFUL
+
+#define HEX_INVALID 0xFF
+#define X HEX_INVALID
+
+// Values of hex digits, indexed by the character from '0' up to 'f'
+static const uint8_t hex_table[] PROGMEM = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9,                                       // '0' - '9'
+    X, X, X, X, X, X, X,                                                // ':' - '@'
+    10, 11, 12, 13, 14, 15,                                             // 'A' - 'F'
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,         // 'G' - 'Z'
+    X, X, X, X, X, X,                                                   // '[' - '`'
+    10, 11, 12, 13, 14, 15,                                             // 'a' - 'f'
+};
+
+#undef X
 
 CommandData::CommandData(Command command_, Transition transition_) :
     command(command_),
@@ -14,128 +33,140 @@ CommandData::CommandData(Command command_, Transition transition_) :
 {
 }
 
+// A token is parsed right in the payload, it isn't copied or terminated
+struct Token
+{
+    const char * data;
+    uint8_t size;
+};
+
 struct Record
 {
     Command command;
-    size_t count;
-    const char *  fields[MAX_FIELD_COUNT];
+    uint8_t count;
+    Token fields[MAX_FIELD_COUNT];
 };
 
+static uint8_t hex_digit(char c)
+{
+    uint8_t index = c - '0';
+    if (index >= sizeof(hex_table)) {
+        return HEX_INVALID;
+    }
+    return pgm_read_byte(&hex_table[index]);
+}
+
 bool hex_to_byte(const char * str, byte & result)
 {
-    result = strtol(str, nullptr, 16);
-    if (errno != 0) {
-        LOG_ERROR("Fail to parse hex to byte: %s", str);
+    uint8_t high = hex_digit(str[0]);
+    uint8_t low = hex_digit(str[1]);
+    if ((high | low) == HEX_INVALID) {
+        LOG_ERROR("Fail to parse hex to byte: %c%c", str[0], str[1]);
         return false;
     }
 
+    result = (high << 4) | low;
     return true;
 }
 
-bool string_to_white(const char * str, RGBW & result)
+bool token_to_white(const Token & token, RGBW & result)
 {
-    size_t len = strlen(str);
-    if (len != 2) {
-        LOG_ERROR("Unexpected length of hex string: %d", len);
+    if (token.size != 2) {
+        LOG_ERROR("Unexpected length of hex string: %d", token.size);
         return false;
     }
 
     result.R = 0;
     result.G = 0;
     result.B = 0;
-    return hex_to_byte(str, result.W);
+    return hex_to_byte(token.data, result.W);
 }
 
-bool string_to_ulong(const char * str, unsigned long & result)
+bool token_to_rgb(const Token & token, RGBW & result)
 {
-    result = strtoul(str, nullptr, 10);
-    if (errno != 0) {
-        LOG_ERROR("Fail to unsigned int in string: %s", str);
+    result = {0, 0, 0, 0};
+
+    if (token.size != 3*2) {
+        LOG_ERROR("Unexpected length of RGB string: %d", token.size);
+        return false;
+    }
+
+    if (!hex_to_byte(token.data, result.R) ||
+        !hex_to_byte(token.data + 2, result.G) ||
+        !hex_to_byte(token.data + 4, result.B)) {
+        LOG_ERROR("Fail to parse RGB in string: %.*s", token.size, token.data);
         return false;
     }
 
     return true;
 }
 
-Record parse_command_string(const char * input)
+// Times are 32 bit on the nodes, the same limit is kept for any other platform
+bool token_to_ulong(const Token & token, unsigned long & result)
 {
-    Record result = {Command::NONE , 0, {}};
-
-    if (!input) {
-        LOG_ERROR("Empty payload");
-        return result;
-    }
-
-    size_t len = strlen(input);
-    if (len < 1) {
-        LOG_ERROR("Too short payload: %d", len);
-        return result;
-    }
-    if (len >= MAX_PAYLOAD_SIZE) {
-        LOG_ERROR("Too long payload: %d", len);
-        return result;
-    }
-
-    if (len > 2 && input[1] != ',') {
-        LOG_ERROR("Wrong format");
-        return result;
-    }
-
-    static char data[MAX_PAYLOAD_SIZE] = {};
-    strncpy(data, input, MAX_PAYLOAD_SIZE);
-
-    result.command = static_cast<Command>(data[0]);
-
-    if (len > 2) {
-        result.fields[0] = &data[2];
-        result.count = 1;
+    if (token.size == 0 || token.size > MAX_ULONG_DIGITS) {
+        LOG_ERROR("Unexpected length of number: %d", token.size);
+        return false;
     }
 
-    for (size_t i = 2; i < len; i++) {
-        if (data[i] == ',') {
-            data[i] = '\0';
-            result.fields[result.count++] = &data[i+1];
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < token.size; i++) {
+        uint8_t digit = token.data[i] - '0';
+        if (digit > 9 || value > (MAX_ULONG_VALUE - digit) / 10) {
+            LOG_ERROR("Fail to parse unsigned int in string: %.*s", token.size, token.data);
+            return false;
         }
+        value = value * 10 + digit;
     }
 
-    return result;
+    result = value;
+    return true;
 }
 
-bool string_to_rgb(const char * str, RGBW & result)
+// Splits the payload into a command and field tokens in one pass, without copying it
+Record parse_command_string(const char * input)
 {
-    result = {0, 0, 0, 0};
+    Record result = {Command::NONE, 0, {}};
 
-    if (!str) {
-        LOG_ERROR("RGB string is NULL");
-        return false;
+    if (!input) {
+        LOG_ERROR("Empty payload");
+        return result;
     }
-
-    size_t len = strlen(str);
-    if (len != 3*2) {
-        LOG_ERROR("Unexpected length of RGB string: %d", len);
-        return false;
+    if (input[0] == '\0') {
+        LOG_ERROR("Too short payload");
+        return result;
     }
 
-    char buffer[7];
-    strncpy(buffer, str, sizeof(buffer));
+    const char * current = input + 1;
+    if (*current == ',') {
+        result.fields[0] = Token{++current, 0};
+        result.count = 1;
 
-    if (!hex_to_byte(buffer+4, result.B)) {
-        LOG_ERROR("Fail to parse B in string: %s", str);
-        return false;
-    }
-    buffer[4] = '\0';
-    if (!hex_to_byte(buffer+2, result.G)) {
-        LOG_ERROR("Fail to parse G in string: %s", str);
-        return false;
+        for (; *current != '\0'; current++) {
+            if (current - input >= MAX_PAYLOAD_SIZE - 1) {
+                LOG_ERROR("Too long payload");
+                return Record{Command::NONE, 0, {}};
+            }
+
+            if (*current != ',') {
+                result.fields[result.count - 1].size++;
+            }
+            else if (result.count < MAX_FIELD_COUNT) {
+                result.fields[result.count++] = Token{current + 1, 0};
+            }
+            else {
+                LOG_ERROR("Too many fields");
+                return Record{Command::NONE, 0, {}};
+            }
+        }
     }
-    buffer[2] = '\0';
-    if (!hex_to_byte(buffer, result.R)) {
-        LOG_ERROR("Fail to parse R in string: %s", str);
-        return false;
+    else if (*current != '\0') {
+        LOG_ERROR("Wrong format");
+        return result;
     }
 
-    result.W = 0;
-    return true;
+    result.command = static_cast<Command>(input[0]);
+    return result;
 }
 
 bool parse_cmd_set_limit(const Record & record, LedType type, RGBW & result)
@@ -146,13 +177,13 @@ bool parse_cmd_set_limit(const Record & record, LedType type, RGBW & result)
     }
 
     if (type == LedType::Color) {
-        if (!string_to_rgb(record.fields[0], result)) {
+        if (!token_to_rgb(record.fields[0], result)) {
             LOG_ERROR("Error parsing transition start value");
             return false;
         };
     }
     else if (type == LedType::White) {
-        if (!string_to_white(record.fields[0], result)) {
+        if (!token_to_white(record.fields[0], result)) {
             LOG_ERROR("Error parsing transition start value");
             return false;
         };
@@ -168,31 +199,31 @@ bool parse_cmd_transition(const Record & record, LedType type, Transition & tran
         return false;
     }
 
-    const char * start = record.fields[0];
-    const char * stop = record.fields[1];
-    const char * time = record.fields[2];
+    const Token & start = record.fields[0];
+    const Token & stop = record.fields[1];
+    const Token & time = record.fields[2];
 
     if (type == LedType::Color) {
-        if (!string_to_rgb(start, transition.start)) {
+        if (!token_to_rgb(start, transition.start)) {
             LOG_ERROR("Error parsing transition start value");
             return false;
         };
-        if (!string_to_rgb(stop, transition.stop)) {
+        if (!token_to_rgb(stop, transition.stop)) {
             LOG_ERROR("Error parsing transition stop value");
             return false;
         };
     }
     else if (type == LedType::White) {
-        if (!string_to_white(start, transition.start)) {
+        if (!token_to_white(start, transition.start)) {
             LOG_ERROR("Error parsing transition start value");
             return false;
         };
-        if (!string_to_white(stop, transition.stop)) {
+        if (!token_to_white(stop, transition.stop)) {
             LOG_ERROR("Error parsing transition stop value");
             return false;
         };
     }
-    if (!string_to_ulong(time, transition.time)) {
+    if (!token_to_ulong(time, transition.time)) {
         LOG_ERROR("Error parsing transition time");
         return false;
     };
@@ -204,13 +235,66 @@ bool parse_cmd_transition(const Record & record, LedType type, Transition & tran
     return true;
 }
 
+bool parse_cmd_keyframe(const Record & record, LedType type, KeyframeList & keyframes)
+{
+    if (record.count != 3) {
+        LOG_ERROR("Wrong data");
+        return false;
+    }
+
+    Keyframe & keyframe = keyframes.items[0];
+    keyframes.count = 1;
+
+    if (type == LedType::Color) {
+        if (!token_to_rgb(record.fields[0], keyframe.color)) {
+            LOG_ERROR("Error parsing keyframe color");
+            return false;
+        };
+    }
+    else if (type == LedType::White) {
+        if (!token_to_white(record.fields[0], keyframe.color)) {
+            LOG_ERROR("Error parsing keyframe white");
+            return false;
+        };
+    }
+    if (!token_to_ulong(record.fields[1], keyframe.time)) {
+        LOG_ERROR("Error parsing keyframe time");
+        return false;
+    }
+
+    unsigned long easing;
+    if (!token_to_ulong(record.fields[2], easing) || easing >= Easing::EASINGS_MAX_SIZE) {
+        LOG_ERROR("Error parsing keyframe easing");
+        return false;
+    }
+    keyframe.easing = static_cast<Easing>(easing);
+
+    return true;
+}
+
+bool parse_cmd_sequence_run(const Record & record, SequenceMode & mode)
+{
+    if (record.count != 1) {
+        LOG_ERROR("Wrong data");
+        return false;
+    }
+
+    unsigned long value;
+    if (!token_to_ulong(record.fields[0], value) || value >= SequenceMode::SEQUENCE_MODES_MAX_SIZE) {
+        LOG_ERROR("Error parsing sequence mode");
+        return false;
+    }
+    mode = static_cast<SequenceMode>(value);
+
+    return true;
+}
+
 CommandData parse_command(const char * payload, LedType led_type)
 {
     LOG_DEBUG("Input: %s", payload);
 
     Record record = parse_command_string(payload);
-    LOG_DEBUG("Parsed: command=%c, count=%d, fields=%s,%s,%s,%s", record.command, record.count,
-              record.fields[0], record.fields[1], record.fields[2], record.fields[3]);
+    LOG_DEBUG("Parsed: command=%c, count=%d", record.command, record.count);
 
     CommandData result{};
 
@@ -228,8 +312,14 @@ CommandData parse_command(const char * payload, LedType led_type)
         res = parse_cmd_transition(record, led_type, result.transition);
         result.transition.is_loop = true;
         break;
+    case Command::SEQUENCE_ADD_KEYFRAME:
+        res = parse_cmd_keyframe(record, led_type, result.keyframes);
+        break;
+    case Command::SEQUENCE_RUN:
+        res = parse_cmd_sequence_run(record, result.mode);
+        break;
     default:
-        LOG_ERROR("Unknown mode: %c", payload[0]);
+        LOG_ERROR("Unknown mode: %c", record.command);
         return CommandData{};
     }
     result.command = record.command;
@@ -248,3 +338,98 @@ CommandData parse_command(const char * payload, LedType led_type)
               result.transition.time);
     return result;
 }
+
+static const uint8_t * decode_color(const uint8_t * data, LedType type, RGBW & color)
+{
+    color = {0, 0, 0, 0};
+    if (type == LedType::Color) {
+        memcpy(&color, data, 3);
+        return data + 3;
+    }
+
+    color.W = data[0];
+    return data + 1;
+}
+
+static const uint8_t * decode_time(const uint8_t * data, unsigned long & time)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    time = value;
+    return data + sizeof(value);
+}
+
+CommandData parse_binary_command(const void * payload, uint8_t length, LedType led_type)
+{
+    const uint8_t * data = static_cast<const uint8_t *>(payload);
+    if (!data || length < 1) {
+        LOG_ERROR("Empty binary payload");
+        return CommandData{};
+    }
+
+    uint8_t color_size = (led_type == LedType::Color) ? 3 : 1;
+    Command command = static_cast<Command>(*data++);
+    length--;
+
+    CommandData result{};
+    switch (command) {
+    case Command::LIGHT_SET_EXT_LIMIT:
+    case Command::LIGHT_SET_BUTTON_LIMIT:
+        if (length != color_size) {
+            LOG_ERROR("Wrong binary limit: length=%d", length);
+            return CommandData{};
+        }
+        decode_color(data, led_type, result.limit);
+        break;
+    case Command::TRANSITION_ONE_SHOT:
+    case Command::TRANSITION_LOOP:
+        if (length != 2 * color_size + sizeof(uint32_t)) {
+            LOG_ERROR("Wrong binary transition: length=%d", length);
+            return CommandData{};
+        }
+        data = decode_color(data, led_type, result.transition.start);
+        data = decode_color(data, led_type, result.transition.stop);
+        decode_time(data, result.transition.time);
+        result.transition.is_loop = (command == Command::TRANSITION_LOOP);
+
+        if (result.transition.time <= LEDFader::MIN_INTERVAL) {
+            LOG_ERROR("Transition time cannot be <= %d", LEDFader::MIN_INTERVAL);
+            return CommandData{};
+        }
+        break;
+    case Command::SEQUENCE_ADD_KEYFRAME: {
+        uint8_t keyframe_size = color_size + sizeof(uint32_t) + 1;
+        uint8_t count = length / keyframe_size;
+        if (count == 0 || count > KEYFRAMES_PER_COMMAND || length % keyframe_size != 0) {
+            LOG_ERROR("Wrong binary keyframes: length=%d", length);
+            return CommandData{};
+        }
+
+        result.keyframes.count = count;
+        for (uint8_t i = 0; i < count; i++) {
+            Keyframe & keyframe = result.keyframes.items[i];
+            data = decode_color(data, led_type, keyframe.color);
+            data = decode_time(data, keyframe.time);
+            if (*data >= Easing::EASINGS_MAX_SIZE) {
+                LOG_ERROR("Wrong binary keyframe easing: %d", *data);
+                return CommandData{};
+            }
+            keyframe.easing = static_cast<Easing>(*data++);
+        }
+        break;
+    }
+    case Command::SEQUENCE_RUN:
+        if (length != 1 || data[0] >= SequenceMode::SEQUENCE_MODES_MAX_SIZE) {
+            LOG_ERROR("Wrong binary sequence run");
+            return CommandData{};
+        }
+        result.mode = static_cast<SequenceMode>(data[0]);
+        break;
+    default:
+        LOG_ERROR("Unknown binary mode: %d", command);
+        return CommandData{};
+    }
+
+    result.command = command;
+    return result;
+}
@@ -3,18 +3,36 @@
 
 #include "Types.h"
 
+#define KEYFRAMES_PER_COMMAND 3
+
+struct KeyframeList
+{
+    uint8_t count;
+    Keyframe items[KEYFRAMES_PER_COMMAND];
+};
+
 struct CommandData
 {
     CommandData(Command command_ = Command::NONE, Transition transition_ = {{0, 0, 0, 0}, {0, 0, 0, 0}, 0, false});
 
     Command command;
     union {
-        RGBW       limit;
-        Transition transition;
+        RGBW         limit;
+        Transition   transition;
+        KeyframeList keyframes;
+        SequenceMode mode;
     };
 };
 
 CommandData parse_command(const char * payload, LedType led_type);
 
+// Binary (P_CUSTOM) commands, little-endian as on the nodes. A color is R, G, B for color leds
+// and W for white leds, a time is uint32_t, an easing or a mode is a byte:
+// - set limit ('0', '1'): command, color
+// - transition ('2', '3'): command, start color, stop color, time - 11 bytes for color leds
+// - keyframes ('4'): command, then up to KEYFRAMES_PER_COMMAND of color, time, easing
+// - run sequence ('5'): command, mode
+CommandData parse_binary_command(const void * payload, uint8_t length, LedType led_type);
+
 #endif // #ifndef ARDUINO_PARSING_H
 
@@ -0,0 +1,122 @@
+#include "Sequence.h"
+
+#include <avr/pgmspace.h>
+
+#include <Logging.h>
+#include <LEDFaderGroup.h>
+
+// Eased progress at the end of each of the EASING_STEPS sub-steps, 255 is the whole segment
+static const uint8_t easing_table[EASINGS_MAX_SIZE][EASING_STEPS] PROGMEM = {
+    {64, 128, 191, 255},    // Linear
+    {16, 64, 143, 255},     // EaseIn, t^2
+    {112, 191, 239, 255},   // EaseOut, 1 - (1 - t)^2
+    {40, 128, 215, 255},    // EaseInOut, 3t^2 - 2t^3
+};
+
+static uint8_t interpolate(uint8_t from, uint8_t to, uint8_t progress)
+{
+    return from + (int16_t)(((int32_t)to - from) * progress / 255);
+}
+
+void sequence_clear(StepSequence & sequence)
+{
+    memset(&sequence, 0, sizeof(sequence));
+}
+
+bool sequence_add_keyframe(StepSequence & sequence, const Keyframe & keyframe)
+{
+    if (sequence.count == 0) {
+        sequence.steps[0] = SequenceStep{keyframe.color, 0};
+        sequence.count = 1;
+        return true;
+    }
+
+    if (keyframe.easing >= EASINGS_MAX_SIZE) {
+        LOG_ERROR("Unknown easing: %d", keyframe.easing);
+        return false;
+    }
+
+    // The faders apply fades up to a fader interval at once, without an end to signal. Such
+    // segments are stretched, and eased ones too short to split are kept linear.
+    unsigned long time = keyframe.time;
+    if (time <= LEDFaderGroup<1>::MIN_INTERVAL) {
+        time = LEDFaderGroup<1>::MIN_INTERVAL + 1;
+    }
+    uint8_t steps = EASING_STEPS;
+    if (keyframe.easing == Easing::Linear || time / EASING_STEPS <= LEDFaderGroup<1>::MIN_INTERVAL) {
+        steps = 1;
+    }
+    if (sequence.count + steps > SEQUENCE_MAX_STEPS) {
+        LOG_ERROR("Sequence is full: steps=%d", sequence.count);
+        return false;
+    }
+
+    const RGBW from = sequence.steps[sequence.count - 1].value;
+    const RGBW & to = keyframe.color;
+    unsigned long step_time = time / steps;
+
+    for (uint8_t i = 0; i < steps; i++) {
+        uint8_t progress = (steps == 1) ? 255 : pgm_read_byte(&easing_table[keyframe.easing][i]);
+
+        SequenceStep & step = sequence.steps[sequence.count++];
+        step.value = RGBW{interpolate(from.R, to.R, progress), interpolate(from.G, to.G, progress),
+                          interpolate(from.B, to.B, progress), interpolate(from.W, to.W, progress)};
+        step.time = (i + 1 < steps) ? step_time : time - step_time * (steps - 1);
+    }
+    return true;
+}
+
+void sequence_from_transition(StepSequence & sequence, const Transition & transition)
+{
+    sequence_clear(sequence);
+    sequence_add_keyframe(sequence, Keyframe{transition.start, 0, Easing::Linear});
+    sequence_add_keyframe(sequence, Keyframe{transition.stop, transition.time, Easing::Linear});
+    sequence.mode = transition.is_loop ? SequenceMode::PingPong : SequenceMode::OneShot;
+}
+
+void sequence_rewind(StepSequence & sequence)
+{
+    sequence.position = 0;
+    sequence.backward = false;
+}
+
+bool sequence_next(StepSequence & sequence, SequenceFade & fade)
+{
+    fade.from = nullptr;
+    if (sequence.count < 2) {
+        return false;
+    }
+
+    if (!sequence.backward && sequence.position + 1 == sequence.count) {
+        switch (sequence.mode) {
+        case SequenceMode::Loop:
+            sequence.position = 0;
+            fade.from = &sequence.steps[0].value;
+            break;
+        case SequenceMode::PingPong:
+            sequence.backward = true;
+            break;
+        default:
+            return false;
+        }
+    }
+    else if (!sequence.backward && sequence.position == 0) {
+        fade.from = &sequence.steps[0].value;
+    }
+
+    // Going back a step takes the time it took to come forward
+    if (sequence.backward) {
+        if (sequence.position > 0) {
+            fade.time = sequence.steps[sequence.position].time;
+            sequence.position--;
+            fade.to = sequence.steps[sequence.position].value;
+            return true;
+        }
+        sequence.backward = false;
+    }
+
+    sequence.position++;
+    fade.to = sequence.steps[sequence.position].value;
+    fade.time = sequence.steps[sequence.position].time;
+    return true;
+}
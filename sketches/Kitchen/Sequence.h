@@ -0,0 +1,42 @@
+#ifndef ARDUINO_SEQUENCE_H
+#define ARDUINO_SEQUENCE_H
+
+#include <Arduino.h>
+
+#include "Types.h"
+
+#define SEQUENCE_MAX_STEPS  16
+#define EASING_STEPS        4
+
+// A keyframe program compiled into straight fades. Eased segments are split into EASING_STEPS
+// linear steps when the keyframe is added, so running the program is just a walk over the table.
+struct SequenceStep
+{
+    RGBW value;
+    unsigned long time;     // of the fade from the previous step
+};
+
+struct StepSequence
+{
+    SequenceMode mode;
+    uint8_t count;
+    uint8_t position;
+    bool backward;
+    SequenceStep steps[SEQUENCE_MAX_STEPS];
+};
+
+struct SequenceFade
+{
+    const RGBW * from;      // set when the LEDs have to jump there before the fade
+    RGBW to;
+    unsigned long time;
+};
+
+void sequence_clear(StepSequence & sequence);
+bool sequence_add_keyframe(StepSequence & sequence, const Keyframe & keyframe);
+void sequence_from_transition(StepSequence & sequence, const Transition & transition);
+
+void sequence_rewind(StepSequence & sequence);
+bool sequence_next(StepSequence & sequence, SequenceFade & fade);
+
+#endif //ARDUINO_SEQUENCE_H
@@ -1,6 +1,8 @@
 #include "Storage.h"
 
 #include <Logging.h>
+#include <EEPROMJournal.h>
+#include <SettingsCache.h>
 
 #include "LEDs.h"
 #include "Networking.h"
@@ -8,17 +10,23 @@
 // Use templates mock class since it's not possible to mock template functions `get` and `put` of EEPROMClass
 #ifdef UNITTESTS
 EEPROMClass<Storage> eeprom;
+typedef EEPROMJournal<Storage, EEPROMClass<Storage>> StorageJournal;
 #else
 EEPROMClass eeprom;
+typedef EEPROMJournal<Storage, EEPROMClass> StorageJournal;
 #endif
 
 void load_storage();
 
 Storage storage = {STORAGE_VERSION, {0, 0, 0, 0}};
 
+StorageJournal journal(eeprom, STORAGE_JOURNAL_ADDRESS, STORAGE_JOURNAL_SLOTS);
+SettingsCache<Storage, StorageJournal> storage_cache(storage, journal, STORAGE_QUIET_TIME_MS);
+
 void storage_reset()
 {
     storage = {STORAGE_VERSION, {0, 0, 0, 0}};
+    storage_cache.discard();
 }
 
 void storage_setup()
@@ -27,23 +35,35 @@ void storage_setup()
     load_storage();
 }
 
+void storage_process()
+{
+    storage_cache.process(millis());
+}
+
 void save_color_leds(SwitchingSource source, byte R, byte G, byte B)
 {
     storage.colors[source].R = R;
     storage.colors[source].G = G;
     storage.colors[source].B = B;
-    eeprom.put(0, storage);
+    storage_cache.touch();
 }
 
 void save_white_leds(SwitchingSource source, byte W)
 {
     storage.colors[source].W = W;
-    eeprom.put(0, storage);
+    storage_cache.touch();
 }
 
 void load_storage()
 {
-    eeprom.get(0, storage);
+    if (!storage_cache.load()) {
+        eeprom.get(STORAGE_LEGACY_ADDRESS, storage);
+        if (storage.version == STORAGE_LEGACY_VERSION) {
+            LOG_INFO("Migrate values from storage version %d", STORAGE_LEGACY_VERSION);
+            storage.version = STORAGE_VERSION;
+            journal.save(storage);
+        }
+    }
     if (storage.version != STORAGE_VERSION) {
         LOG_WARN("Old data format or uninitialized flash memory. Reset to default values");
         storage.version = STORAGE_VERSION;
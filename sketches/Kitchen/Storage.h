@@ -6,10 +6,28 @@
 
 #include "Types.h"
 
-#define STORAGE_VERSION 2
+#define STORAGE_VERSION 3
+
+// Version 2 kept a single record at the start of EEPROM and rewrote it on every save. It is migrated
+// once into the journal.
+#define STORAGE_LEGACY_VERSION 2
+#define STORAGE_LEGACY_ADDRESS 0
+
+// Journal window, above the MySensors config (EEPROM_LOCAL_CONFIG_ADDRESS) and the legacy record.
+// Each slot takes sizeof(Storage) + 3 bytes.
+#ifndef STORAGE_JOURNAL_ADDRESS
+#define STORAGE_JOURNAL_ADDRESS 512
+#endif
+#ifndef STORAGE_JOURNAL_SLOTS
+#define STORAGE_JOURNAL_SLOTS 32
+#endif
+
+// Saves are held back until the values stop changing for this long
+#define STORAGE_QUIET_TIME_MS 2000
 
 void storage_reset();
 void storage_setup();
+void storage_process();
 
 void save_color_leds(SwitchingSource source, byte R, byte G, byte B);
 void save_white_leds(SwitchingSource source, byte W);
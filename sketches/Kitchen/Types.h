@@ -9,7 +9,9 @@ enum Command : char
     LIGHT_SET_EXT_LIMIT     = '0',
     LIGHT_SET_BUTTON_LIMIT  = '1',
     TRANSITION_ONE_SHOT     = '2',
-    TRANSITION_LOOP         = '3'
+    TRANSITION_LOOP         = '3',
+    SEQUENCE_ADD_KEYFRAME   = '4',
+    SEQUENCE_RUN            = '5'
 };
 
 struct RGBW
@@ -48,4 +50,28 @@ struct Transition
     bool is_loop;
 };
 
+enum Easing : uint8_t
+{
+    Linear,
+    EaseIn,
+    EaseOut,
+    EaseInOut,
+    EASINGS_MAX_SIZE
+};
+
+enum SequenceMode : uint8_t
+{
+    OneShot,
+    Loop,
+    PingPong,
+    SEQUENCE_MODES_MAX_SIZE
+};
+
+struct Keyframe
+{
+    RGBW color;
+    unsigned long time;     // of the segment leading to this keyframe, ignored for the first one
+    Easing easing;
+};
+
 #endif //ARDUINO_TYPES_H
@@ -1,7 +1,14 @@
 #include <Arduino.h>
 
 #include <EEPROM.h>
-#include <TimerOne.h>
+#include <FastPin.h>
+#include <EEPROMRecord.h>
+#include <SettingsCache.h>
+#include <PhaseDimmer.h>
+#include <PhaseCurve.h>
+#include <ZeroCrossTracker.h>
+#include <LinearRamp.h>
+#include <TimerService.h>
 #include <Logging.h>
 #include <NewButton.h>
 #include "Relay.h"
@@ -26,14 +33,14 @@
 #define MS_RELAY1_ID            1
 #define MS_RELAY2_ID            2
 
-// This is the delay-per-brightness step in microseconds. It allows for 128 steps
-// If using 60 Hz grid frequency set this to 65
-#define FREQ_STEP               75
+// How the levels map to the firing delays, see PhaseCurve.h. The mains frequency is detected.
+#define DIMMER_CURVE            PHASE_CURVE_CIE
 
-// Delay for transition at button long press
+// Time per level step for transition at button long press
 #define FADE_DELAY_SLOW_MS           50
-// Delay for transition between on and off
+// Time per level step for transition between on and off, can be changed with V_VAR2
 #define FADE_DELAY_FAST_MS           20
+#define FADE_TIME_MAX_MS             60000
 
 #define DIMMER_HIGH   120
 #define DIMMER_MAX    100
@@ -43,6 +50,7 @@
 #define BUTTON_LONG_PRESS_TIME 2000
 
 #define EEPROM_OFFSET 10
+#define EEPROM_QUIET_TIME_MS 2000   // a level is saved once it stops changing for this long
 
 bool button_direction = true;
 
@@ -50,12 +58,21 @@ struct {
     volatile byte actual;
     byte limit;
     byte target;
-    unsigned int delay;
-} dimmer = {DIMMER_MAX, DIMMER_MAX, DIMMER_MAX, FADE_DELAY_SLOW_MS};
+    unsigned long fade_time;    // of the current transition, for the whole DIMMER_HIGH range
+} dimmer = {DIMMER_MAX, DIMMER_MAX, DIMMER_MAX, DIMMER_HIGH * FADE_DELAY_SLOW_MS};
 
-volatile int step_counter = 0;     // Variable to use as a counter of dimming steps. It is volatile since it is passed between interrupts
-volatile bool zero_cross = false;  // Flag to indicate we have crossed zero
-unsigned long dimmer_last_now = 0;
+// The ramp runs in 1/256 of a level step, so the phase delay moves smoothly between the steps
+LinearRamp dimmer_ramp;
+unsigned long dimmer_fade_time = DIMMER_HIGH * FADE_DELAY_FAST_MS;
+
+const FastPinHandle triac_gates[] = {FastPin<PIN_OUT_AC>::handle()};
+PhaseDimmer phase_dimmer{triac_gates, 1, timer_service};
+PhaseCurve dimmer_curve = PhaseCurve::make<DIMMER_CURVE, DIMMER_HIGH>();
+ZeroCrossTracker zero_cross;
+unsigned int dimmer_half_period = ZeroCrossTracker::HALF_PERIOD_50HZ;
+
+EEPROMRecord<byte, decltype(EEPROM)> limit_record{EEPROM, EEPROM_OFFSET};
+SettingsCache<byte, decltype(limit_record)> limit_cache{dimmer.limit, limit_record, EEPROM_QUIET_TIME_MS};
 
 MyMessage msgLampLightStatus(MS_LAMP_ID, V_LIGHT);
 MyMessage msgLampLightLevel(MS_LAMP_ID, V_LIGHT_LEVEL);
@@ -64,32 +81,39 @@ NewButton button{PIN_IN_BUTTON};
 
 NewButton button_relay1{PIN_IN_RELAY1_BUTTON};
 NewButton button_relay2{PIN_IN_RELAY2_BUTTON};
-Relay relays[] = {Relay{button_relay1, PIN_OUT_RELAY1},
-                  Relay{button_relay2, PIN_OUT_RELAY2}};
+Relay relays[] = {Relay{button_relay1, FastPin<PIN_OUT_RELAY1>::handle()},
+                  Relay{button_relay2, FastPin<PIN_OUT_RELAY2>::handle()}};
 
 void on_btn_long_press(void *);
 void on_btn_short_release(void *);
 void on_btn_long_release(void *);
 void eeprom_restore();
+void eeprom_process();
 void on_zero_cross_detect();
-void on_timer_dim_check();
+void dimmer_apply();
+void dimmer_track_mains();
 void dimmer_process();
-void dimmer_switch(bool status, unsigned int delay);
+void dimmer_switch(bool status, unsigned long fade_time);
+void dimmer_jump(byte level);
 void dimmer_level(byte level);
 void send_message(MyMessage & message);
 void on_message_set_light_level(const MyMessage & message);
 void on_message_set_lamp_status(const MyMessage & message);
 void on_message_dump_data(const MyMessage & message);
+void on_message_set_fade_time(const MyMessage & message);
 void on_message_set_relay_status(const MyMessage & message);
 byte light_dimmer_convert(byte level);
 
 void reset()
 {
-    step_counter = 0;
-    dimmer_last_now = 0;
-    zero_cross = false;
     button_direction = true;
     memset(&dimmer, 0, sizeof(dimmer));
+    dimmer_ramp.jump(0);
+    dimmer_fade_time = DIMMER_HIGH * FADE_DELAY_FAST_MS;
+    phase_dimmer.set_delay(0, PhaseDimmer::OFF);
+    zero_cross.reset();
+    dimmer_half_period = ZeroCrossTracker::HALF_PERIOD_50HZ;
+    limit_cache.discard();
     relays[0].set_status(false);
     relays[1].set_status(false);
 }
@@ -119,24 +143,27 @@ void setup()
     button.on_short_release(on_btn_short_release, nullptr);
     button.on_long_release(on_btn_long_release, nullptr);
 
-    LOG_INFO("Pins setup...");
-    pinMode(PIN_OUT_AC, OUTPUT);                          // Set the Triac pin as output
+    LOG_INFO("Dimmer setup...");
+    timer_service.setup();
+    phase_dimmer.setup();
 
     LOG_INFO("Interrupts setup...");
     attachInterrupt(digitalPinToInterrupt(PIN_IN_ZERO_CROSS), on_zero_cross_detect, RISING);
-    Timer1.initialize(FREQ_STEP);                      // Initialize TimerOne library for the freq we need
-    Timer1.attachInterrupt(on_timer_dim_check, FREQ_STEP);      // Go to dim_check procedure every 75 uS (50Hz)  or 65 uS (60Hz)
 
     LOG_INFO("Setup done");
 }
 
 void loop()
 {
+    dimmer_track_mains();
     dimmer_process();
+    eeprom_process();
     button.process();
 
     relays[0].process();
     relays[1].process();
+    timer_service.process();
+    LOGGING_PROCESS();
 }
 
 bool change_button_direction(byte min, byte max)
@@ -166,14 +193,14 @@ void on_btn_long_press(void *)
     else {
         dimmer.target = DIMMER_LOW;
     }
-    dimmer.delay = FADE_DELAY_SLOW_MS;
+    dimmer.fade_time = DIMMER_HIGH * FADE_DELAY_SLOW_MS;
 }
 
 void on_btn_short_release(void *)
 {
     LOG_DEBUG("Button: short release");
     button_direction = change_button_direction(dimmer.limit, DIMMER_HIGH);
-    dimmer_switch(button_direction, FADE_DELAY_FAST_MS);
+    dimmer_switch(button_direction, dimmer_fade_time);
 }
 
 void on_btn_long_release(void *)
@@ -184,48 +211,37 @@ void on_btn_long_release(void *)
 
 void on_zero_cross_detect()
 {
-    zero_cross = true;
-    step_counter = 0;
-    digitalWrite(PIN_OUT_AC, LOW);
-}
-
-void on_timer_dim_check()
-{
-    if (zero_cross && dimmer.actual >= DIMMER_MAX) {
-        if (step_counter >= dimmer.actual) {
-            digitalWrite(PIN_OUT_AC, HIGH);  // turn on light
-            step_counter = 0;  // reset time step counter
-            zero_cross = false;    // reset zero cross detection flag
-        }
-        else {
-            step_counter++;  // increment time step counter
-        }
+    if (zero_cross.on_edge(micros())) {
+        phase_dimmer.on_zero_cross(zero_cross.get_edge_shift());
     }
 }
 
 void eeprom_restore()
 {
-    dimmer.limit = EEPROM.read(EEPROM_OFFSET);
+    limit_cache.load();
     if (dimmer.limit > DIMMER_MAX) {
         dimmer.limit = DIMMER_MAX;
     }
-    dimmer.actual = DIMMER_HIGH;
-    dimmer.target = DIMMER_HIGH;
+    dimmer_jump(DIMMER_HIGH);
     LOG_DEBUG("EEPROM restored: limit=%d", dimmer.limit);
 }
 
-void eeprom_save()
+void eeprom_process()
 {
-    EEPROM.update(EEPROM_OFFSET, dimmer.limit);
-    if (EEPROM.read(EEPROM_OFFSET) != dimmer.limit) {
+    uint8_t failures = limit_record.get_failures();
+    limit_cache.process(millis());
+    if (limit_record.get_failures() != failures) {
         LOG_ERROR("EEPROM write failure");
-        return;
     }
+}
 
-    LOG_DEBUG("EEPROM saved: limit=%d", dimmer.limit);
+void eeprom_save()
+{
+    limit_cache.touch();
+    LOG_DEBUG("EEPROM save scheduled: limit=%d", dimmer.limit);
 }
 
-void dimmer_switch(bool status, unsigned int delay)
+void dimmer_switch(bool status, unsigned long fade_time)
 {
     if (status) {
         dimmer.target = DIMMER_HIGH;
@@ -236,28 +252,57 @@ void dimmer_switch(bool status, unsigned int delay)
         send_message(msgLampLightStatus.set(1));
     }
     LOG_DEBUG("Switch dimmer to %d", dimmer.target);
-    dimmer.delay = delay;
+    dimmer.fade_time = fade_time;
 }
 
-// Going from actual to target level with delay
+// Going from actual to target level. The position is computed from the time since the transition
+// has started, so a slow loop iteration doesn't stretch the fade, the next one catches up.
 void dimmer_process()
 {
+    unsigned long now = millis();
+    int16_t target = (int16_t)dimmer.target << 8;
 
-    bool direction = dimmer.target > dimmer.actual;
-    if (!direction && (dimmer.actual == DIMMER_LOW)) {
-        return;
+    if (target != dimmer_ramp.get_target()) {
+        int16_t from = dimmer_ramp.update(now);
+        unsigned long duration = dimmer.fade_time * abs(target - from) / ((unsigned long)DIMMER_HIGH << 8);
+        dimmer_ramp.start(from, target, duration, now);
     }
-    else if (dimmer.actual == dimmer.target) {
+    else if (!dimmer_ramp.is_running()) {
         return;
     }
 
-    unsigned long now = millis();
-    if (now - dimmer_last_now >= dimmer.delay) {
-        dimmer.actual += (direction ? +1 : -1);
-        dimmer_last_now = now;
+    dimmer_ramp.update(now);
+    dimmer_apply();
+}
+
+// Sets the level at once, without a transition
+void dimmer_jump(byte level)
+{
+    dimmer.target = level;
+    dimmer_ramp.jump((int16_t)level << 8);
+    dimmer_apply();
+}
+
+// Hands the ramp position over to the triac. At DIMMER_HIGH the lamp is off.
+// Both the level byte and the phase delay (set with interrupts off) are updated atomically.
+void dimmer_apply()
+{
+    int16_t position = dimmer_ramp.get_value();
+    dimmer.actual = (position + 0x80) >> 8;
+    phase_dimmer.set_delay(0, dimmer_curve.get_delay(position, dimmer_half_period));
+}
 
-        LOG_DEBUG("dimmer: %u/%u", dimmer.actual, dimmer.target);
+// Rescales the phase delays once the mains frequency is known
+void dimmer_track_mains()
+{
+    unsigned int half_period = zero_cross.get_nominal_period();
+    if (half_period == dimmer_half_period) {
+        return;
     }
+
+    dimmer_half_period = half_period;
+    dimmer_apply();
+    LOG_INFO("Mains frequency: %d Hz", zero_cross.get_frequency());
 }
 
 void send_message(MyMessage & message)
@@ -279,6 +324,9 @@ void receive(const MyMessage & message)
         else if (message.type == V_VAR1) {
             on_message_dump_data(message);
         }
+        else if (message.type == V_VAR2) {
+            on_message_set_fade_time(message);
+        }
         else {
             LOG_ERROR("Got message with unexpected type: (sensor=%d, type=%d)", message.sensor,
                       message.type);
@@ -320,7 +368,7 @@ void on_message_set_lamp_status(const MyMessage & message)
     bool light_status = message.getBool();
     LOG_DEBUG("=> Message: sensor=%d, type=LIGHT, value=%d", message.sensor, light_status);
 
-    dimmer_switch(!light_status, FADE_DELAY_FAST_MS);
+    dimmer_switch(!light_status, dimmer_fade_time);
 }
 
 void on_message_dump_data(const MyMessage & message)
@@ -330,8 +378,19 @@ void on_message_dump_data(const MyMessage & message)
     LOG_DEBUG("Actual: %d", dimmer.actual);
     LOG_DEBUG("Target: %d", dimmer.target);
     LOG_DEBUG("Max: %d", dimmer.limit);
-    LOG_DEBUG("Delay: %ums", dimmer.delay);
+    LOG_DEBUG("Fade time: %lums, on/off %lums", dimmer.fade_time, dimmer_fade_time);
     LOG_DEBUG("Button direction: %s", button_direction ? "up" : "down");
+    LOG_DEBUG("Mains: %d Hz, half-cycle %uus", zero_cross.get_frequency(), zero_cross.get_period());
+    LOG_DEBUG("Zero cross edges: accepted=%lu, rejected=%lu", zero_cross.get_accepted(), zero_cross.get_rejected());
+}
+
+void on_message_set_fade_time(const MyMessage & message)
+{
+    dimmer_fade_time = message.getULong();
+    if (dimmer_fade_time > FADE_TIME_MAX_MS) {
+        dimmer_fade_time = FADE_TIME_MAX_MS;
+    }
+    LOG_DEBUG("=> Message: sensor=%d, type=VAR2, value=%lu", message.sensor, dimmer_fade_time);
 }
 
 void on_message_set_relay_status(const MyMessage & message)
@@ -2,12 +2,12 @@
 
 #include <Logging.h>
 
-Relay::Relay(NewButton & button, byte output_pin) :
+Relay::Relay(NewButton & button, const FastPinHandle & output) :
     m_status{false},
     m_button(button),
-    m_output_pin{output_pin}
+    m_output(output)
 {
-    pinMode(output_pin, OUTPUT);
+    pinMode(output.pin, OUTPUT);
     m_button.on_short_release(Relay::on_button_short_release, this);
 }
 
@@ -15,7 +15,7 @@ void Relay::set_status(bool on)
 {
     m_status = on;
     LOG_INFO("Set relay output %d to %s", on ? "ON" : "OFF");
-    digitalWrite(m_output_pin, on ? HIGH : LOW);
+    m_output.write(on ? HIGH : LOW);
 }
 
 void Relay::toggle_status()
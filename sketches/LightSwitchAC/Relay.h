@@ -3,11 +3,12 @@
 
 #include <Arduino.h>
 #include <NewButton.h>
+#include <FastPin.h>
 
 class Relay
 {
 public:
-    Relay(NewButton & button, byte output_pin);
+    Relay(NewButton & button, const FastPinHandle & output);
 
     void toggle_status();
     void set_status(bool status);
@@ -20,7 +21,7 @@ private:
     bool m_status;
     NewButton & m_button;
 
-    byte m_output_pin;
+    FastPinHandle m_output;
 };
 
 #endif //ARDUINO_RELAY_H
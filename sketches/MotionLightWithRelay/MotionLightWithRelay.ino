@@ -1,7 +1,10 @@
 #include <Arduino.h>
 #include <Bounce2.h>
-#include <MsTimer2.h>
+#include <FastPin.h>
+#include <AnalogSensor.h>
+#include <RuleEngine.h>
 #include <Logging.h>
+#include <EEPROM.h>
 
 #define MY_RADIO_NRF24
 #include <MySensors.h>
@@ -11,6 +14,7 @@
 #define CHILD_ID_LIGHT  0
 #define CHILD_ID_RELAY  1
 #define CHILD_ID_MOT    2
+#define CHILD_ID_RULES  3
 
 #define LIGHT_SENSOR_ANALOG_PIN     0
 #define DIGITAL_INPUT_SENSOR        3  // The digital input you attached your motion sensor.  (Only 2 and 3 generates interrupt!)
@@ -22,9 +26,35 @@
 #define RELAY_ON 0
 #define RELAY_OFF 1
 
-#define TIMER_DELAY_MS  2 * 60 * 1000U
+#define TIMER_DELAY_MS  (2 * 60 * 1000UL)
+
+// The node sleeps between the events. It wakes up on motion, on the button, when a rule's hold ends,
+// and at least every SLEEP_SLICE_MS to sample the light, then stays awake AWAKE_MS for the debouncer
+// and a burst of the ADC.
+#define SLEEP_SLICE_MS  8000UL
+#define AWAKE_MS        10
+#define WAKE_UP_BY_TIMER    -1
+
+// Messages of the controller are only received awake. The node stays awake for the replies it
+// expects, acks and the time, at most REPLY_TIMEOUT_MS. The commands the controller keeps for the
+// node come in the smart sleep before each status.
+#define REPLY_TIMEOUT_MS    1000
+
+// Light level in %, reported on a change of LIGHT_DEADBAND at most every LIGHT_MIN_INTERVAL_MS
+#define LIGHT_DEADBAND              2
+#define LIGHT_MIN_INTERVAL_MS       (10 * 1000UL)
+
+// Rules uploaded by the controller as V_CUSTOM messages for CHILD_ID_RULES, see RuleEngine.h.
+// They are kept above the MySensors config (EEPROM_LOCAL_CONFIG_ADDRESS) and the 256 saveState() cells.
+#define RULES_ADDRESS       (EEPROM_LOCAL_CONFIG_ADDRESS + 256)
+#define RULE_INPUT_MOTION   0
+#define RULE_INPUT_LIGHT    1
+#define RULE_OUTPUT_RELAY   0
+
+typedef RuleEngine<decltype(EEPROM)> Rules;
 
 Bounce debouncer;
+AnalogSensor light_sensor{LIGHT_SENSOR_ANALOG_PIN, 100, true};
 MyMessage msgMot(CHILD_ID_MOT, V_TRIPPED);
 MyMessage msgLight(CHILD_ID_LIGHT, V_LIGHT_LEVEL);
 MyMessage msgRelay(CHILD_ID_RELAY, V_LIGHT);
@@ -34,11 +64,38 @@ bool button_state = false;
 bool movement_detected = false;
 int light_level = 0;
 
+// millis() stops while sleeping, the time slept is added to it. An interrupted sleep is a guess, the
+// time of the controller corrects the clock once per status period.
+unsigned long slept_ms = 0;
+unsigned long clock_ahead_ms = 0;
+unsigned long synced_time = 0;
+unsigned long synced_clock_ms = 0;
+unsigned long awake_since = 0;
+unsigned long next_status_time = TIMER_DELAY_MS;
+volatile bool button_woke = false;
+uint8_t replies_expected = 0;
+unsigned long replies_since = 0;
+
 void reset();
+void relay_set(bool state);
+void rules_process();
+void rules_receive(const MyMessage & message);
+void on_rule_action(uint8_t output, bool value);
 void movement_sensor_process();
 void light_level_process();
-void on_send_timer();
-void message_send(MyMessage & message, bool request_ack = false);
+void status_send();
+void button_wake_setup();
+void sleep_until_event();
+void slept_add(unsigned long ms);
+void clock_sync(unsigned long time);
+unsigned long clock_ms();
+void time_request();
+void replies_expect(uint8_t count);
+void reply_received();
+bool replies_pending();
+bool message_send(MyMessage & message, bool request_ack = false);
+
+Rules rules{EEPROM, RULES_ADDRESS, on_rule_action};
 
 void setup()
 {
@@ -64,8 +121,13 @@ void setup()
 
     pinMode(DIGITAL_INPUT_SENSOR, INPUT);  // sets the motion sensor digital pin as input
 
-    MsTimer2::set(TIMER_DELAY_MS, on_send_timer);
-    MsTimer2::start();
+    light_sensor.set_reporting(LIGHT_DEADBAND, LIGHT_MIN_INTERVAL_MS, TIMER_DELAY_MS);
+
+    LOG_INFO("Rules loaded: %d", rules.load());
+    // For the time windows of the rules
+    time_request();
+
+    button_wake_setup();
 }
 
 void reset()
@@ -74,6 +136,17 @@ void reset()
     relay_state = false;
     movement_detected = false;
     light_level = 0;
+    light_sensor.reset();
+
+    slept_ms = 0;
+    clock_ahead_ms = 0;
+    synced_time = 0;
+    synced_clock_ms = 0;
+    awake_since = 0;
+    next_status_time = TIMER_DELAY_MS;
+    button_woke = false;
+    replies_expected = 0;
+    replies_since = 0;
 }
 
 void before()
@@ -84,52 +157,85 @@ void before()
 
 void presentation()
 {
-    sendSketchInfo("Balcony Light", "1.2");
+    sendSketchInfo("Balcony Light", "1.3");
     present(CHILD_ID_RELAY, S_LIGHT, "Relay");
     present(CHILD_ID_MOT, S_MOTION, "Motion");
     present(CHILD_ID_LIGHT, S_LIGHT_LEVEL, "LUX");
+    present(CHILD_ID_RULES, S_CUSTOM, "Rules");
 }
 
 void loop()
 {
     movement_sensor_process();
     light_level_process();
+    rules_process();
 
     debouncer.update();
     bool new_button_state = debouncer.read();
     if (new_button_state != button_state && !new_button_state) {
         LOG_INFO("Button has been released");
-        message_send(msgRelay.set(relay_state ? false : true), true);
+        // The controller switches the relay after the ack
+        if (message_send(msgRelay.set(relay_state ? false : true), true)) {
+            replies_expect(1);
+        }
     }
     button_state = new_button_state;
+
+    if ((long)(clock_ms() - next_status_time) >= 0) {
+        next_status_time = clock_ms() + TIMER_DELAY_MS;
+        status_send();
+    }
+    LOGGING_PROCESS();
+
+    if (clock_ms() - awake_since >= AWAKE_MS && !replies_pending()) {
+        sleep_until_event();
+    }
 }
 
 void receive(const MyMessage & message)
 {
     LOG_INFO("=>: sensor=%d, type=%d, is_ack=%d", message.sensor, message.type, message.isAck());
+    reply_received();
 
     if (message.isAck()) {
         LOG_DEBUG("Got ACK from gateway");
         return;
     }
 
+    if (message.sensor == CHILD_ID_RULES && message.type == V_CUSTOM) {
+        rules_receive(message);
+        return;
+    }
+
     if (message.sensor != CHILD_ID_RELAY) {
         LOG_ERROR("Got command %d for non-relay sensor", message.type);
         return;
     }
 
     if (message.type == V_LIGHT) {
-        relay_state = message.getBool();
-        LOG_INFO("Incoming change for the relay: %d", relay_state);
-
-        digitalWrite(RELAY_PIN, relay_state ? RELAY_ON : RELAY_OFF);
-        saveState(CHILD_ID_RELAY, relay_state);
+        LOG_INFO("Incoming change for the relay: %d", message.getBool());
+        relay_set(message.getBool());
     }
 }
 
+void receiveTime(unsigned long time)
+{
+    LOG_INFO("Got time: %lu", time);
+    reply_received();
+    clock_sync(time);
+    rules.set_time(time, clock_ms());
+}
+
+void relay_set(bool state)
+{
+    relay_state = state;
+    FastPin<RELAY_PIN>::write(relay_state ? RELAY_ON : RELAY_OFF);
+    saveState(CHILD_ID_RELAY, relay_state);
+}
+
 void movement_sensor_process()
 {
-    bool new_movement_detected = digitalRead(DIGITAL_INPUT_SENSOR) == HIGH;
+    bool new_movement_detected = FastPin<DIGITAL_INPUT_SENSOR>::read() == HIGH;
 
     if (new_movement_detected && !movement_detected) {
         LOG_INFO("Movement has been started");
@@ -145,28 +251,177 @@ void movement_sensor_process()
 
 void light_level_process()
 {
-    int new_light_level = (1023 - analogRead(LIGHT_SENSOR_ANALOG_PIN)) / 10.23;
-    if (new_light_level != light_level) {
-        LOG_INFO("Light has been changed: %d => %d", light_level, new_light_level);
-        light_level = new_light_level;
+    if (light_sensor.process(clock_ms())) {
+        LOG_INFO("Light level: %d => %d", light_level, light_sensor.get_value());
+        light_level = light_sensor.get_value();
         message_send(msgLight.set(light_level));
     }
 }
 
-void on_send_timer()
+void rules_process()
+{
+    rules.set_input(RULE_INPUT_MOTION, movement_detected);
+    rules.set_input(RULE_INPUT_LIGHT, light_sensor.get_value());
+    rules.process(clock_ms());
+}
+
+void rules_receive(const MyMessage & message)
+{
+    const uint8_t * data = (const uint8_t *)message.getCustom();
+    uint8_t size = mGetLength(message);
+
+    if (!rules.upload(data, size)) {
+        LOG_ERROR("Invalid rule, size=%d", size);
+        return;
+    }
+    LOG_INFO("Rule %d %s", data[0], rules.has_rule(data[0]) ? "stored" : "deleted");
+}
+
+void on_rule_action(uint8_t output, bool value)
+{
+    if (output != RULE_OUTPUT_RELAY) {
+        LOG_ERROR("Rule for unknown output %d", output);
+        return;
+    }
+
+    LOG_INFO("Rule switches the relay: %d", value);
+    relay_set(value);
+    // The controller only learns about it
+    message_send(msgRelay.set(value));
+}
+
+void status_send()
 {
     LOG_INFO("Sending movement status by timer: %d", movement_detected);
     message_send(msgMot.set(movement_detected));
+}
+
+#if defined(__AVR__) && !defined(UNITTESTS)
+// The button, on port D, has no external interrupt, its pin change wakes up the MCU. wakeUp2() of MySensors
+// ends the sleep, else it would go on with the next watchdog period.
+ISR(PCINT2_vect)
+{
+    button_woke = true;
+    wakeUp2();
+}
+#endif
+
+void button_wake_setup()
+{
+#if defined(__AVR__) && !defined(UNITTESTS)
+    *digitalPinToPCMSK(BUTTON_PIN) |= _BV(digitalPinToPCMSKbit(BUTTON_PIN));
+    PCICR |= _BV(digitalPinToPCICRbit(BUTTON_PIN));
+#endif
+}
+
+void sleep_until_event()
+{
+    long until_status = (long)(next_status_time - clock_ms());
+    if (until_status <= 0) {
+        return;
+    }
+    unsigned long sleep_ms = until_status < (long) SLEEP_SLICE_MS ? until_status : SLEEP_SLICE_MS;
+    // A rule sets the relay back when its hold ends
+    unsigned long hold_left = rules.get_hold_left(clock_ms());
+    if (hold_left != 0 && hold_left < sleep_ms) {
+        sleep_ms = hold_left;
+    }
+
+    LOGGING_FLUSH();
+    button_woke = false;
+
+    // The last slice before the status is a smart sleep: the controller gets a heartbeat and, in the
+    // wait before the sleep, sends the relay commands it kept meanwhile and the time asked here
+    int8_t woken;
+    if ((long) sleep_ms == until_status) {
+        requestTime();
+        woken = smartSleep(INTERRUPT, CHANGE, sleep_ms);
+    }
+    else {
+        woken = sleep(INTERRUPT, CHANGE, sleep_ms);
+    }
+
+    // MySensors doesn't tell how long an interrupted sleep was, half of it is the guess. The error
+    // is at most SLEEP_SLICE_MS / 2 per wake up, until the next time of the controller.
+    slept_add(woken == WAKE_UP_BY_TIMER && !button_woke ? sleep_ms : sleep_ms / 2);
+    awake_since = clock_ms();
+}
+
+void slept_add(unsigned long ms)
+{
+    // The clock never goes back, the users of it count intervals. When it's ahead, it stands still
+    // instead.
+    unsigned long absorbed = ms < clock_ahead_ms ? ms : clock_ahead_ms;
+    clock_ahead_ms -= absorbed;
+    slept_ms += ms - absorbed;
+}
+
+void clock_sync(unsigned long time)
+{
+    if (synced_time != 0) {
+        long error = (long)((time - synced_time) * 1000UL - (clock_ms() - synced_clock_ms));
+        LOG_INFO("Clock error: %ld ms", error);
+        if (error >= 0) {
+            slept_ms += error;
+            clock_ahead_ms = 0;
+        }
+        else {
+            clock_ahead_ms = -error;
+        }
+    }
+    synced_time = time;
+    synced_clock_ms = clock_ms() - clock_ahead_ms;
+}
+
+unsigned long clock_ms()
+{
+    return millis() + slept_ms;
+}
+
+void time_request()
+{
+    requestTime();
+    replies_expect(1);
+}
+
+void replies_expect(uint8_t count)
+{
+    if (replies_expected == 0) {
+        replies_since = clock_ms();
+    }
+    replies_expected += count;
+}
+
+void reply_received()
+{
+    if (replies_expected > 0) {
+        replies_expected--;
+    }
+}
 
-    LOG_INFO("Sending light level by timer: %d", light_level);
-    message_send(msgLight.set(light_level));
+bool replies_pending()
+{
+    if (replies_expected == 0) {
+        return false;
+    }
+    if (clock_ms() - replies_since < REPLY_TIMEOUT_MS) {
+        return true;
+    }
+    LOG_ERROR("No reply of the controller, %d missed", replies_expected);
+    replies_expected = 0;
+    return false;
 }
 
-void message_send(MyMessage & message, bool request_ack)
+bool message_send(MyMessage & message, bool request_ack)
 {
     LOG_INFO("<= sensor=%d, type=%d", message.sensor, message.type);
 
     if (!send(message, request_ack)) {
         LOG_ERROR("Message (sensor=%d, type=%d) doesn't reach a next node", message.sensor, message.type);
+        return false;
+    }
+    if (request_ack) {
+        replies_expect(1);
     }
+    return true;
 }
@@ -10,10 +10,16 @@
 #define INPUT 0x0
 #define OUTPUT 0x1
 
-#define CHANGE 1                                                                                                                                                                                                    ▓
-#define FALLING 2                                                                                                                                                                                                   ▓
+#define CHANGE 1
+#define FALLING 2
 #define RISING 3
 
+// -1 in Arduino, the mocked digitalPinToInterrupt() returns uint8_t
+#define NOT_AN_INTERRUPT 0xFF
+
+#define interrupts()
+#define noInterrupts()
+
 #define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
 
 typedef uint8_t byte;
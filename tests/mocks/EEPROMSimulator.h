@@ -0,0 +1,90 @@
+#ifndef ARDUINO_EEPROMSIMULATOR_H
+#define ARDUINO_EEPROMSIMULATOR_H
+
+#include <stdint.h>
+#include <string.h>
+
+// In-memory EEPROM that counts writes per cell, to check how storage code wears the cells
+template <int SIZE = 1024>
+class EEPROMSimulator
+{
+public:
+    EEPROMSimulator()
+    {
+        erase();
+    }
+
+    void erase(uint8_t value = 0xFF)
+    {
+        memset(m_cells, value, sizeof(m_cells));
+        memset(m_writes, 0, sizeof(m_writes));
+        m_worn_out = -1;
+    }
+
+    // The cell keeps its value from now on, as a cell past its write endurance may
+    void wear_out(int idx)
+    {
+        m_worn_out = idx;
+    }
+
+    uint8_t read(int idx) const
+    {
+        return m_cells[idx];
+    }
+
+    void write(int idx, uint8_t val)
+    {
+        if (idx != m_worn_out) {
+            m_cells[idx] = val;
+        }
+        m_writes[idx]++;
+    }
+
+    void update(int idx, uint8_t val)
+    {
+        if (m_cells[idx] != val) {
+            write(idx, val);
+        }
+    }
+
+    template <typename T>
+    T & get(int idx, T & t) const
+    {
+        memcpy(&t, m_cells + idx, sizeof(T));
+        return t;
+    }
+
+    // Same as the Arduino library, `put` is made of `update`s
+    template <typename T>
+    const T & put(int idx, const T & t)
+    {
+        const uint8_t * ptr = (const uint8_t *)&t;
+        for (unsigned int i = 0; i < sizeof(T); i++) {
+            update(idx + i, ptr[i]);
+        }
+        return t;
+    }
+
+    unsigned long writes(int idx) const
+    {
+        return m_writes[idx];
+    }
+
+    unsigned long max_writes() const
+    {
+        unsigned long result = 0;
+        for (int i = 0; i < SIZE; i++) {
+            if (m_writes[i] > result) {
+                result = m_writes[i];
+            }
+        }
+        return result;
+    }
+
+private:
+    uint8_t m_cells[SIZE];
+    unsigned long m_writes[SIZE];
+    int m_worn_out;
+};
+
+#endif //ARDUINO_EEPROMSIMULATOR_H
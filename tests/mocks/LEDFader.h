@@ -15,6 +15,7 @@ public:
     LEDFader(uint8_t pwm_pin)
     {
         ON_CALL(*this, update()).WillByDefault(Return(true));
+        ON_CALL(*this, update(_)).WillByDefault(Return(true));
         allow(this);
     }
 
@@ -30,6 +31,7 @@ public:
 
     MOCK_METHOD0(stop_fade, bool());
     MOCK_METHOD0(update, bool());
+    MOCK_METHOD1(update, bool(unsigned long now));
     MOCK_METHOD1(slower, void(int by_seconds));
     MOCK_METHOD1(faster, void(int by_seconds));
     MOCK_METHOD0(get_progress, uint8_t());
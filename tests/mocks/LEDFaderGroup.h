@@ -0,0 +1,51 @@
+#ifndef ARDUINO_LEDFADERGROUP_H
+#define ARDUINO_LEDFADERGROUP_H
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "base/NiceMock.h"
+#include "Arduino.h"
+
+using namespace testing;
+
+template <uint8_t N>
+class LEDFaderGroup : public NiceMock<void>
+{
+public:
+    static const byte MIN_INTERVAL = 20;
+
+    typedef void (* on_complete_t)(void * user_data);
+
+    LEDFaderGroup(const uint8_t (&pwm_pins)[N])
+    {
+        ON_CALL(*this, update()).WillByDefault(Return(true));
+        ON_CALL(*this, update(_)).WillByDefault(Return(true));
+        allow(this);
+    }
+
+    // Raw arrays can't be matched, so they are passed on to the mocks as vectors
+    void set_values(const uint8_t * values)
+    {
+        set_values(std::vector<uint8_t>(values, values + N));
+    }
+
+    void fade(const uint8_t * values, unsigned long time)
+    {
+        fade(std::vector<uint8_t>(values, values + N), time);
+    }
+
+    MOCK_METHOD1_T(set_values, void(std::vector<uint8_t> values));
+    MOCK_METHOD1_T(get_value, uint8_t(uint8_t channel));
+    MOCK_METHOD2_T(on_complete, void(on_complete_t callback, void * user_data));
+
+    MOCK_METHOD2_T(fade, void(std::vector<uint8_t> values, unsigned long time));
+    MOCK_METHOD0_T(is_fading, bool());
+
+    MOCK_METHOD0_T(stop_fade, void());
+    MOCK_METHOD0_T(update, bool());
+    MOCK_METHOD1_T(update, bool(unsigned long now));
+    MOCK_METHOD0_T(get_progress, uint8_t());
+};
+
+#endif //ARDUINO_LEDFADERGROUP_H
@@ -2,6 +2,8 @@
 #define ARDUINO_LOGGING_H
 
 #define LOGGING_SETUP(_speed)
+#define LOGGING_PROCESS()
+#define LOGGING_FLUSH()
 #define LOG_DEBUG(_msg, ...)
 #define LOG_INFO(_msg, ...)
 #define LOG_WARN(_msg, ...)
@@ -1,6 +1,8 @@
 #include "MySensors.h"
 
 MyMessage::MyMessage() :
+    version_length{0},
+    command_ack_payload{0},
     sensor{0},
     type{0},
     m_data{},
@@ -9,6 +11,8 @@ MyMessage::MyMessage() :
 }
 
 MyMessage::MyMessage(uint8_t sensor_, uint8_t type_) :
+    version_length{0},
+    command_ack_payload{0},
     sensor{sensor_},
     type{type_},
     m_data{},
@@ -100,6 +104,8 @@ MyMessage & MyMessage::set(void * payload, uint8_t length)
     }
 
     memcpy(m_data.data, payload, length);
+    mSetLength((*this), length);
+    mSetPayloadType((*this), P_CUSTOM);
     return *this;
 }
 
@@ -110,6 +116,8 @@ MyMessage & MyMessage::set(const char * value)
     }
 
     strncpy(m_data.data, value, sizeof(m_data));
+    mSetLength((*this), strlen(value));
+    mSetPayloadType((*this), P_STRING);
     return *this;
 }
 
@@ -203,10 +211,29 @@ bool send(MyMessage & msg, bool ack)
     return MySensorsMock::mock().send(msg, ack);
 }
 
+int8_t sleep(uint8_t interrupt, uint8_t mode, unsigned long ms)
+{
+    return MySensorsMock::mock().sleep(interrupt, mode, ms);
+}
+
+int8_t smartSleep(uint8_t interrupt, uint8_t mode, unsigned long ms)
+{
+    return MySensorsMock::mock().smartSleep(interrupt, mode, ms);
+}
+
+void requestTime()
+{
+    MySensorsMock::mock().requestTime();
+}
+
 MySensorsMock::MySensorsMock()
 {
     ON_CALL(mock(), loadState(_)).WillByDefault(Return(0));
     ON_CALL(mock(), saveState(_, _)).WillByDefault(Return());
     ON_CALL(mock(), present(_, _, _, _)).WillByDefault(Return());
     ON_CALL(mock(), sendSketchInfo(_, _, _)).WillByDefault(Return());
+    // Woken up by the timer
+    ON_CALL(mock(), sleep(_, _, _)).WillByDefault(Return(-1));
+    ON_CALL(mock(), smartSleep(_, _, _)).WillByDefault(Return(-1));
+    ON_CALL(mock(), requestTime()).WillByDefault(Return());
 }
@@ -12,6 +12,8 @@ using namespace testing;
 #define MAX_MESSAGE_LENGTH 32 //!< The maximum size of a message (including header)
 #define HEADER_SIZE 7         //!< The size of the header
 #define MAX_PAYLOAD (MAX_MESSAGE_LENGTH - HEADER_SIZE) //!< The maximum size of a payload depends on #MAX_MESSAGE_LENGTH and #HEADER_SIZE
+#define MY_SMART_SLEEP_WAIT_DURATION 500 //!< The wait period before going to sleep when using smartSleep-functions
+#define EEPROM_LOCAL_CONFIG_ADDRESS 413 //!< First free address for sketch static configuration
 
 typedef enum
 {
@@ -122,6 +124,32 @@ typedef enum
     V_POWER_FACTOR = 56,
 } mysensor_data;
 
+typedef enum
+{
+    P_STRING = 0,
+    P_BYTE = 1,
+    P_INT16 = 2,
+    P_UINT16 = 3,
+    P_LONG32 = 4,
+    P_ULONG32 = 5,
+    P_CUSTOM = 6,
+    P_FLOAT32 = 7
+} mysensor_payload;
+
+#define BIT(n)                  ( 1<<(n) )
+#define BIT_MASK(len)           ( BIT(len)-1 )
+#define BF_MASK(start, len)     ( BIT_MASK(len)<<(start) )
+
+#define BF_PREP(x, start, len)  ( ((x)&BIT_MASK(len)) << (start) )
+#define BF_GET(y, start, len)   ( ((y)>>(start)) & BIT_MASK(len) )
+#define BF_SET(y, x, start, len)    ( y= ((y) &~ BF_MASK(start, len)) | BF_PREP(x, start, len) )
+
+#define mSetLength(_msg,_length) BF_SET(_msg.version_length, _length, 3, 5)
+#define mGetLength(_msg) ((uint8_t)BF_GET(_msg.version_length, 3, 5))
+
+#define mSetPayloadType(_msg, _pt) BF_SET(_msg.command_ack_payload, _pt, 5, 3)
+#define mGetPayloadType(_msg) ((uint8_t)BF_GET(_msg.command_ack_payload, 5, 3))
+
 class MyMessage
 {
 public:
@@ -164,6 +192,9 @@ public:
     uint8_t sender;
     uint8_t destination;
 
+    uint8_t version_length;
+    uint8_t command_ack_payload;
+
     uint8_t sensor;
     uint8_t type;
 
@@ -199,6 +230,9 @@ public:
     MOCK_METHOD4(present, void(uint8_t sensorId, uint8_t sensorType, const char * description, bool ack));
     MOCK_METHOD3(sendSketchInfo, void(const char * name, const char * version, bool ack));
     MOCK_METHOD2(send, bool(MyMessage & msg, bool ack));
+    MOCK_METHOD3(sleep, int8_t(uint8_t interrupt, uint8_t mode, unsigned long ms));
+    MOCK_METHOD3(smartSleep, int8_t(uint8_t interrupt, uint8_t mode, unsigned long ms));
+    MOCK_METHOD0(requestTime, void());
 };
 
 uint8_t loadState(uint8_t pos);
@@ -206,5 +240,8 @@ void saveState(uint8_t pos, uint8_t value);
 void present(uint8_t sensorId, uint8_t sensorType, const char * description = "", bool ack = false);
 void sendSketchInfo(const char * name, const char * version, bool ack = false);
 bool send(MyMessage & msg, bool ack = false);
+int8_t sleep(uint8_t interrupt, uint8_t mode, unsigned long ms = 0);
+int8_t smartSleep(uint8_t interrupt, uint8_t mode, unsigned long ms = 0);
+void requestTime();
 
 #endif //ARDUINO_MYSENSORS_H
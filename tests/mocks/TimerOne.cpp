@@ -0,0 +1,3 @@
+#include "TimerOne.h"
+
+TimerOneMock Timer1;
@@ -2,11 +2,26 @@
 #define ARDUINO_TIMERONE_H
 
 #include "gmock/gmock.h"
-//#include "base/StaticMock.h"
+#include <base/NiceMock.h>
 
-class TimerOneMock// : public StaticMock<TimerOneMock>
+class TimerOneMock : public testing::NiceMock<void>
 {
 public:
+    TimerOneMock()
+    {
+        allow(this);
+    }
+
+    // Default arguments of the library
+    void initialize()
+    {
+        initialize(1000000);
+    }
+    void attachInterrupt(void (*isr)())
+    {
+        attachInterrupt(isr, -1);
+    }
+
     MOCK_METHOD1(initialize, void(long microseconds));
     MOCK_METHOD0(start, void());
     MOCK_METHOD0(stop, void());
@@ -21,6 +36,6 @@ public:
     MOCK_METHOD2(setPwmDuty, void(char pin, int duty));
 };
 
-static TimerOneMock Timer1;
+extern TimerOneMock Timer1;
 
 #endif //ARDUINO_TIMERONE_H
@@ -0,0 +1,11 @@
+#ifndef ARDUINO_AVR_PGMSPACE_H
+#define ARDUINO_AVR_PGMSPACE_H
+
+#include <stdint.h>
+
+#define PROGMEM
+
+#define pgm_read_byte(_addr) (*(const uint8_t *)(_addr))
+#define pgm_read_word(_addr) (*(const uint16_t *)(_addr))
+
+#endif //ARDUINO_AVR_PGMSPACE_H
@@ -0,0 +1,183 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <Arduino.h>
+
+#include "AnalogSensor/AnalogSensor.h"
+
+using namespace ::testing;
+
+#define PIN 3
+
+class AnalogSensorTests : public testing::Test
+{
+public:
+    AnalogSensorTests() :
+        now{0},
+        sensor{PIN, 100}
+    {
+        ON_CALL(ArduinoMock::mock(), millis()).WillByDefault(Invoke([this]() {
+            return now;
+        }));
+        ON_CALL(ArduinoMock::mock(), analogRead(PIN)).WillByDefault(Return(0));
+        sensor.set_reporting(5, 1000, 60000);
+    }
+
+    ~AnalogSensorTests()
+    {
+        Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    }
+
+    void read(int value)
+    {
+        EXPECT_CALL(ArduinoMock::mock(), analogRead(PIN)).WillRepeatedly(Return(value));
+    }
+
+    unsigned long now;
+    AnalogSensor sensor;
+};
+
+TEST_F(AnalogSensorTests, scales_to_range)
+{
+    read(1023);
+    EXPECT_TRUE(sensor.process());
+    EXPECT_EQ(100, sensor.get_value());
+
+    AnalogSensor inverted{PIN, 100, true};
+    EXPECT_TRUE(inverted.process());
+    EXPECT_EQ(0, inverted.get_value());
+
+    read(512);
+    AnalogSensor wide{PIN, 1000};
+    EXPECT_TRUE(wide.process());
+    EXPECT_EQ(500, wide.get_value());
+}
+
+TEST_F(AnalogSensorTests, oversampling_averages_block)
+{
+    // Half of the samples at 0 and half at 1023, in one block
+    int sample = 0;
+    EXPECT_CALL(ArduinoMock::mock(), analogRead(PIN)).Times(AnalogSensor::SAMPLES).WillRepeatedly(
+        Invoke([&sample](uint8_t) {
+            return sample++ % 2 ? 1023 : 0;
+        }));
+
+    EXPECT_TRUE(sensor.process());
+    EXPECT_EQ(50, sensor.get_value());
+}
+
+TEST_F(AnalogSensorTests, samples_from_interrupt_make_block)
+{
+    AnalogSensor interrupted{PIN, AnalogSensor::FULL_SCALE};
+
+    for (uint8_t i = 0; i < AnalogSensor::SAMPLES - 1; i++) {
+        interrupted.on_sample(i % 2 ? 1 : 2);
+    }
+    interrupted.on_sample(1);
+
+    // The decimated block keeps the fraction the ADC alone can't see
+    read(0);
+    EXPECT_TRUE(interrupted.process());
+    EXPECT_EQ(6, interrupted.get_value());
+}
+
+TEST_F(AnalogSensorTests, one_block_per_process)
+{
+    EXPECT_CALL(ArduinoMock::mock(), analogRead(PIN)).Times(AnalogSensor::SAMPLES).WillRepeatedly(Return(0));
+    EXPECT_TRUE(sensor.process());
+    Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+
+    // No sampling between the calls
+    EXPECT_CALL(ArduinoMock::mock(), analogRead(PIN)).Times(AnalogSensor::SAMPLES).WillRepeatedly(Return(0));
+    now = 100000;
+    EXPECT_TRUE(sensor.process());
+}
+
+TEST_F(AnalogSensorTests, sensors_take_turns)
+{
+    AnalogSensor other{PIN + 1, 100};
+
+    EXPECT_CALL(ArduinoMock::mock(), analogRead(PIN + 1)).WillRepeatedly(Return(1023));
+    read(0);
+    EXPECT_TRUE(sensor.process());
+    EXPECT_TRUE(other.process());
+
+    EXPECT_EQ(0, sensor.get_value());
+    EXPECT_EQ(100, other.get_value());
+}
+
+TEST_F(AnalogSensorTests, reports_changes_beyond_deadband)
+{
+    read(0);
+    EXPECT_TRUE(sensor.process());
+
+    now = 2000;
+    read(41);   // 4%
+    EXPECT_FALSE(sensor.process());
+    EXPECT_EQ(4, sensor.get_value());
+
+    read(51);   // 5%
+    EXPECT_TRUE(sensor.process());
+    EXPECT_EQ(5, sensor.get_value());
+    EXPECT_FALSE(sensor.process());
+
+    // Down as well, from the reported value
+    now = 4000;
+    read(0);
+    EXPECT_TRUE(sensor.process());
+}
+
+TEST_F(AnalogSensorTests, keeps_minimal_interval)
+{
+    read(0);
+    EXPECT_TRUE(sensor.process());
+
+    now = 999;
+    read(1023);
+    EXPECT_FALSE(sensor.process());
+
+    // The held back change is reported once the interval passes
+    now = 1000;
+    EXPECT_TRUE(sensor.process());
+    EXPECT_EQ(100, sensor.get_value());
+}
+
+TEST_F(AnalogSensorTests, repeats_after_maximal_interval)
+{
+    read(512);
+    EXPECT_TRUE(sensor.process());
+
+    now = 59999;
+    EXPECT_FALSE(sensor.process());
+
+    now = 60000;
+    EXPECT_TRUE(sensor.process());
+    EXPECT_EQ(50, sensor.get_value());
+
+    now = 60001;
+    EXPECT_FALSE(sensor.process());
+}
+
+TEST_F(AnalogSensorTests, intervals_pass_millis_overflow)
+{
+    now = (unsigned long) -500;
+    read(0);
+    EXPECT_TRUE(sensor.process());
+
+    now = 400;
+    read(1023);
+    EXPECT_FALSE(sensor.process());
+
+    now = 500;
+    EXPECT_TRUE(sensor.process());
+}
+
+TEST_F(AnalogSensorTests, reset_reports_at_once)
+{
+    read(512);
+    EXPECT_TRUE(sensor.process());
+    EXPECT_FALSE(sensor.process());
+
+    sensor.reset();
+    EXPECT_TRUE(sensor.process());
+}
@@ -0,0 +1,149 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <Arduino.h>
+
+#include "NewButton/ButtonBank.h"
+
+using namespace ::testing;
+
+#define BUTTONS 8
+
+static const uint8_t pins[BUTTONS] = {2, 3, 4, 5, 6, 7, 8, 9};
+
+class ButtonBankTests : public testing::Test
+{
+public:
+    ButtonBankTests() :
+        levels{},
+        now{0},
+        bank(pins, BUTTONS, 40, 2000)
+    {
+        ON_CALL(ArduinoMock::mock(), digitalRead(_)).WillByDefault(Invoke([this](uint8_t pin) {
+            return levels[pin];
+        }));
+        ON_CALL(ArduinoMock::mock(), millis()).WillByDefault(Invoke([this]() {
+            return now;
+        }));
+        bank.setup();
+
+        for (uint8_t i = 0; i < BUTTONS; i++) {
+            bank.on_short_press(i, on_event, &events[i][ButtonEvents::SHORT_PRESS]);
+            bank.on_long_press(i, on_event, &events[i][ButtonEvents::LONG_PRESS]);
+            bank.on_short_release(i, on_event, &events[i][ButtonEvents::SHORT_RELEASE]);
+            bank.on_long_release(i, on_event, &events[i][ButtonEvents::LONG_RELEASE]);
+        }
+    }
+
+    ~ButtonBankTests()
+    {
+        Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    }
+
+    static void on_event(void * data)
+    {
+        (*static_cast<int *>(data))++;
+    }
+
+    // Runs the bank for `ms` milliseconds, one process per millisecond
+    void run(unsigned long ms)
+    {
+        for (unsigned long i = 0; i < ms; i++) {
+            now++;
+            bank.process();
+        }
+    }
+
+    int levels[20];
+    int events[BUTTONS][ButtonEvents::SIZE] = {};
+    unsigned long now;
+    ButtonBank bank;
+};
+
+TEST_F(ButtonBankTests, debounce_takes_four_ticks)
+{
+    levels[pins[0]] = HIGH;
+
+    run(ButtonBank::TICK_MS * 3);
+    EXPECT_EQ(0, bank.get_pressed());
+
+    run(ButtonBank::TICK_MS);
+    EXPECT_EQ(1, bank.get_pressed());
+}
+
+TEST_F(ButtonBankTests, bounce_filtered)
+{
+    for (int i = 0; i < 40; i++) {
+        levels[pins[3]] = (i % 3 == 0) ? LOW : HIGH;
+        run(ButtonBank::TICK_MS);
+        EXPECT_EQ(0, bank.get_pressed());
+    }
+}
+
+TEST_F(ButtonBankTests, short_press_release)
+{
+    levels[pins[1]] = HIGH;
+    run(100);
+    EXPECT_EQ(1, events[1][ButtonEvents::SHORT_PRESS]);
+
+    levels[pins[1]] = LOW;
+    run(100);
+    EXPECT_EQ(1, events[1][ButtonEvents::SHORT_RELEASE]);
+    EXPECT_EQ(0, events[1][ButtonEvents::LONG_PRESS]);
+    EXPECT_EQ(0, events[1][ButtonEvents::LONG_RELEASE]);
+}
+
+TEST_F(ButtonBankTests, long_press_release)
+{
+    levels[pins[7]] = HIGH;
+    run(1900);
+    EXPECT_EQ(1, events[7][ButtonEvents::SHORT_PRESS]);
+    EXPECT_EQ(0, events[7][ButtonEvents::LONG_PRESS]);
+
+    run(200);
+    EXPECT_EQ(1, events[7][ButtonEvents::LONG_PRESS]);
+
+    levels[pins[7]] = LOW;
+    run(100);
+    EXPECT_EQ(1, events[7][ButtonEvents::LONG_RELEASE]);
+    EXPECT_EQ(0, events[7][ButtonEvents::SHORT_RELEASE]);
+}
+
+TEST_F(ButtonBankTests, glitch_shorter_than_short_press)
+{
+    levels[pins[2]] = HIGH;
+    run(ButtonBank::TICK_MS * 5);
+    levels[pins[2]] = LOW;
+    run(100);
+
+    for (int type = 0; type < ButtonEvents::SIZE; type++) {
+        EXPECT_EQ(0, events[2][type]);
+    }
+}
+
+TEST_F(ButtonBankTests, buttons_independent)
+{
+    levels[pins[2]] = HIGH;
+    levels[pins[5]] = HIGH;
+    run(100);
+    levels[pins[5]] = LOW;
+    run(2000);
+
+    EXPECT_EQ((1 << 2), bank.get_pressed());
+    EXPECT_EQ(1, events[2][ButtonEvents::LONG_PRESS]);
+    EXPECT_EQ(1, events[5][ButtonEvents::SHORT_RELEASE]);
+    EXPECT_EQ(0, events[5][ButtonEvents::LONG_PRESS]);
+    for (uint8_t i : {0, 1, 3, 4, 6, 7}) {
+        EXPECT_EQ(0, events[i][ButtonEvents::SHORT_PRESS]) << "button " << (int)i;
+    }
+}
+
+TEST_F(ButtonBankTests, one_snapshot_per_tick)
+{
+    EXPECT_CALL(ArduinoMock::mock(), digitalRead(_)).Times(0);
+    run(ButtonBank::TICK_MS - 1);
+    Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalRead(_)).Times(BUTTONS).WillRepeatedly(Return(LOW));
+    run(ButtonBank::TICK_MS);
+}
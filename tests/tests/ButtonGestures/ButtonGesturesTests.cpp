@@ -0,0 +1,214 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <Arduino.h>
+
+#include "NewButton/ButtonGestures.h"
+
+using namespace ::testing;
+
+#define PIN             2
+#define CLICK_GAP_TIME  300
+#define HOLD_TIME       800
+
+class ButtonGesturesTests : public testing::Test
+{
+public:
+    ButtonGesturesTests() :
+        now{1000},
+        events{},
+        gestures(PIN, CLICK_GAP_TIME, HOLD_TIME)
+    {
+        ON_CALL(ArduinoMock::mock(), millis()).WillByDefault(Invoke([this]() {
+            return now;
+        }));
+        gestures.setup(on_isr);
+
+        for (int i = 0; i < ButtonGestures::SIZE; i++) {
+            gestures.on_gesture((ButtonGestures::Gesture)i, on_event, &events[i]);
+        }
+    }
+
+    ~ButtonGesturesTests()
+    {
+        Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    }
+
+    static void on_isr()
+    {
+    }
+
+    static void on_event(void * data)
+    {
+        (*static_cast<int *>(data))++;
+    }
+
+    // Edges of a press lasting `duration` from `time`
+    void click(unsigned long time, unsigned long duration = 100)
+    {
+        gestures.on_edge(true, time);
+        gestures.on_edge(false, time + duration);
+    }
+
+    unsigned long now;
+    int events[ButtonGestures::SIZE];
+    ButtonGestures gestures;
+};
+
+TEST_F(ButtonGesturesTests, interrupt_attached)
+{
+    ButtonGestures other(3);
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalPinToInterrupt(3)).WillOnce(Return(1));
+    EXPECT_CALL(ArduinoMock::mock(), attachInterrupt(1, on_isr, CHANGE));
+    other.setup(on_isr);
+}
+
+TEST_F(ButtonGesturesTests, pin_change_pin_not_attached_nor_polled)
+{
+    ButtonGestures other(4, CLICK_GAP_TIME, HOLD_TIME);
+    other.on_gesture(ButtonGestures::CLICK, on_event, &events[ButtonGestures::CLICK]);
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalPinToInterrupt(4)).WillRepeatedly(Return(NOT_AN_INTERRUPT));
+    EXPECT_CALL(ArduinoMock::mock(), attachInterrupt(_, _, _)).Times(0);
+    other.setup(on_isr);
+
+    // The edges come from the sketch's pin change interrupt only
+    EXPECT_CALL(ArduinoMock::mock(), digitalRead(4)).WillOnce(Return(HIGH)).WillOnce(Return(LOW));
+    other.on_interrupt();
+    now += 100;
+    other.on_interrupt();
+    now += CLICK_GAP_TIME;
+    other.process();
+
+    EXPECT_EQ(1, events[ButtonGestures::CLICK]);
+}
+
+TEST_F(ButtonGesturesTests, single_click)
+{
+    click(1000);
+
+    now = 1100 + CLICK_GAP_TIME - 1;
+    gestures.process();
+    EXPECT_EQ(0, events[ButtonGestures::CLICK]);
+
+    now = 1100 + CLICK_GAP_TIME;
+    gestures.process();
+    EXPECT_EQ(1, events[ButtonGestures::CLICK]);
+    EXPECT_EQ(0, events[ButtonGestures::DOUBLE_CLICK]);
+}
+
+TEST_F(ButtonGesturesTests, double_click_during_stall)
+{
+    // The loop didn't run for the whole gesture, the stamps still tell the clicks apart
+    click(1000);
+    click(1250);
+    now = 5000;
+    gestures.process();
+
+    EXPECT_EQ(1, events[ButtonGestures::DOUBLE_CLICK]);
+    EXPECT_EQ(0, events[ButtonGestures::CLICK]);
+}
+
+TEST_F(ButtonGesturesTests, separate_clicks_during_stall)
+{
+    click(1000);
+    click(1000 + 100 + CLICK_GAP_TIME + 50);
+    now = 5000;
+    gestures.process();
+
+    EXPECT_EQ(2, events[ButtonGestures::CLICK]);
+    EXPECT_EQ(0, events[ButtonGestures::DOUBLE_CLICK]);
+}
+
+TEST_F(ButtonGesturesTests, triple_click)
+{
+    click(1000);
+    click(1200);
+    click(1400);
+    now = 3000;
+    gestures.process();
+
+    EXPECT_EQ(1, events[ButtonGestures::TRIPLE_CLICK]);
+}
+
+TEST_F(ButtonGesturesTests, hold_and_release)
+{
+    gestures.on_edge(true, 1000);
+    now = 1000 + HOLD_TIME - 1;
+    gestures.process();
+    EXPECT_EQ(0, events[ButtonGestures::HOLD]);
+
+    now = 1000 + HOLD_TIME;
+    gestures.process();
+    EXPECT_EQ(1, events[ButtonGestures::HOLD]);
+
+    gestures.on_edge(false, 3000);
+    now = 5000;
+    gestures.process();
+    EXPECT_EQ(1, events[ButtonGestures::HOLD_RELEASE]);
+    EXPECT_EQ(0, events[ButtonGestures::CLICK]);
+}
+
+TEST_F(ButtonGesturesTests, short_press_is_not_hold_after_stall)
+{
+    click(1000, 300);
+    now = 1000 + HOLD_TIME * 3;
+    gestures.process();
+
+    EXPECT_EQ(0, events[ButtonGestures::HOLD]);
+    EXPECT_EQ(1, events[ButtonGestures::CLICK]);
+}
+
+TEST_F(ButtonGesturesTests, click_and_hold)
+{
+    click(1000);
+    gestures.on_edge(true, 1200);
+    now = 1200 + HOLD_TIME;
+    gestures.process();
+
+    EXPECT_EQ(1, events[ButtonGestures::CLICK_HOLD]);
+    EXPECT_EQ(0, events[ButtonGestures::HOLD]);
+    EXPECT_EQ(0, events[ButtonGestures::CLICK]);
+}
+
+TEST_F(ButtonGesturesTests, bounces_ignored)
+{
+    gestures.on_edge(true, 1000);
+    gestures.on_edge(false, 1003);
+    gestures.on_edge(true, 1005);
+    gestures.on_edge(false, 1100);
+    gestures.on_edge(true, 1104);
+    gestures.on_edge(false, 1108);
+    now = 2000;
+    gestures.process();
+
+    EXPECT_EQ(1, events[ButtonGestures::CLICK]);
+}
+
+TEST_F(ButtonGesturesTests, ring_overflow_counted)
+{
+    for (int i = 0; i < BUTTON_GESTURES_EDGES + 2; i++) {
+        gestures.on_edge(i % 2 == 0, 1000 + i * 50);
+    }
+
+    EXPECT_EQ(3, gestures.get_overflows());
+}
+
+TEST_F(ButtonGesturesTests, polling_without_interrupt)
+{
+    ButtonGestures polled(PIN, CLICK_GAP_TIME, HOLD_TIME);
+    polled.setup();
+    polled.on_gesture(ButtonGestures::CLICK, on_event, &events[ButtonGestures::CLICK]);
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalRead(PIN)).WillRepeatedly(Return(HIGH));
+    now = 1000;
+    polled.process();
+    EXPECT_CALL(ArduinoMock::mock(), digitalRead(PIN)).WillRepeatedly(Return(LOW));
+    now = 1100;
+    polled.process();
+    now = 1100 + CLICK_GAP_TIME;
+    polled.process();
+
+    EXPECT_EQ(1, events[ButtonGestures::CLICK]);
+}
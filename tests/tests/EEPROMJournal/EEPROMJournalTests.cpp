@@ -0,0 +1,144 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <EEPROMSimulator.h>
+
+#include "EEPROMJournal/EEPROMJournal.h"
+
+using namespace ::testing;
+
+#define JOURNAL_START   100
+#define JOURNAL_SLOTS   8
+
+struct Record
+{
+    uint8_t version;
+    uint8_t values[8];
+} __attribute__((packed));
+
+typedef EEPROMJournal<Record, EEPROMSimulator<>> Journal;
+
+class EEPROMJournalTests : public testing::Test
+{
+public:
+    EEPROMJournalTests() :
+        journal(eeprom, JOURNAL_START, JOURNAL_SLOTS)
+    {
+    }
+
+    static Record make_record(uint8_t value)
+    {
+        Record record;
+        record.version = 1;
+        memset(record.values, value, sizeof(record.values));
+        return record;
+    }
+
+    // Reads the journal back as it's done after a reset
+    bool load(Record & record)
+    {
+        Journal restarted(eeprom, JOURNAL_START, JOURNAL_SLOTS);
+        return restarted.load(record);
+    }
+
+    EEPROMSimulator<> eeprom;
+    Journal journal;
+};
+
+TEST_F(EEPROMJournalTests, erased_window_is_empty)
+{
+    Record record = make_record(0x55);
+
+    EXPECT_FALSE(load(record));
+
+    eeprom.erase(0x00);
+    EXPECT_FALSE(load(record));
+    EXPECT_EQ(0x55, record.values[0]);
+}
+
+TEST_F(EEPROMJournalTests, save_load_pass)
+{
+    journal.save(make_record(0x10));
+
+    Record record;
+    ASSERT_TRUE(load(record));
+    EXPECT_EQ(0x10, record.values[7]);
+}
+
+TEST_F(EEPROMJournalTests, stays_in_window)
+{
+    for (int i = 0; i < JOURNAL_SLOTS * 3; i++) {
+        journal.save(make_record(i));
+    }
+
+    for (int i = 0; i < 1024; i++) {
+        if (i < JOURNAL_START || i >= JOURNAL_START + JOURNAL_SLOTS * Journal::RECORD_SIZE) {
+            EXPECT_EQ(0U, eeprom.writes(i)) << "address " << i;
+        }
+    }
+}
+
+TEST_F(EEPROMJournalTests, newest_record_wins)
+{
+    for (int i = 0; i < JOURNAL_SLOTS * 2 + 3; i++) {
+        journal.save(make_record(i));
+    }
+
+    Record record;
+    ASSERT_TRUE(load(record));
+    EXPECT_EQ(JOURNAL_SLOTS * 2 + 2, record.values[0]);
+}
+
+TEST_F(EEPROMJournalTests, continues_after_load)
+{
+    journal.save(make_record(1));
+    journal.save(make_record(2));
+
+    Journal restarted(eeprom, JOURNAL_START, JOURNAL_SLOTS);
+    Record record;
+    ASSERT_TRUE(restarted.load(record));
+    restarted.save(make_record(3));
+
+    ASSERT_TRUE(load(record));
+    EXPECT_EQ(3, record.values[0]);
+    EXPECT_EQ(0U, eeprom.writes(JOURNAL_START + 3 * Journal::RECORD_SIZE));
+}
+
+TEST_F(EEPROMJournalTests, torn_write_falls_back)
+{
+    journal.save(make_record(1));
+    journal.save(make_record(2));
+
+    // Reset before the CRC of the second record was written
+    int crc_address = JOURNAL_START + 2 * Journal::RECORD_SIZE - 1;
+    eeprom.write(crc_address, eeprom.read(crc_address) ^ 0x01);
+
+    Record record;
+    ASSERT_TRUE(load(record));
+    EXPECT_EQ(1, record.values[0]);
+}
+
+TEST_F(EEPROMJournalTests, sequence_wrap_pass)
+{
+    for (long i = 0; i < 0x10000L + JOURNAL_SLOTS / 2; i++) {
+        journal.save(make_record(i & 0xFF));
+    }
+
+    Record record;
+    ASSERT_TRUE(load(record));
+    EXPECT_EQ((JOURNAL_SLOTS / 2 - 1) & 0xFF, record.values[0]);
+}
+
+TEST_F(EEPROMJournalTests, endurance_gain)
+{
+    const int SAVES = 1000;
+
+    EEPROMSimulator<> legacy;
+    for (int i = 0; i < SAVES; i++) {
+        legacy.put(0, make_record(i & 1));
+        journal.save(make_record(i & 1));
+    }
+
+    EXPECT_EQ((unsigned long)SAVES, legacy.max_writes());
+    EXPECT_GE((unsigned long)(SAVES + JOURNAL_SLOTS - 1) / JOURNAL_SLOTS, eeprom.max_writes());
+}
@@ -0,0 +1,125 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <EEPROMSimulator.h>
+
+#include "EEPROMJournal/EEPROMRecord.h"
+#include "EEPROMJournal/SettingsCache.h"
+
+using namespace ::testing;
+
+#define ADDRESS     10
+#define QUIET_TIME  1000
+
+struct Settings
+{
+    uint8_t a;
+    uint8_t b;
+    uint8_t c;
+};
+
+typedef EEPROMRecord<Settings, EEPROMSimulator<>> Record;
+
+class SettingsCacheTests : public testing::Test
+{
+public:
+    SettingsCacheTests() :
+        settings{1, 2, 3},
+        record(eeprom, ADDRESS),
+        cache(settings, record, QUIET_TIME)
+    {
+    }
+
+    unsigned long writes()
+    {
+        return eeprom.writes(ADDRESS) + eeprom.writes(ADDRESS + 1) + eeprom.writes(ADDRESS + 2);
+    }
+
+    EEPROMSimulator<> eeprom;
+    Settings settings;
+    Record record;
+    SettingsCache<Settings, Record> cache;
+};
+
+TEST_F(SettingsCacheTests, clean_does_nothing)
+{
+    EXPECT_FALSE(cache.process(0));
+    EXPECT_FALSE(cache.process(QUIET_TIME * 2));
+    EXPECT_EQ(0U, writes());
+}
+
+TEST_F(SettingsCacheTests, changes_are_coalesced)
+{
+    for (uint8_t i = 0; i < 50; i++) {
+        settings.a = i;
+        cache.touch();
+        EXPECT_TRUE(cache.process(i * 10));
+    }
+    EXPECT_EQ(0U, writes());
+
+    unsigned long now = 490 + QUIET_TIME;
+    while (cache.process(now)) {
+    }
+
+    EXPECT_EQ(49, eeprom.read(ADDRESS));
+    EXPECT_EQ(2, eeprom.read(ADDRESS + 1));
+    EXPECT_EQ(3, eeprom.read(ADDRESS + 2));
+    EXPECT_EQ(3U, writes());
+}
+
+TEST_F(SettingsCacheTests, one_cell_per_process)
+{
+    cache.touch();
+    cache.process(0);
+
+    for (unsigned long i = 1; i <= sizeof(Settings); i++) {
+        cache.process(QUIET_TIME);
+        EXPECT_EQ(i, writes());
+    }
+    EXPECT_FALSE(cache.is_dirty());
+}
+
+TEST_F(SettingsCacheTests, change_during_save)
+{
+    cache.touch();
+    cache.process(0);
+    cache.process(QUIET_TIME);
+
+    settings.c = 0x30;
+    cache.touch();
+    EXPECT_TRUE(cache.process(QUIET_TIME + 1));
+    EXPECT_TRUE(cache.process(QUIET_TIME + 2));
+    EXPECT_EQ(3, eeprom.read(ADDRESS + 2));
+
+    while (cache.process(QUIET_TIME * 3)) {
+    }
+    EXPECT_EQ(0x30, eeprom.read(ADDRESS + 2));
+}
+
+TEST_F(SettingsCacheTests, failed_write_is_counted_pass)
+{
+    eeprom.wear_out(ADDRESS + 1);
+
+    settings.a = 0x10;
+    settings.b = 0x20;
+    cache.touch();
+    cache.process(0);
+    while (cache.process(QUIET_TIME)) {
+    }
+
+    EXPECT_EQ(0x10, eeprom.read(ADDRESS));
+    EXPECT_EQ(1, record.get_failures());
+}
+
+TEST_F(SettingsCacheTests, load_pass)
+{
+    record.save(Settings{4, 5, 6});
+    settings.a = 0;
+    cache.touch();
+
+    EXPECT_TRUE(cache.load());
+
+    EXPECT_EQ(4, settings.a);
+    EXPECT_EQ(6, settings.c);
+    EXPECT_FALSE(cache.is_dirty());
+}
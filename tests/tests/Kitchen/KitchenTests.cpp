@@ -1,16 +1,14 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
-#include <LEDFader.h>
+#include <LEDFaderGroup.h>
 
 #include "../../mocks/Arduino.h"
 #include "../../mocks/MySensors.h"
 
 #include "Kitchen/Kitchen.ino"
 
-extern LEDFader ledW;
-extern LEDFader ledR;
-extern LEDFader ledG;
-extern LEDFader ledB;
+extern LEDFaderGroup<3> leds_color;
+extern LEDFaderGroup<1> leds_white;
 extern EEPROMClass<Storage> eeprom;
 
 using namespace ::testing;
@@ -35,10 +33,8 @@ public:
         Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
         Mock::VerifyAndClearExpectations(&MySensorsMock::mock());
         Mock::VerifyAndClearExpectations(&eeprom);
-        Mock::VerifyAndClearExpectations(&ledR);
-        Mock::VerifyAndClearExpectations(&ledG);
-        Mock::VerifyAndClearExpectations(&ledB);
-        Mock::VerifyAndClearExpectations(&ledW);
+        Mock::VerifyAndClearExpectations(&leds_color);
+        Mock::VerifyAndClearExpectations(&leds_white);
     }
 
     MyMessage msgColorStatus;
@@ -57,10 +53,8 @@ TEST_F(KitchenTests, on_btn_short_release_leds_on)
 
     EXPECT_CALL(MySensorsMock::mock(), send(msgColorStatus.set(true), false)).WillOnce(Return(true));
     EXPECT_CALL(MySensorsMock::mock(), send(msgWhiteStatus.set(true), false)).WillOnce(Return(true));
-    EXPECT_CALL(ledW, fade(0x40, _)).WillOnce(Return());
-    EXPECT_CALL(ledR, fade(0x10, _)).WillOnce(Return());
-    EXPECT_CALL(ledG, fade(0x20, _)).WillOnce(Return());
-    EXPECT_CALL(ledB, fade(0x30, _)).WillOnce(Return());
+    EXPECT_CALL(leds_white, fade(ElementsAre(0x40), _)).WillOnce(Return());
+    EXPECT_CALL(leds_color, fade(ElementsAre(0x10, 0x20, 0x30), _)).WillOnce(Return());
 
     on_btn_short_release(nullptr);
 
@@ -75,14 +69,12 @@ TEST_F(KitchenTests, on_btn_short_release_leds_off)
 
     EXPECT_CALL(MySensorsMock::mock(), send(msgColorStatus.set(false), false)).WillOnce(Return(true));
     EXPECT_CALL(MySensorsMock::mock(), send(msgWhiteStatus.set(false), false)).WillOnce(Return(true));
-    EXPECT_CALL(ledW, get_value()).WillOnce(Return(0x40));
-    EXPECT_CALL(ledR, get_value()).WillOnce(Return(0x10));
-    EXPECT_CALL(ledG, get_value()).WillOnce(Return(0x20));
-    EXPECT_CALL(ledB, get_value()).WillOnce(Return(0x30));
-    EXPECT_CALL(ledW, fade(0, _)).WillOnce(Return());
-    EXPECT_CALL(ledR, fade(0, _)).WillOnce(Return());
-    EXPECT_CALL(ledG, fade(0, _)).WillOnce(Return());
-    EXPECT_CALL(ledB, fade(0, _)).WillOnce(Return());
+    EXPECT_CALL(leds_white, get_value(0)).WillOnce(Return(0x40));
+    EXPECT_CALL(leds_color, get_value(0)).WillOnce(Return(0x10));
+    EXPECT_CALL(leds_color, get_value(1)).WillOnce(Return(0x20));
+    EXPECT_CALL(leds_color, get_value(2)).WillOnce(Return(0x30));
+    EXPECT_CALL(leds_white, fade(ElementsAre(0), _)).WillOnce(Return());
+    EXPECT_CALL(leds_color, fade(ElementsAre(0, 0, 0), _)).WillOnce(Return());
 
     on_btn_short_release(nullptr);
 }
@@ -91,37 +83,29 @@ TEST_F(KitchenTests, on_btn_long_press_switch_colors_by_loop)
 {
     EXPECT_CALL(MySensorsMock::mock(), send(msgColorStatus.set(true), false)).WillOnce(Return(true));
     EXPECT_CALL(MySensorsMock::mock(), send(msgWhiteStatus.set(true), false)).WillOnce(Return(true));
-    EXPECT_CALL(ledR, fade(0x10, _)).WillOnce(Return());
-    EXPECT_CALL(ledG, fade(0x20, _)).WillOnce(Return());
-    EXPECT_CALL(ledB, fade(0x30, _)).WillOnce(Return());
-    EXPECT_CALL(ledW, fade(0x40, _)).WillOnce(Return());
+    EXPECT_CALL(leds_color, fade(ElementsAre(0x10, 0x20, 0x30), _)).WillOnce(Return());
+    EXPECT_CALL(leds_white, fade(ElementsAre(0x40), _)).WillOnce(Return());
 
     on_btn_long_press(nullptr);
 
     EXPECT_CALL(MySensorsMock::mock(), send(msgColorStatus.set(true), false)).WillOnce(Return(true));
     EXPECT_CALL(MySensorsMock::mock(), send(msgWhiteStatus.set(false), false)).WillOnce(Return(true));
-    EXPECT_CALL(ledR, fade(0x10, _)).WillOnce(Return());
-    EXPECT_CALL(ledG, fade(0x20, _)).WillOnce(Return());
-    EXPECT_CALL(ledB, fade(0x30, _)).WillOnce(Return());
-    EXPECT_CALL(ledW, fade(0x0, _)).WillOnce(Return());
+    EXPECT_CALL(leds_color, fade(ElementsAre(0x10, 0x20, 0x30), _)).WillOnce(Return());
+    EXPECT_CALL(leds_white, fade(ElementsAre(0x0), _)).WillOnce(Return());
 
     on_btn_long_press(nullptr);
 
     EXPECT_CALL(MySensorsMock::mock(), send(msgColorStatus.set(false), false)).WillOnce(Return(true));
     EXPECT_CALL(MySensorsMock::mock(), send(msgWhiteStatus.set(true), false)).WillOnce(Return(true));
-    EXPECT_CALL(ledR, fade(0x0, _)).WillOnce(Return());
-    EXPECT_CALL(ledG, fade(0x0, _)).WillOnce(Return());
-    EXPECT_CALL(ledB, fade(0x0, _)).WillOnce(Return());
-    EXPECT_CALL(ledW, fade(0x40, _)).WillOnce(Return());
+    EXPECT_CALL(leds_color, fade(ElementsAre(0x0, 0x0, 0x0), _)).WillOnce(Return());
+    EXPECT_CALL(leds_white, fade(ElementsAre(0x40), _)).WillOnce(Return());
 
     on_btn_long_press(nullptr);
 
     EXPECT_CALL(MySensorsMock::mock(), send(msgColorStatus.set(true), false)).WillOnce(Return(true));
     EXPECT_CALL(MySensorsMock::mock(), send(msgWhiteStatus.set(true), false)).WillOnce(Return(true));
-    EXPECT_CALL(ledR, fade(0x10, _)).WillOnce(Return());
-    EXPECT_CALL(ledG, fade(0x20, _)).WillOnce(Return());
-    EXPECT_CALL(ledB, fade(0x30, _)).WillOnce(Return());
-    EXPECT_CALL(ledW, fade(0x40, _)).WillOnce(Return());
+    EXPECT_CALL(leds_color, fade(ElementsAre(0x10, 0x20, 0x30), _)).WillOnce(Return());
+    EXPECT_CALL(leds_white, fade(ElementsAre(0x40), _)).WillOnce(Return());
 
     on_btn_long_press(nullptr);
 }
@@ -1,16 +1,14 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
-#include <LEDFader.h>
+#include <LEDFaderGroup.h>
 
 #include "../../mocks/Arduino.h"
 #include "../../mocks/MySensors.h"
 
 #include "Kitchen/LEDs.h"
 
-extern LEDFader ledW;
-extern LEDFader ledR;
-extern LEDFader ledG;
-extern LEDFader ledB;
+extern LEDFaderGroup<3> leds_color;
+extern LEDFaderGroup<1> leds_white;
 
 using namespace ::testing;
 
@@ -30,10 +28,8 @@ public:
     {
         Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
         Mock::VerifyAndClearExpectations(&MySensorsMock::mock());
-        Mock::VerifyAndClearExpectations(&ledR);
-        Mock::VerifyAndClearExpectations(&ledG);
-        Mock::VerifyAndClearExpectations(&ledB);
-        Mock::VerifyAndClearExpectations(&ledW);
+        Mock::VerifyAndClearExpectations(&leds_color);
+        Mock::VerifyAndClearExpectations(&leds_white);
     }
 
     Transition white_one_shot;
@@ -46,8 +42,8 @@ TEST_F(LedsTests, transition_white_start_pass)
 {
     leds_set_transition(LedType::White, white_one_shot);
 
-    EXPECT_CALL(ledW, set_value(0x10)).WillOnce(Return());
-    EXPECT_CALL(ledW, fade(0xF0, 10)).WillOnce(Return());
+    EXPECT_CALL(leds_white, set_values(ElementsAre(0x10))).WillOnce(Return());
+    EXPECT_CALL(leds_white, fade(ElementsAre(0xF0), LEDFaderGroup<1>::MIN_INTERVAL + 1)).WillOnce(Return());
 
     leds_start_transition(LedType::White, true);
 
@@ -62,12 +58,8 @@ TEST_F(LedsTests, transition_color_start_pass)
 {
     leds_set_transition(LedType::Color, color_one_shot);
 
-    EXPECT_CALL(ledR, set_value(0x1)).WillOnce(Return());
-    EXPECT_CALL(ledG, set_value(0x5)).WillOnce(Return());
-    EXPECT_CALL(ledB, set_value(0x20)).WillOnce(Return());
-    EXPECT_CALL(ledR, fade(0x10, 100)).WillOnce(Return());
-    EXPECT_CALL(ledG, fade(0x50, 100)).WillOnce(Return());
-    EXPECT_CALL(ledB, fade(0xFF, 100)).WillOnce(Return());
+    EXPECT_CALL(leds_color, set_values(ElementsAre(0x1, 0x5, 0x20))).WillOnce(Return());
+    EXPECT_CALL(leds_color, fade(ElementsAre(0x10, 0x50, 0xFF), 100)).WillOnce(Return());
 
     leds_start_transition(LedType::Color, true);
 
@@ -82,35 +74,27 @@ TEST_F(LedsTests, transition_white_loop)
 {
     leds_set_transition(LedType::White, white_loop);
 
-    EXPECT_CALL(ledW, set_value(0x11)).WillOnce(Return());
-    EXPECT_CALL(ledW, fade(0xF1, 111)).WillOnce(Return());
+    EXPECT_CALL(leds_white, set_values(ElementsAre(0x11))).WillOnce(Return());
+    EXPECT_CALL(leds_white, fade(ElementsAre(0xF1), 111)).WillOnce(Return());
 
     // start
     leds_start_transition(LedType::White, true);
 
-    EXPECT_CALL(ledW, get_value()).WillOnce(Return(0x50));
+    EXPECT_CALL(leds_white, fade(_, _)).Times(0);
 
     // still going up
     leds_process();
 
-    EXPECT_CALL(ledW, get_value()).WillOnce(Return(0xF1));
-    EXPECT_CALL(ledW, set_value(0xF1)).WillOnce(Return());
-    EXPECT_CALL(ledW, fade(0x11, 111)).WillOnce(Return());
+    Mock::VerifyAndClearExpectations(&leds_white);
+    EXPECT_CALL(leds_white, fade(ElementsAre(0x11), 111)).WillOnce(Return());
 
     // is maximum, going down
-    leds_process();
-
-    EXPECT_CALL(ledW, get_value()).WillOnce(Return(0x50));
+    leds_fade_complete(LedType::White);
 
-    // down - still going down
-    leds_process();
-
-    EXPECT_CALL(ledW, get_value()).WillOnce(Return(0x11));
-    EXPECT_CALL(ledW, set_value(0x11)).WillOnce(Return());
-    EXPECT_CALL(ledW, fade(0xF1, 111)).WillOnce(Return());
+    EXPECT_CALL(leds_white, fade(ElementsAre(0xF1), 111)).WillOnce(Return());
 
     // repeat
-    leds_process();
+    leds_fade_complete(LedType::White);
 }
 
 TEST_F(LedsTests, transition_color_loop)
@@ -119,49 +103,84 @@ TEST_F(LedsTests, transition_color_loop)
 
     leds_set_transition(LedType::Color, color_loop);
 
-    EXPECT_CALL(ledR, set_value(0x2)).WillOnce(Return());
-    EXPECT_CALL(ledG, set_value(0x6)).WillOnce(Return());
-    EXPECT_CALL(ledB, set_value(0x21)).WillOnce(Return());
-    EXPECT_CALL(ledR, fade(0x20, 222)).WillOnce(Return());
-    EXPECT_CALL(ledG, fade(0x60, 222)).WillOnce(Return());
-    EXPECT_CALL(ledB, fade(0xFF, 222)).WillOnce(Return());
+    EXPECT_CALL(leds_color, set_values(ElementsAre(0x2, 0x6, 0x21))).WillOnce(Return());
+    EXPECT_CALL(leds_color, fade(ElementsAre(0x20, 0x60, 0xFF), 222)).WillOnce(Return());
 
     // start
     leds_start_transition(LedType::Color, true);
 
-    EXPECT_CALL(ledR, get_value()).WillOnce(Return(0x2));
+    EXPECT_CALL(leds_color, fade(_, _)).Times(0);
 
     // still going up
     leds_process();
 
-    EXPECT_CALL(ledR, get_value()).WillOnce(Return(0x20));
-    EXPECT_CALL(ledG, get_value()).WillOnce(Return(0x60));
-    EXPECT_CALL(ledB, get_value()).WillOnce(Return(0xFF));
-    EXPECT_CALL(ledR, set_value(0x20)).WillOnce(Return());
-    EXPECT_CALL(ledG, set_value(0x60)).WillOnce(Return());
-    EXPECT_CALL(ledB, set_value(0xFF)).WillOnce(Return());
-    EXPECT_CALL(ledR, fade(0x2, 222)).WillOnce(Return());
-    EXPECT_CALL(ledG, fade(0x6, 222)).WillOnce(Return());
-    EXPECT_CALL(ledB, fade(0x21, 222)).WillOnce(Return());
+    Mock::VerifyAndClearExpectations(&leds_color);
+    EXPECT_CALL(leds_color, fade(ElementsAre(0x2, 0x6, 0x21), 222)).WillOnce(Return());
 
     // is maximum, going down
-    leds_process();
+    leds_fade_complete(LedType::Color);
 
-    EXPECT_CALL(ledR, get_value()).WillOnce(Return(0x10));
+    EXPECT_CALL(leds_color, fade(ElementsAre(0x20, 0x60, 0xFF), 222)).WillOnce(Return());
 
-    // down - still going down
-    leds_process();
+    // repeat
+    leds_fade_complete(LedType::Color);
+}
 
-    EXPECT_CALL(ledR, get_value()).WillOnce(Return(0x2));
-    EXPECT_CALL(ledG, get_value()).WillOnce(Return(0x6));
-    EXPECT_CALL(ledB, get_value()).WillOnce(Return(0x21));
-    EXPECT_CALL(ledR, set_value(0x2)).WillOnce(Return());
-    EXPECT_CALL(ledG, set_value(0x6)).WillOnce(Return());
-    EXPECT_CALL(ledB, set_value(0x21)).WillOnce(Return());
-    EXPECT_CALL(ledR, fade(0x20, 222)).WillOnce(Return());
-    EXPECT_CALL(ledG, fade(0x60, 222)).WillOnce(Return());
-    EXPECT_CALL(ledB, fade(0xFF, 222)).WillOnce(Return());
+TEST_F(LedsTests, transition_one_shot_stops_at_end)
+{
+    leds_set_transition(LedType::Color, color_one_shot);
+    leds_start_transition(LedType::Color, true);
+
+    EXPECT_CALL(leds_color, fade(_, _)).Times(0);
+
+    leds_fade_complete(LedType::Color);
+
+    EXPECT_FALSE(leds_is_transition(LedType::Color));
+}
+
+TEST_F(LedsTests, sequence_loop_jumps_to_start)
+{
+    leds_add_keyframe(LedType::White, Keyframe{{0, 0, 0, 0x10}, 0, Easing::Linear});
+    leds_add_keyframe(LedType::White, Keyframe{{0, 0, 0, 0x80}, 1000, Easing::Linear});
+    leds_add_keyframe(LedType::White, Keyframe{{0, 0, 0, 0x40}, 2000, Easing::Linear});
+
+    EXPECT_CALL(leds_white, set_values(ElementsAre(0x10))).WillOnce(Return());
+    EXPECT_CALL(leds_white, fade(ElementsAre(0x80), 1000)).WillOnce(Return());
+
+    leds_run_sequence(LedType::White, SequenceMode::Loop);
+    EXPECT_TRUE(leds_is_transition(LedType::White));
+
+    EXPECT_CALL(leds_white, fade(ElementsAre(0x40), 2000)).WillOnce(Return());
+
+    leds_fade_complete(LedType::White);
+
+    EXPECT_CALL(leds_white, set_values(ElementsAre(0x10))).WillOnce(Return());
+    EXPECT_CALL(leds_white, fade(ElementsAre(0x80), 1000)).WillOnce(Return());
+
+    leds_fade_complete(LedType::White);
+}
+
+TEST_F(LedsTests, sequence_new_keyframes_replace_program)
+{
+    leds_add_keyframe(LedType::Color, Keyframe{{1, 2, 3, 0}, 0, Easing::Linear});
+    leds_add_keyframe(LedType::Color, Keyframe{{4, 5, 6, 0}, 1000, Easing::Linear});
+    leds_run_sequence(LedType::Color, SequenceMode::PingPong);
+
+    leds_add_keyframe(LedType::Color, Keyframe{{7, 8, 9, 0}, 0, Easing::Linear});
+    EXPECT_FALSE(leds_is_transition(LedType::Color));
+    leds_add_keyframe(LedType::Color, Keyframe{{10, 11, 12, 0}, 500, Easing::Linear});
+
+    EXPECT_CALL(leds_color, set_values(ElementsAre(7, 8, 9))).WillOnce(Return());
+    EXPECT_CALL(leds_color, fade(ElementsAre(10, 11, 12), 500)).WillOnce(Return());
+
+    leds_run_sequence(LedType::Color, SequenceMode::OneShot);
+}
+
+TEST_F(LedsTests, process_reads_clock_once)
+{
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(1234));
+    EXPECT_CALL(leds_color, update(1234)).WillOnce(Return(true));
+    EXPECT_CALL(leds_white, update(1234)).WillOnce(Return(true));
 
-    // repeat
     leds_process();
 }
@@ -0,0 +1,461 @@
+#include <chrono>
+#include <errno.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <LEDFader.h>
+
+#include "Kitchen/Parsing.h"
+
+using namespace ::testing;
+
+// The strtol() based parser parse_command() used before the in-place tokenizer. Kept as the
+// reference the tokenizer is checked and benchmarked against.
+namespace legacy
+{
+    static const size_t MAX_FIELD_COUNT = 4;
+    static const size_t MAX_PAYLOAD_SIZE = 50;
+
+    struct Record
+    {
+        Command command;
+        size_t count;
+        const char *  fields[MAX_FIELD_COUNT];
+    };
+
+    bool hex_to_byte(const char * str, byte & result)
+    {
+        result = strtol(str, nullptr, 16);
+        if (errno != 0) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool string_to_white(const char * str, RGBW & result)
+    {
+        size_t len = strlen(str);
+        if (len != 2) {
+            return false;
+        }
+
+        result.R = 0;
+        result.G = 0;
+        result.B = 0;
+        return hex_to_byte(str, result.W);
+    }
+
+    bool string_to_ulong(const char * str, unsigned long & result)
+    {
+        result = strtoul(str, nullptr, 10);
+        if (errno != 0) {
+            return false;
+        }
+
+        return true;
+    }
+
+    Record parse_command_string(const char * input)
+    {
+        Record result = {Command::NONE , 0, {}};
+
+        if (!input) {
+            return result;
+        }
+
+        size_t len = strlen(input);
+        if (len < 1) {
+            return result;
+        }
+        if (len >= MAX_PAYLOAD_SIZE) {
+            return result;
+        }
+
+        if (len > 2 && input[1] != ',') {
+            return result;
+        }
+
+        static char data[MAX_PAYLOAD_SIZE] = {};
+        strncpy(data, input, MAX_PAYLOAD_SIZE);
+
+        result.command = static_cast<Command>(data[0]);
+
+        if (len > 2) {
+            result.fields[0] = &data[2];
+            result.count = 1;
+        }
+
+        for (size_t i = 2; i < len; i++) {
+            if (data[i] == ',') {
+                data[i] = '\0';
+                result.fields[result.count++] = &data[i+1];
+            }
+        }
+
+        return result;
+    }
+
+    bool string_to_rgb(const char * str, RGBW & result)
+    {
+        result = {0, 0, 0, 0};
+
+        if (!str) {
+            return false;
+        }
+
+        size_t len = strlen(str);
+        if (len != 3*2) {
+            return false;
+        }
+
+        char buffer[7];
+        strncpy(buffer, str, sizeof(buffer));
+
+        if (!hex_to_byte(buffer+4, result.B)) {
+            return false;
+        }
+        buffer[4] = '\0';
+        if (!hex_to_byte(buffer+2, result.G)) {
+            return false;
+        }
+        buffer[2] = '\0';
+        if (!hex_to_byte(buffer, result.R)) {
+            return false;
+        }
+
+        result.W = 0;
+        return true;
+    }
+
+    bool parse_cmd_set_limit(const Record & record, LedType type, RGBW & result)
+    {
+        if (record.count != 1) {
+            return false;
+        }
+
+        if (type == LedType::Color) {
+            if (!string_to_rgb(record.fields[0], result)) {
+                return false;
+            };
+        }
+        else if (type == LedType::White) {
+            if (!string_to_white(record.fields[0], result)) {
+                return false;
+            };
+        }
+
+        return true;
+    }
+
+    bool parse_cmd_transition(const Record & record, LedType type, Transition & transition)
+    {
+        if (record.count != 3) {
+            return false;
+        }
+
+        const char * start = record.fields[0];
+        const char * stop = record.fields[1];
+        const char * time = record.fields[2];
+
+        if (type == LedType::Color) {
+            if (!string_to_rgb(start, transition.start)) {
+                return false;
+            };
+            if (!string_to_rgb(stop, transition.stop)) {
+                return false;
+            };
+        }
+        else if (type == LedType::White) {
+            if (!string_to_white(start, transition.start)) {
+                return false;
+            };
+            if (!string_to_white(stop, transition.stop)) {
+                return false;
+            };
+        }
+        if (!string_to_ulong(time, transition.time)) {
+            return false;
+        };
+        if (transition.time <= LEDFader::MIN_INTERVAL) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool parse_cmd_keyframe(const Record & record, LedType type, Keyframe & keyframe)
+    {
+        if (record.count != 3) {
+            return false;
+        }
+
+        if (type == LedType::Color) {
+            if (!string_to_rgb(record.fields[0], keyframe.color)) {
+                return false;
+            };
+        }
+        else if (type == LedType::White) {
+            if (!string_to_white(record.fields[0], keyframe.color)) {
+                return false;
+            };
+        }
+        if (!string_to_ulong(record.fields[1], keyframe.time)) {
+            return false;
+        }
+
+        unsigned long easing;
+        if (!string_to_ulong(record.fields[2], easing) || easing >= Easing::EASINGS_MAX_SIZE) {
+            return false;
+        }
+        keyframe.easing = static_cast<Easing>(easing);
+
+        return true;
+    }
+
+    bool parse_cmd_sequence_run(const Record & record, SequenceMode & mode)
+    {
+        if (record.count != 1) {
+            return false;
+        }
+
+        unsigned long value;
+        if (!string_to_ulong(record.fields[0], value) || value >= SequenceMode::SEQUENCE_MODES_MAX_SIZE) {
+            return false;
+        }
+        mode = static_cast<SequenceMode>(value);
+
+        return true;
+    }
+
+    CommandData parse_command(const char * payload, LedType led_type)
+    {
+
+        Record record = parse_command_string(payload);
+
+        CommandData result{};
+
+        bool res = false;
+        switch (record.command) {
+        case Command::LIGHT_SET_EXT_LIMIT:
+        case Command::LIGHT_SET_BUTTON_LIMIT:
+            res = parse_cmd_set_limit(record, led_type, result.limit);
+            break;
+        case Command::TRANSITION_ONE_SHOT:
+            res = parse_cmd_transition(record, led_type, result.transition);
+            result.transition.is_loop = false;
+            break;
+        case Command::TRANSITION_LOOP:
+            res = parse_cmd_transition(record, led_type, result.transition);
+            result.transition.is_loop = true;
+            break;
+        case Command::SEQUENCE_ADD_KEYFRAME:
+            res = parse_cmd_keyframe(record, led_type, result.keyframes.items[0]);
+            break;
+        case Command::SEQUENCE_RUN:
+            res = parse_cmd_sequence_run(record, result.mode);
+            break;
+        default:
+            return CommandData{};
+        }
+        result.command = record.command;
+
+        if (!res) {
+            return CommandData{};
+        }
+
+        return result;
+    }
+}
+
+class ParsingReferenceTests : public testing::Test
+{
+public:
+    // Payloads the Kitchen node is sent: every command with random colors, times and modes
+    static std::vector<std::string> valid_corpus(std::mt19937 & random, size_t size)
+    {
+        std::vector<std::string> corpus;
+        std::uniform_int_distribution<int> byte(0, 0xFF);
+        std::uniform_int_distribution<unsigned long> time(LEDFader::MIN_INTERVAL + 1, 0xFFFFFFFFUL);
+        char buffer[64];
+
+        for (size_t i = 0; i < size; i++) {
+            auto hex = [&](bool color) {
+                char value[8];
+                if (color) {
+                    snprintf(value, sizeof(value), (i & 1) ? "%02X%02X%02X" : "%02x%02x%02x",
+                             byte(random), byte(random), byte(random));
+                }
+                else {
+                    snprintf(value, sizeof(value), (i & 1) ? "%02X" : "%02x", byte(random));
+                }
+                return std::string(value);
+            };
+            bool color = random() & 1;
+
+            switch (i % 6) {
+            case 0:
+            case 1:
+                snprintf(buffer, sizeof(buffer), "%c,%s", '0' + (int)(i % 6), hex(color).c_str());
+                break;
+            case 2:
+            case 3:
+                snprintf(buffer, sizeof(buffer), "%c,%s,%s,%lu", '0' + (int)(i % 6), hex(color).c_str(),
+                         hex(color).c_str(), time(random));
+                break;
+            case 4:
+                snprintf(buffer, sizeof(buffer), "4,%s,%lu,%d", hex(color).c_str(), time(random),
+                         (int)(random() % EASINGS_MAX_SIZE));
+                break;
+            default:
+                snprintf(buffer, sizeof(buffer), "5,%d", (int)(random() % SEQUENCE_MODES_MAX_SIZE));
+                break;
+            }
+            corpus.push_back(buffer);
+        }
+        return corpus;
+    }
+
+    // Valid payloads with bytes replaced, dropped or duplicated
+    static std::vector<std::string> mutated_corpus(std::mt19937 & random, size_t size)
+    {
+        const char alphabet[] = "0123456789abcdefABCDEFxyzG,,,;- +";
+        std::vector<std::string> corpus = valid_corpus(random, size);
+
+        for (auto & payload : corpus) {
+            int mutations = 1 + random() % 3;
+            for (int i = 0; i < mutations && !payload.empty(); i++) {
+                size_t at = random() % payload.size();
+                switch (random() % 3) {
+                case 0:
+                    payload[at] = alphabet[random() % (sizeof(alphabet) - 1)];
+                    break;
+                case 1:
+                    payload.erase(at, 1);
+                    break;
+                default:
+                    payload.insert(at, 1, payload[at]);
+                    break;
+                }
+            }
+        }
+        return corpus;
+    }
+
+    static LedType led_type(const std::string & payload)
+    {
+        size_t comma = payload.find(',', 2);
+        size_t size = (comma == std::string::npos ? payload.size() : comma) - 2;
+        return size == 2 ? LedType::White : LedType::Color;
+    }
+
+    static CommandData legacy_parse(const std::string & payload, LedType type)
+    {
+        errno = 0;
+        return legacy::parse_command(payload.c_str(), type);
+    }
+
+    static void expect_same(const CommandData & expected, const CommandData & actual, const std::string & payload)
+    {
+        ASSERT_EQ(expected.command, actual.command) << payload;
+
+        switch (actual.command) {
+        case Command::LIGHT_SET_EXT_LIMIT:
+        case Command::LIGHT_SET_BUTTON_LIMIT:
+            ASSERT_EQ(0, memcmp(&expected.limit, &actual.limit, sizeof(RGBW))) << payload;
+            break;
+        case Command::TRANSITION_ONE_SHOT:
+        case Command::TRANSITION_LOOP:
+            ASSERT_EQ(0, memcmp(&expected.transition.start, &actual.transition.start, sizeof(RGBW))) << payload;
+            ASSERT_EQ(0, memcmp(&expected.transition.stop, &actual.transition.stop, sizeof(RGBW))) << payload;
+            ASSERT_EQ(expected.transition.time, actual.transition.time) << payload;
+            ASSERT_EQ(expected.transition.is_loop, actual.transition.is_loop) << payload;
+            break;
+        case Command::SEQUENCE_ADD_KEYFRAME:
+            ASSERT_EQ(0, memcmp(&expected.keyframes.items[0].color, &actual.keyframes.items[0].color, sizeof(RGBW))) << payload;
+            ASSERT_EQ(expected.keyframes.items[0].time, actual.keyframes.items[0].time) << payload;
+            ASSERT_EQ(expected.keyframes.items[0].easing, actual.keyframes.items[0].easing) << payload;
+            break;
+        case Command::SEQUENCE_RUN:
+            ASSERT_EQ(expected.mode, actual.mode) << payload;
+            break;
+        default:
+            break;
+        }
+    }
+};
+
+TEST_F(ParsingReferenceTests, valid_corpus_matches_legacy_pass)
+{
+    std::mt19937 random(1);
+
+    for (const auto & payload : valid_corpus(random, 20000)) {
+        LedType type = led_type(payload);
+        CommandData actual = parse_command(payload.c_str(), type);
+
+        ASSERT_NE(Command::NONE, actual.command) << payload;
+        expect_same(legacy_parse(payload, type), actual, payload);
+        if (HasFatalFailure()) {
+            return;
+        }
+    }
+}
+
+// Whatever the tokenizer accepts, the legacy parser has to accept the same way. The other way
+// around doesn't hold: strtol() stops at the first bad character, so the legacy parser took
+// "0,5G" for 0x05 and ignored numbers too big for 32 bits.
+TEST_F(ParsingReferenceTests, mutated_corpus_pass)
+{
+    std::mt19937 random(2);
+    size_t accepted = 0;
+
+    for (const auto & payload : mutated_corpus(random, 20000)) {
+        LedType type = led_type(payload);
+        CommandData actual = parse_command(payload.c_str(), type);
+        if (actual.command == Command::NONE) {
+            continue;
+        }
+        accepted++;
+
+        expect_same(legacy_parse(payload, type), actual, payload);
+        if (HasFatalFailure()) {
+            return;
+        }
+    }
+    EXPECT_LT(0U, accepted);
+}
+
+// Not a pass/fail test, so it's disabled; run it with --gtest_also_run_disabled_tests. It prints
+// the host cost of parsing one payload with both parsers.
+TEST_F(ParsingReferenceTests, DISABLED_benchmark_parse_command)
+{
+    std::mt19937 random(3);
+    const auto corpus = valid_corpus(random, 1000);
+    const int rounds = 200;
+
+    auto measure = [&](auto && parse) {
+        unsigned long checksum = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const auto & payload : corpus) {
+                checksum += parse(payload).command;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        EXPECT_NE(0U, checksum);
+        return std::chrono::duration<double, std::nano>(end - begin).count() / (rounds * corpus.size());
+    };
+
+    double legacy_ns = measure([](const std::string & payload) {
+        return legacy_parse(payload, LedType::Color);
+    });
+    double tokenizer_ns = measure([](const std::string & payload) {
+        return parse_command(payload.c_str(), LedType::Color);
+    });
+
+    std::cout << "Parse command: legacy " << legacy_ns << " ns, tokenizer " << tokenizer_ns << " ns" << std::endl;
+}
@@ -144,7 +144,7 @@ TEST_F(ParsingTests, parse_command_too_long_time_fail)
 
 TEST_F(ParsingTests, parse_command_wrong_cmd_fail)
 {
-    parsing_should_be_failed(parse_command("5,54FF77,010203,10000000000", LedType::Color));
+    parsing_should_be_failed(parse_command("9,54FF77,010203,10000000000", LedType::Color));
 }
 
 TEST_F(ParsingTests, parse_command_wrong_separator_fail)
@@ -152,3 +152,169 @@ TEST_F(ParsingTests, parse_command_wrong_separator_fail)
     parsing_should_be_failed(parse_command("3;54FF77,010203,10000000000", LedType::Color));
 }
 
+
+TEST_F(ParsingTests, parse_command_color_keyframe_pass)
+{
+    CommandData result = parse_command("4,54FF77,1000,3", LedType::Color);
+    EXPECT_EQ(SEQUENCE_ADD_KEYFRAME, result.command);
+    EXPECT_EQ(0x54, result.keyframes.items[0].color.R);
+    EXPECT_EQ(0xFF, result.keyframes.items[0].color.G);
+    EXPECT_EQ(0x77, result.keyframes.items[0].color.B);
+    EXPECT_EQ(0, result.keyframes.items[0].color.W);
+    EXPECT_EQ(1000U, result.keyframes.items[0].time);
+    EXPECT_EQ(Easing::EaseInOut, result.keyframes.items[0].easing);
+}
+
+TEST_F(ParsingTests, parse_command_white_keyframe_pass)
+{
+    CommandData result = parse_command("4,54,0,0", LedType::White);
+    EXPECT_EQ(SEQUENCE_ADD_KEYFRAME, result.command);
+    EXPECT_EQ(0x54, result.keyframes.items[0].color.W);
+    EXPECT_EQ(0U, result.keyframes.items[0].time);
+    EXPECT_EQ(Easing::Linear, result.keyframes.items[0].easing);
+}
+
+TEST_F(ParsingTests, parse_command_keyframe_fail)
+{
+    parsing_should_be_failed(parse_command("4,54,100,4", LedType::White));
+    parsing_should_be_failed(parse_command("4,54,100", LedType::White));
+    parsing_should_be_failed(parse_command("4,5411,100,1", LedType::White));
+}
+
+TEST_F(ParsingTests, parse_command_sequence_run_pass)
+{
+    CommandData result = parse_command("5,2", LedType::Color);
+    EXPECT_EQ(SEQUENCE_RUN, result.command);
+    EXPECT_EQ(SequenceMode::PingPong, result.mode);
+}
+
+TEST_F(ParsingTests, parse_command_sequence_run_fail)
+{
+    parsing_should_be_failed(parse_command("5,3", LedType::Color));
+    parsing_should_be_failed(parse_command("5", LedType::Color));
+}
+
+TEST_F(ParsingTests, parse_command_after_fail_pass)
+{
+    parsing_should_be_failed(parse_command("3,54FF77,010203,10000000000", LedType::Color));
+
+    CommandData result = parse_command("2,54FF77,010203,4294967295", LedType::Color);
+    EXPECT_EQ(TRANSITION_ONE_SHOT, result.command);
+    EXPECT_EQ(4294967295U, result.transition.time);
+}
+
+TEST_F(ParsingTests, parse_command_bad_hex_fail)
+{
+    parsing_should_be_failed(parse_command("0,5G", LedType::White));
+    parsing_should_be_failed(parse_command("0,54FF7:", LedType::Color));
+    parsing_should_be_failed(parse_command("2,54FF77,010203,12a", LedType::Color));
+}
+
+TEST_F(ParsingTests, parse_command_too_many_fields_fail)
+{
+    parsing_should_be_failed(parse_command("2,54FF77,010203,100,1,2,3,4", LedType::Color));
+    parsing_should_be_failed(parse_command(nullptr, LedType::Color));
+    parsing_should_be_failed(parse_command("", LedType::Color));
+}
+
+TEST_F(ParsingTests, parse_binary_color_set_limit_pass)
+{
+    const uint8_t payload[] = {'1', 0x54, 0xFF, 0x77};
+
+    CommandData result = parse_binary_command(payload, sizeof(payload), LedType::Color);
+    EXPECT_EQ(LIGHT_SET_BUTTON_LIMIT, result.command);
+    EXPECT_EQ(0x54, result.limit.R);
+    EXPECT_EQ(0xFF, result.limit.G);
+    EXPECT_EQ(0x77, result.limit.B);
+    EXPECT_EQ(0, result.limit.W);
+}
+
+TEST_F(ParsingTests, parse_binary_white_set_limit_pass)
+{
+    const uint8_t payload[] = {'0', 0x54};
+
+    CommandData result = parse_binary_command(payload, sizeof(payload), LedType::White);
+    EXPECT_EQ(LIGHT_SET_EXT_LIMIT, result.command);
+    EXPECT_EQ(0, result.limit.R);
+    EXPECT_EQ(0x54, result.limit.W);
+}
+
+TEST_F(ParsingTests, parse_binary_color_loop_pass)
+{
+    const uint8_t payload[] = {'3', 0x54, 0xFF, 0x77, 0x01, 0x02, 0x03, 0x7B, 0x00, 0x00, 0x00};
+    EXPECT_EQ(11U, sizeof(payload));
+
+    CommandData result = parse_binary_command(payload, sizeof(payload), LedType::Color);
+    EXPECT_EQ(TRANSITION_LOOP, result.command);
+    EXPECT_EQ(0x54, result.transition.start.R);
+    EXPECT_EQ(0xFF, result.transition.start.G);
+    EXPECT_EQ(0x77, result.transition.start.B);
+    EXPECT_EQ(0, result.transition.start.W);
+    EXPECT_EQ(0x01, result.transition.stop.R);
+    EXPECT_EQ(0x02, result.transition.stop.G);
+    EXPECT_EQ(0x03, result.transition.stop.B);
+    EXPECT_EQ(0, result.transition.stop.W);
+    EXPECT_EQ(123U, result.transition.time);
+    EXPECT_TRUE(result.transition.is_loop);
+}
+
+TEST_F(ParsingTests, parse_binary_white_fade_pass)
+{
+    const uint8_t payload[] = {'2', 0x77, 0x55, 0x40, 0x42, 0x0F, 0x00};
+
+    CommandData result = parse_binary_command(payload, sizeof(payload), LedType::White);
+    EXPECT_EQ(TRANSITION_ONE_SHOT, result.command);
+    EXPECT_EQ(0x77, result.transition.start.W);
+    EXPECT_EQ(0x55, result.transition.stop.W);
+    EXPECT_EQ(1000000U, result.transition.time);
+    EXPECT_FALSE(result.transition.is_loop);
+}
+
+TEST_F(ParsingTests, parse_binary_keyframes_pass)
+{
+    const uint8_t payload[] = {'4',
+                               0x10, 0x20, 0x30, 0x00, 0x00, 0x00, 0x00, 0,
+                               0x40, 0x50, 0x60, 0xE8, 0x03, 0x00, 0x00, 1,
+                               0x70, 0x80, 0x90, 0xD0, 0x07, 0x00, 0x00, 3};
+    EXPECT_GE(25U, sizeof(payload));
+
+    CommandData result = parse_binary_command(payload, sizeof(payload), LedType::Color);
+    EXPECT_EQ(SEQUENCE_ADD_KEYFRAME, result.command);
+    ASSERT_EQ(3, result.keyframes.count);
+    EXPECT_EQ(0x10, result.keyframes.items[0].color.R);
+    EXPECT_EQ(0U, result.keyframes.items[0].time);
+    EXPECT_EQ(Easing::Linear, result.keyframes.items[0].easing);
+    EXPECT_EQ(0x50, result.keyframes.items[1].color.G);
+    EXPECT_EQ(1000U, result.keyframes.items[1].time);
+    EXPECT_EQ(Easing::EaseIn, result.keyframes.items[1].easing);
+    EXPECT_EQ(0x90, result.keyframes.items[2].color.B);
+    EXPECT_EQ(2000U, result.keyframes.items[2].time);
+    EXPECT_EQ(Easing::EaseInOut, result.keyframes.items[2].easing);
+}
+
+TEST_F(ParsingTests, parse_binary_sequence_run_pass)
+{
+    const uint8_t payload[] = {'5', 1};
+
+    CommandData result = parse_binary_command(payload, sizeof(payload), LedType::White);
+    EXPECT_EQ(SEQUENCE_RUN, result.command);
+    EXPECT_EQ(SequenceMode::Loop, result.mode);
+}
+
+TEST_F(ParsingTests, parse_binary_fail)
+{
+    const uint8_t short_limit[] = {'0', 0x54, 0xFF};
+    const uint8_t short_time[] = {'2', 0x77, 0x55, 0x14, 0x00, 0x00, 0x00};
+    const uint8_t partial_keyframe[] = {'4', 0x10, 0x00, 0x00, 0x00, 0x00, 0, 0x20};
+    const uint8_t wrong_easing[] = {'4', 0x10, 0x00, 0x00, 0x00, 0x00, 4};
+    const uint8_t wrong_mode[] = {'5', 3};
+    const uint8_t wrong_command[] = {'9', 0x54};
+
+    parsing_should_be_failed(parse_binary_command(short_limit, sizeof(short_limit), LedType::Color));
+    parsing_should_be_failed(parse_binary_command(short_time, sizeof(short_time), LedType::White));
+    parsing_should_be_failed(parse_binary_command(partial_keyframe, sizeof(partial_keyframe), LedType::White));
+    parsing_should_be_failed(parse_binary_command(wrong_easing, sizeof(wrong_easing), LedType::White));
+    parsing_should_be_failed(parse_binary_command(wrong_mode, sizeof(wrong_mode), LedType::White));
+    parsing_should_be_failed(parse_binary_command(wrong_command, sizeof(wrong_command), LedType::White));
+    parsing_should_be_failed(parse_binary_command(nullptr, 0, LedType::White));
+}
@@ -0,0 +1,143 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "Kitchen/Sequence.h"
+
+using namespace ::testing;
+
+class SequenceTests : public testing::Test
+{
+public:
+    SequenceTests()
+    {
+        sequence_clear(sequence);
+    }
+
+    void expect_fade(bool jump, uint8_t W, unsigned long time)
+    {
+        SequenceFade fade;
+        ASSERT_TRUE(sequence_next(sequence, fade));
+        EXPECT_EQ(jump, fade.from != nullptr);
+        EXPECT_EQ(W, fade.to.W);
+        EXPECT_EQ(time, fade.time);
+    }
+
+    StepSequence sequence;
+};
+
+TEST_F(SequenceTests, linear_keyframes_take_one_step)
+{
+    EXPECT_TRUE(sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 0x10}, 0, Easing::Linear}));
+    EXPECT_TRUE(sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 0x80}, 1000, Easing::Linear}));
+
+    EXPECT_EQ(2, sequence.count);
+    EXPECT_EQ(0x80, sequence.steps[1].value.W);
+    EXPECT_EQ(1000U, sequence.steps[1].time);
+}
+
+TEST_F(SequenceTests, eased_keyframe_is_split)
+{
+    sequence_add_keyframe(sequence, Keyframe{{0, 0xFF, 0, 0}, 0, Easing::Linear});
+    EXPECT_TRUE(sequence_add_keyframe(sequence, Keyframe{{0xFF, 0, 0, 0}, 1001, Easing::EaseIn}));
+
+    ASSERT_EQ(1 + EASING_STEPS, sequence.count);
+
+    const uint8_t R[] = {16, 64, 143, 255};
+    unsigned long time = 0;
+    for (uint8_t i = 0; i < EASING_STEPS; i++) {
+        EXPECT_EQ(R[i], sequence.steps[i + 1].value.R);
+        EXPECT_EQ(0xFF - R[i], sequence.steps[i + 1].value.G);
+        time += sequence.steps[i + 1].time;
+    }
+    EXPECT_EQ(1001U, time);
+}
+
+TEST_F(SequenceTests, short_keyframes_are_stretched)
+{
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 0}, 0, Easing::Linear});
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 0xFF}, 0, Easing::Linear});
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 0}, 50, Easing::EaseOut});
+
+    ASSERT_EQ(3, sequence.count);
+    EXPECT_LT(20U, sequence.steps[1].time);
+    EXPECT_EQ(50U, sequence.steps[2].time);
+}
+
+TEST_F(SequenceTests, full_sequence_fail)
+{
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 0}, 0, Easing::Linear});
+    for (uint8_t i = 1; i < SEQUENCE_MAX_STEPS; i++) {
+        EXPECT_TRUE(sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, i}, 100, Easing::Linear}));
+    }
+
+    EXPECT_FALSE(sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 0}, 100, Easing::Linear}));
+    EXPECT_EQ(SEQUENCE_MAX_STEPS, sequence.count);
+}
+
+TEST_F(SequenceTests, one_shot_pass)
+{
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 1}, 0, Easing::Linear});
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 2}, 100, Easing::Linear});
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 3}, 200, Easing::Linear});
+    sequence.mode = SequenceMode::OneShot;
+
+    sequence_rewind(sequence);
+    expect_fade(true, 2, 100);
+    expect_fade(false, 3, 200);
+
+    SequenceFade fade;
+    EXPECT_FALSE(sequence_next(sequence, fade));
+}
+
+TEST_F(SequenceTests, loop_pass)
+{
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 1}, 0, Easing::Linear});
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 2}, 100, Easing::Linear});
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 3}, 200, Easing::Linear});
+    sequence.mode = SequenceMode::Loop;
+
+    sequence_rewind(sequence);
+    for (int i = 0; i < 3; i++) {
+        expect_fade(true, 2, 100);
+        expect_fade(false, 3, 200);
+    }
+}
+
+TEST_F(SequenceTests, ping_pong_pass)
+{
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 1}, 0, Easing::Linear});
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 2}, 100, Easing::Linear});
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 3}, 200, Easing::Linear});
+    sequence.mode = SequenceMode::PingPong;
+
+    sequence_rewind(sequence);
+    expect_fade(true, 2, 100);
+    expect_fade(false, 3, 200);
+    for (int i = 0; i < 3; i++) {
+        expect_fade(false, 2, 200);
+        expect_fade(false, 1, 100);
+        expect_fade(false, 2, 100);
+        expect_fade(false, 3, 200);
+    }
+}
+
+TEST_F(SequenceTests, single_keyframe_does_nothing)
+{
+    sequence_add_keyframe(sequence, Keyframe{{0, 0, 0, 1}, 0, Easing::Linear});
+    sequence.mode = SequenceMode::Loop;
+
+    SequenceFade fade;
+    sequence_rewind(sequence);
+    EXPECT_FALSE(sequence_next(sequence, fade));
+}
+
+TEST_F(SequenceTests, from_transition_pass)
+{
+    sequence_from_transition(sequence, Transition{{1, 2, 3, 4}, {5, 6, 7, 8}, 300, true});
+
+    EXPECT_EQ(SequenceMode::PingPong, sequence.mode);
+    ASSERT_EQ(2, sequence.count);
+    EXPECT_EQ(4, sequence.steps[0].value.W);
+    EXPECT_EQ(8, sequence.steps[1].value.W);
+    EXPECT_EQ(300U, sequence.steps[1].time);
+}
@@ -1,6 +1,11 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <EEPROMJournal.h>
+#include <EEPROMSimulator.h>
+
+#include "../../mocks/Arduino.h"
+
 #include "Kitchen/Storage.h"
 
 using namespace ::testing;
@@ -10,6 +15,8 @@ extern Storage storage;
 
 void load_storage();
 
+#define RECORD_SIZE (sizeof(Storage) + 3)
+
 class StorageTests : public testing::Test
 {
 public:
@@ -20,6 +27,7 @@ public:
 
     ~StorageTests()
     {
+        Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
         Mock::VerifyAndClearExpectations(&eeprom);
     }
 };
@@ -44,3 +52,78 @@ TEST_F(StorageTests, load_storage_fallback)
     EXPECT_EQ(0xFF, storage.colors[SwitchingSource::Button].B);
     EXPECT_EQ(0xFF, storage.colors[SwitchingSource::Button].W);
 }
+
+TEST_F(StorageTests, load_storage_migrate_legacy)
+{
+    Storage storage_mock = {STORAGE_LEGACY_VERSION, {{0x11, 0x22, 0x33, 0x44}, {0x21, 0x32, 0x43, 0x54}}};
+
+    EXPECT_CALL(eeprom, get(STORAGE_LEGACY_ADDRESS, _)).WillOnce(DoAll(
+        SetArgReferee<1>(storage_mock),
+        ReturnRef(storage_mock)));
+    EXPECT_CALL(eeprom, update(Ge(STORAGE_JOURNAL_ADDRESS), _)).Times(AtLeast(1));
+    EXPECT_CALL(eeprom, update(Lt(STORAGE_JOURNAL_ADDRESS), _)).Times(0);
+
+    load_storage();
+
+    EXPECT_EQ(STORAGE_VERSION, storage.version);
+    EXPECT_EQ(0x11, storage.colors[SwitchingSource::External].R);
+    EXPECT_EQ(0x44, storage.colors[SwitchingSource::External].W);
+    EXPECT_EQ(0x21, storage.colors[SwitchingSource::Button].R);
+    EXPECT_EQ(0x54, storage.colors[SwitchingSource::Button].W);
+}
+
+TEST_F(StorageTests, load_storage_from_journal)
+{
+    EEPROMSimulator<> simulator;
+    EEPROMJournal<Storage, EEPROMSimulator<>> journal(simulator, STORAGE_JOURNAL_ADDRESS, STORAGE_JOURNAL_SLOTS);
+    journal.save(Storage{STORAGE_VERSION, {{1, 2, 3, 4}, {5, 6, 7, 8}}});
+    journal.save(Storage{STORAGE_VERSION, {{0x11, 0x22, 0x33, 0x44}, {0x21, 0x32, 0x43, 0x54}}});
+
+    EXPECT_CALL(eeprom, read(_)).WillRepeatedly(Invoke([&simulator](int idx) {
+        return simulator.read(idx);
+    }));
+    EXPECT_CALL(eeprom, get(_, _)).Times(0);
+
+    load_storage();
+
+    EXPECT_EQ(STORAGE_VERSION, storage.version);
+    EXPECT_EQ(0x11, storage.colors[SwitchingSource::External].R);
+    EXPECT_EQ(0x44, storage.colors[SwitchingSource::External].W);
+    EXPECT_EQ(0x21, storage.colors[SwitchingSource::Button].R);
+    EXPECT_EQ(0x54, storage.colors[SwitchingSource::Button].W);
+}
+
+TEST_F(StorageTests, save_is_deferred)
+{
+    EXPECT_CALL(eeprom, update(_, _)).Times(0);
+
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(1000));
+    save_color_leds(SwitchingSource::External, 0x10, 0x20, 0x30);
+    storage_process();
+
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(2000));
+    save_white_leds(SwitchingSource::External, 0x40);
+    storage_process();
+
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(2000 + STORAGE_QUIET_TIME_MS - 1));
+    storage_process();
+}
+
+TEST_F(StorageTests, save_one_cell_per_process)
+{
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillRepeatedly(Return(1000));
+    save_color_leds(SwitchingSource::External, 0x10, 0x20, 0x30);
+    save_white_leds(SwitchingSource::External, 0x40);
+    storage_process();
+    Mock::VerifyAndClearExpectations(&eeprom);
+
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillRepeatedly(Return(1000 + STORAGE_QUIET_TIME_MS));
+    for (unsigned int i = 0; i < RECORD_SIZE; i++) {
+        EXPECT_CALL(eeprom, update(_, _)).Times(1);
+        storage_process();
+        Mock::VerifyAndClearExpectations(&eeprom);
+    }
+
+    EXPECT_CALL(eeprom, update(_, _)).Times(0);
+    storage_process();
+}
@@ -0,0 +1,209 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "../../mocks/Arduino.h"
+
+#include "LEDFader/LEDFaderGroup.h"
+
+using namespace ::testing;
+
+static int completions;
+
+static void on_complete(void * data)
+{
+    completions++;
+    EXPECT_EQ(&completions, data);
+}
+
+class LEDFaderGroupTests : public testing::Test
+{
+public:
+    LEDFaderGroupTests() :
+        now{0},
+        leds{pins}
+    {
+        completions = 0;
+        ON_CALL(ArduinoMock::mock(), millis()).WillByDefault(ReturnPointee(&now));
+        leds.on_complete(on_complete, &completions);
+    }
+
+    ~LEDFaderGroupTests()
+    {
+        Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    }
+
+    const uint8_t pins[4] = {3, 5, 6, 9};
+    unsigned long now;
+    LEDFaderGroup<4> leds;
+};
+
+TEST_F(LEDFaderGroupTests, fade_reaches_target_once_pass)
+{
+    const uint8_t from[] = {0, 0x10, 0xFF, 0x80};
+    const uint8_t to[] = {0xFF, 0x20, 0, 0x80};
+
+    leds.set_values(from);
+    leds.fade(to, 1000);
+
+    EXPECT_TRUE(leds.is_fading());
+
+    for (now = 1; now < 1000; now++) {
+        ASSERT_TRUE(leds.update(now));
+    }
+    EXPECT_EQ(0, completions);
+
+    EXPECT_FALSE(leds.update(now));
+    EXPECT_FALSE(leds.update(now + 100));
+    EXPECT_EQ(1, completions);
+
+    for (uint8_t i = 0; i < 4; i++) {
+        EXPECT_EQ(to[i], leds.get_value(i));
+    }
+}
+
+TEST_F(LEDFaderGroupTests, channels_stay_in_step_pass)
+{
+    const uint8_t from[] = {0, 0, 0xFF, 0x10};
+    const uint8_t to[] = {0xFF, 0xFF, 0, 0x40};
+
+    leds.set_values(from);
+    leds.fade(to, 3000);
+
+    for (now = 7; now < 3000; now += 7) {
+        leds.update(now);
+
+        // Both channels going up the same range are always at the same value, the one going
+        // down mirrors them
+        ASSERT_EQ(leds.get_value(0), leds.get_value(1)) << "now=" << now;
+        ASSERT_NEAR(0xFF - leds.get_value(0), leds.get_value(2), 1) << "now=" << now;
+    }
+}
+
+TEST_F(LEDFaderGroupTests, update_reads_no_clock_pass)
+{
+    const uint8_t to[] = {0x10, 0x20, 0x30, 0x40};
+
+    leds.fade(to, 1000);
+
+    EXPECT_CALL(ArduinoMock::mock(), millis()).Times(0);
+    EXPECT_CALL(ArduinoMock::mock(), analogWrite(_, _)).Times(4);
+
+    leds.update(1000);
+}
+
+TEST_F(LEDFaderGroupTests, fade_without_changes_holds_pass)
+{
+    const uint8_t values[] = {0x10, 0x20, 0x30, 0x40};
+
+    leds.set_values(values);
+    leds.fade(values, 500);
+
+    EXPECT_CALL(ArduinoMock::mock(), analogWrite(_, _)).Times(0);
+
+    EXPECT_TRUE(leds.update(499));
+    EXPECT_FALSE(leds.update(500));
+    EXPECT_EQ(1, completions);
+}
+
+TEST_F(LEDFaderGroupTests, fade_too_short_sets_values_pass)
+{
+    const uint8_t to[] = {0x10, 0x20, 0x30, 0x40};
+
+    leds.fade(to, LEDFaderGroup<4>::MIN_INTERVAL);
+
+    EXPECT_FALSE(leds.is_fading());
+    EXPECT_EQ(0x40, leds.get_value(3));
+    EXPECT_EQ(1, completions);
+}
+
+TEST_F(LEDFaderGroupTests, channel_without_pin_is_not_written_pass)
+{
+    const uint8_t no_pins[] = {3, 0};
+    const uint8_t to[] = {0x10, 0x20};
+    LEDFaderGroup<2> group{no_pins};
+
+    EXPECT_CALL(ArduinoMock::mock(), analogWrite(3, 0x10)).Times(1);
+    EXPECT_CALL(ArduinoMock::mock(), analogWrite(0, _)).Times(0);
+
+    group.set_values(to);
+    EXPECT_EQ(0x20, group.get_value(1));
+}
+
+TEST_F(LEDFaderGroupTests, curve_transforms_output_only_pass)
+{
+    const uint8_t to[] = {0x10, 0x20, 0x30, 0x40};
+
+    leds.set_curve([](uint8_t value) -> uint8_t { return value / 2; });
+
+    EXPECT_CALL(ArduinoMock::mock(), analogWrite(9, 0x20)).Times(1);
+    EXPECT_CALL(ArduinoMock::mock(), analogWrite(Ne(9), _)).Times(3);
+
+    leds.set_values(to);
+    EXPECT_EQ(0x40, leds.get_value(3));
+}
+
+TEST_F(LEDFaderGroupTests, stop_fade_pass)
+{
+    const uint8_t to[] = {0xFF, 0xFF, 0xFF, 0xFF};
+
+    leds.fade(to, 1000);
+    leds.update(500);
+    leds.stop_fade();
+
+    EXPECT_FALSE(leds.is_fading());
+    EXPECT_FALSE(leds.update(1000));
+    EXPECT_NEAR(0x80, leds.get_value(0), 1);
+    EXPECT_EQ(0, completions);
+}
+
+TEST_F(LEDFaderGroupTests, get_progress_pass)
+{
+    const uint8_t to[] = {0xFF, 0, 0, 0};
+
+    leds.fade(to, 1000);
+    EXPECT_EQ(0, leds.get_progress());
+
+    leds.update(250);
+    EXPECT_EQ(25, leds.get_progress());
+
+    leds.update(1000);
+    EXPECT_EQ(100, leds.get_progress());
+}
+
+TEST_F(LEDFaderGroupTests, get_progress_of_short_fade_pass)
+{
+    const uint8_t to[] = {100, 0, 0, 0};
+
+    leds.fade(to, 150);
+    leds.update(75);
+    EXPECT_EQ(50, leds.get_progress());
+
+    now = 75;
+    leds.fade(to, 199);
+    leds.update(175);
+    EXPECT_EQ(50, leds.get_progress());
+}
+
+TEST_F(LEDFaderGroupTests, fade_from_complete_callback_pass)
+{
+    static LEDFaderGroup<4> * group;
+    static const uint8_t back[] = {0, 0, 0, 0};
+    const uint8_t to[] = {0xFF, 0xFF, 0xFF, 0xFF};
+
+    group = &leds;
+    leds.on_complete([](void * data) {
+        completions++;
+        group->fade(back, 1000);
+    });
+    leds.fade(to, 1000);
+
+    // The next fade starts from the moment the first one ends
+    now = 1000;
+    EXPECT_TRUE(leds.update(1000));
+    EXPECT_EQ(0xFF, leds.get_value(0));
+    EXPECT_TRUE(leds.is_fading());
+
+    EXPECT_TRUE(leds.update(2000));
+    EXPECT_EQ(0, leds.get_value(0));
+    EXPECT_EQ(2, completions);
+}
@@ -0,0 +1,316 @@
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "../../mocks/Arduino.h"
+
+#include "LEDFader/LEDFader.h"
+#include "LEDFader/FadeStepper.h"
+
+using namespace ::testing;
+
+// The float engine LEDFader::update() used before FadeStepper. Kept as the reference
+// the new engine is checked and benchmarked against.
+class FloatFader
+{
+public:
+    void set_value(uint8_t value)
+    {
+        color = value;
+    }
+
+    uint8_t get_value()
+    {
+        return color;
+    }
+
+    void fade(uint8_t value, unsigned long time, unsigned long now)
+    {
+        duration = 0;
+        if (value == color) {
+            return;
+        }
+
+        duration = time;
+        to_color = value;
+
+        float color_diff = abs(color - to_color);
+        interval = round((float)duration / color_diff);
+        if (interval < LEDFader::MIN_INTERVAL) {
+            interval = LEDFader::MIN_INTERVAL;
+        }
+
+        last_step_time = now;
+    }
+
+    bool update(unsigned long now)
+    {
+        if (duration == 0) {
+            return false;
+        }
+
+        unsigned long time_diff = now - last_step_time;
+        if (time_diff < interval) {
+            return true;
+        }
+
+        float percent = (float)time_diff / (float)duration;
+        percent_done += percent;
+
+        if (percent >= 1) {
+            duration = 0;
+            color = to_color;
+            return false;
+        }
+
+        int color_diff = to_color - color;
+        int increment = round(color_diff * percent);
+        color = color + increment;
+
+        duration -= time_diff;
+        last_step_time = now;
+        return true;
+    }
+
+private:
+    unsigned long last_step_time = 0;
+    unsigned long interval = 0;
+    uint8_t color = 0;
+    uint8_t to_color = 0;
+    unsigned long duration = 0;
+    float percent_done = 0;
+};
+
+class LEDFaderTests : public testing::Test
+{
+public:
+    LEDFaderTests() :
+        now{0},
+        led{3}
+    {
+        ON_CALL(ArduinoMock::mock(), millis()).WillByDefault(ReturnPointee(&now));
+    }
+
+    ~LEDFaderTests()
+    {
+        Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    }
+
+    // Runs both engines over the same fade, sampling them every `tick` ms. At the moment of its
+    // last step the fixed-point engine has to be within one PWM step of the exact line, and so of
+    // the float engine. The float engine itself strays up to a few steps off the line on short
+    // steps, as every increment it makes is rounded on its own; that much extra is allowed.
+    void expect_same_fade(uint8_t from, uint8_t to, unsigned long time, unsigned long tick)
+    {
+        FloatFader reference;
+        unsigned long start = now;
+        unsigned long last_step = now;
+        unsigned long interval = std::max(lround((double)time / abs(from - to)), (long)LEDFader::MIN_INTERVAL);
+
+        led.set_value(from);
+        reference.set_value(from);
+        led.fade(to, time);
+        reference.fade(to, time, now);
+
+        bool fading = true;
+        while (fading) {
+            now += tick;
+            fading = led.update();
+            bool reference_fading = reference.update(now);
+
+            if (now - last_step >= interval) {
+                last_step = now;
+            }
+            unsigned long elapsed = std::min(last_step - start, time);
+            double exact = from + (double)(to - from) * elapsed / time;
+
+            ASSERT_EQ(reference_fading, fading) << "from=" << (int)from << ", to=" << (int)to
+                                                << ", time=" << time << ", elapsed=" << elapsed;
+            ASSERT_NEAR(exact, led.get_value(), 1) << "from=" << (int)from << ", to=" << (int)to
+                                                   << ", time=" << time << ", elapsed=" << elapsed;
+            ASSERT_NEAR(reference.get_value(), led.get_value(), std::abs(exact - reference.get_value()) + 1)
+                << "from=" << (int)from << ", to=" << (int)to << ", time=" << time << ", elapsed=" << elapsed;
+        }
+        EXPECT_EQ(to, led.get_value());
+    }
+
+    unsigned long now;
+    LEDFader led;
+};
+
+TEST_F(LEDFaderTests, fade_reaches_target_pass)
+{
+    led.set_value(0x10);
+    led.fade(0xF0, 1000);
+
+    EXPECT_TRUE(led.is_fading());
+    EXPECT_EQ(0xF0, led.get_target_value());
+
+    now = 500;
+    EXPECT_TRUE(led.update());
+    EXPECT_NEAR(0x80, led.get_value(), 1);
+
+    now = 1000;
+    EXPECT_FALSE(led.update());
+    EXPECT_EQ(0xF0, led.get_value());
+    EXPECT_FALSE(led.is_fading());
+}
+
+TEST_F(LEDFaderTests, fade_waits_for_interval_pass)
+{
+    led.set_value(0);
+    led.fade(10, 1000);
+
+    EXPECT_CALL(ArduinoMock::mock(), analogWrite(3, _)).Times(0);
+
+    now = 99;
+    EXPECT_TRUE(led.update());
+    EXPECT_EQ(0, led.get_value());
+}
+
+TEST_F(LEDFaderTests, fade_too_short_sets_value_pass)
+{
+    EXPECT_CALL(ArduinoMock::mock(), analogWrite(3, 0x40));
+
+    led.fade(0x40, LEDFader::MIN_INTERVAL);
+
+    EXPECT_FALSE(led.is_fading());
+    EXPECT_EQ(0x40, led.get_value());
+}
+
+TEST_F(LEDFaderTests, fade_catches_up_after_stall_pass)
+{
+    led.set_value(0);
+    led.fade(200, 2000);
+
+    now = 1500;
+    EXPECT_TRUE(led.update());
+    EXPECT_NEAR(150, led.get_value(), 1);
+
+    now = 5000;
+    EXPECT_FALSE(led.update());
+    EXPECT_EQ(200, led.get_value());
+}
+
+TEST_F(LEDFaderTests, get_progress_pass)
+{
+    led.set_value(0xFF);
+    led.fade(0, 1000);
+    EXPECT_EQ(0, led.get_progress());
+
+    now = 250;
+    led.update();
+    EXPECT_EQ(25, led.get_progress());
+
+    now = 1000;
+    led.update();
+    EXPECT_EQ(100, led.get_progress());
+}
+
+TEST_F(LEDFaderTests, get_progress_of_short_fade_pass)
+{
+    // As the transitions of the Kitchen node
+    led.set_value(0);
+    led.fade(100, 150);
+
+    now = 75;
+    led.update();
+    EXPECT_EQ(50, led.get_progress());
+
+    led.set_value(0);
+    led.fade(100, 199);
+    now += 100;
+    led.update();
+    EXPECT_EQ(50, led.get_progress());
+}
+
+TEST_F(LEDFaderTests, slower_keeps_progress_pass)
+{
+    led.set_value(0);
+    led.fade(100, 1000);
+
+    now = 500;
+    led.update();
+    led.slower(1000);
+
+    EXPECT_TRUE(led.is_fading());
+    EXPECT_EQ(50, led.get_progress());
+
+    now = 1250;
+    EXPECT_TRUE(led.update());
+    EXPECT_EQ(100, led.get_target_value());
+    EXPECT_EQ(75, led.get_progress());
+}
+
+TEST_F(LEDFaderTests, faster_ends_fade_pass)
+{
+    led.set_value(0);
+    led.fade(100, 1000);
+
+    led.faster(1000);
+
+    EXPECT_FALSE(led.is_fading());
+    EXPECT_EQ(100, led.get_value());
+}
+
+TEST_F(LEDFaderTests, matches_float_engine_pass)
+{
+    const uint8_t values[] = {0, 1, 0x10, 0x7F, 0xF0, 0xFF};
+    const unsigned long times[] = {21, 100, 255, 1000, 3000, 65000};
+    const unsigned long ticks[] = {1, 7, 20, 150};
+
+    for (uint8_t from : values) {
+        for (uint8_t to : values) {
+            for (unsigned long time : times) {
+                for (unsigned long tick : ticks) {
+                    expect_same_fade(from, to, time, tick);
+                    if (HasFatalFailure()) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Not a pass/fail test, so it's disabled; run it with --gtest_also_run_disabled_tests. It prints
+// the host cost of one fade step for both engines. The host has an FPU and says nothing about AVR,
+// where the float engine calls the soft-float library and the fixed-point one doesn't.
+TEST_F(LEDFaderTests, DISABLED_benchmark_update)
+{
+    const int updates = 10000000;
+    const unsigned long tick = 25;
+
+    auto measure = [updates](auto && update) {
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < updates; i++) {
+            update();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - begin).count() / updates;
+    };
+
+    FloatFader reference;
+    unsigned long clock = 0;
+    double float_ns = measure([&]() {
+        clock += tick;
+        if (!reference.update(clock)) {
+            reference.fade(reference.get_value() ? 0 : 0xFF, 3000, clock);
+        }
+    });
+
+    FadeStepper stepper;
+    double fixed_ns = measure([&]() {
+        if (!stepper.advance(tick)) {
+            stepper.start(stepper.get_value(), stepper.get_value() ? 0 : 0xFF, 3000);
+        }
+    });
+
+    std::cout << "Fade step: float engine " << float_ns << " ns, fixed-point engine " << fixed_ns << " ns"
+              << std::endl;
+    EXPECT_EQ(reference.get_value() != 0, stepper.get_value() != 0);
+}
@@ -11,9 +11,14 @@ using namespace ::testing;
 class LightSwitchACTests : public testing::Test
 {
 public:
-    LightSwitchACTests()
+    LightSwitchACTests() :
+        now{0}
     {
+        ON_CALL(ArduinoMock::mock(), micros()).WillByDefault(Invoke([this]() {
+            return now;
+        }));
         reset();
+        phase_dimmer.setup();
     }
     ~LightSwitchACTests()
     {
@@ -21,6 +26,8 @@ public:
         Mock::VerifyAndClearExpectations(&MySensorsMock::mock());
         Mock::VerifyAndClearExpectations(&EEPROM);
     }
+
+    unsigned long now;
 };
 
 TEST_F(LightSwitchACTests, loop_no_changes_pass)
@@ -30,8 +37,7 @@ TEST_F(LightSwitchACTests, loop_no_changes_pass)
 
 TEST_F(LightSwitchACTests, receive_light_level_overload_pass)
 {
-    EXPECT_CALL(EEPROM, update(10, 0)).WillOnce(Return());
-    EXPECT_CALL(EEPROM, read(10)).WillOnce(Return(0));
+    EXPECT_CALL(EEPROM, update(_, _)).Times(0);
 
     MyMessage message1(MS_LAMP_ID, V_LIGHT_LEVEL);
     MyMessage message2(MS_LAMP_ID, V_LIGHT);
@@ -46,8 +52,7 @@ TEST_F(LightSwitchACTests, receive_light_level_overload_pass)
 
 TEST_F(LightSwitchACTests, receive_light_level_zero_pass)
 {
-    EXPECT_CALL(EEPROM, update(10, DIMMER_MAX)).WillOnce(Return());
-    EXPECT_CALL(EEPROM, read(10)).WillOnce(Return(DIMMER_MAX));
+    EXPECT_CALL(EEPROM, update(_, _)).Times(0);
 
     MyMessage message1(MS_LAMP_ID, V_LIGHT_LEVEL);
     MyMessage message2(MS_LAMP_ID, V_LIGHT);
@@ -60,6 +65,26 @@ TEST_F(LightSwitchACTests, receive_light_level_zero_pass)
     EXPECT_EQ(DIMMER_MAX, dimmer.target);
 }
 
+TEST_F(LightSwitchACTests, light_level_saved_when_idle)
+{
+    EXPECT_CALL(MySensorsMock::mock(), send(_, false)).WillRepeatedly(Return(true));
+    EXPECT_CALL(EEPROM, update(_, _)).Times(0);
+
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillRepeatedly(Return(1000));
+    receive(MyMessage(MS_LAMP_ID, V_LIGHT_LEVEL).set(10));
+    loop();
+    receive(MyMessage(MS_LAMP_ID, V_LIGHT_LEVEL).set(20));
+    loop();
+    Mock::VerifyAndClearExpectations(&EEPROM);
+
+    EXPECT_CALL(EEPROM, update(EEPROM_OFFSET, light_dimmer_convert(20))).WillOnce(Return());
+    EXPECT_CALL(EEPROM, read(EEPROM_OFFSET)).WillOnce(Return(light_dimmer_convert(20)));
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillRepeatedly(Return(1000 + EEPROM_QUIET_TIME_MS));
+    loop();
+    loop();
+    EXPECT_EQ(0, limit_record.get_failures());
+}
+
 TEST_F(LightSwitchACTests, receive_light_true_pass)
 {
     MyMessage message(MS_LAMP_ID, V_LIGHT);
@@ -106,8 +131,7 @@ TEST_F(LightSwitchACTests, receive_relay2_off_pass)
 
 TEST_F(LightSwitchACTests, dimmer_actual_is_eq_target_pass)
 {
-    dimmer.actual = 1;
-    dimmer.target = 1;
+    dimmer_jump(1);
 
     dimmer_process();
     EXPECT_EQ(1, dimmer.actual);
@@ -115,11 +139,11 @@ TEST_F(LightSwitchACTests, dimmer_actual_is_eq_target_pass)
 
 TEST_F(LightSwitchACTests, dimmer_goes_up_pass)
 {
-    dimmer.actual = 1;
+    dimmer_jump(1);
     dimmer.target = 100;
-    dimmer.delay = 10;
+    dimmer.fade_time = DIMMER_HIGH * 10;
 
-    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(5));
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(0));
     dimmer_process();
     EXPECT_EQ(1, dimmer.actual);
     EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(10));
@@ -132,11 +156,11 @@ TEST_F(LightSwitchACTests, dimmer_goes_up_pass)
 
 TEST_F(LightSwitchACTests, dimmer_goes_down_pass)
 {
-    dimmer.actual = 20;
+    dimmer_jump(20);
     dimmer.target = 5;
-    dimmer.delay = 10;
+    dimmer.fade_time = DIMMER_HIGH * 10;
 
-    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(5));
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(0));
     dimmer_process();
     EXPECT_EQ(20, dimmer.actual);
     EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(10));
@@ -146,3 +170,137 @@ TEST_F(LightSwitchACTests, dimmer_goes_down_pass)
     dimmer_process();
     EXPECT_EQ(18, dimmer.actual);
 }
+
+TEST_F(LightSwitchACTests, dimmer_catches_up_after_stall)
+{
+    dimmer_jump(1);
+    dimmer.target = 100;
+    dimmer.fade_time = DIMMER_HIGH * 10;
+
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(0));
+    dimmer_process();
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(500));
+    dimmer_process();
+    EXPECT_EQ(51, dimmer.actual);
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(5000));
+    dimmer_process();
+    EXPECT_EQ(100, dimmer.actual);
+}
+
+TEST_F(LightSwitchACTests, dimmer_moves_between_steps)
+{
+    dimmer_jump(10);
+    dimmer.target = 11;
+    dimmer.fade_time = DIMMER_HIGH * 100;
+
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(0));
+    dimmer_process();
+    unsigned int from = phase_dimmer.get_delay(0);
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(50));
+    dimmer_process();
+    unsigned int middle = phase_dimmer.get_delay(0);
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(100));
+    dimmer_process();
+    unsigned int to = phase_dimmer.get_delay(0);
+
+    EXPECT_GT(middle, from);
+    EXPECT_LT(middle, to);
+}
+
+TEST_F(LightSwitchACTests, receive_fade_time_pass)
+{
+    EXPECT_CALL(MySensorsMock::mock(), send(_, false)).WillRepeatedly(Return(true));
+    dimmer_jump(DIMMER_HIGH);
+
+    receive(MyMessage(MS_LAMP_ID, V_VAR2).set((uint32_t)3000));
+    EXPECT_EQ(3000U, dimmer_fade_time);
+
+    receive(MyMessage(MS_LAMP_ID, V_LIGHT).set(1));
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(0));
+    dimmer_process();
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(1500));
+    dimmer_process();
+    EXPECT_EQ(DIMMER_HIGH / 2, dimmer.actual);
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(3000));
+    dimmer_process();
+    EXPECT_EQ(0, dimmer.actual);
+
+    receive(MyMessage(MS_LAMP_ID, V_VAR2).set((uint32_t)1000000));
+    EXPECT_EQ((unsigned long)FADE_TIME_MAX_MS, dimmer_fade_time);
+}
+
+TEST_F(LightSwitchACTests, zero_cross_arms_timer)
+{
+    dimmer_jump(50);
+    unsigned int delay = dimmer_curve.get_delay(50 << 8, ZeroCrossTracker::HALF_PERIOD_50HZ);
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(PIN_OUT_AC, LOW));
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(PIN_OUT_AC, HIGH)).Times(0);
+    on_zero_cross_detect();
+    EXPECT_EQ(delay, timer_service.get_next_delay());
+    Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(PIN_OUT_AC, HIGH));
+    now += delay;
+    timer_service.on_compare();
+}
+
+TEST_F(LightSwitchACTests, zero_cross_lamp_off)
+{
+    dimmer_jump(DIMMER_HIGH);
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(PIN_OUT_AC, LOW));
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(PIN_OUT_AC, HIGH)).Times(0);
+    on_zero_cross_detect();
+
+    EXPECT_EQ(TimerService::NEVER, timer_service.get_next_delay());
+}
+
+TEST_F(LightSwitchACTests, zero_cross_full_power)
+{
+    dimmer_jump(DIMMER_LOW);
+
+    InSequence s;
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(PIN_OUT_AC, LOW));
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(PIN_OUT_AC, HIGH));
+    on_zero_cross_detect();
+
+    EXPECT_EQ(TimerService::NEVER, timer_service.get_next_delay());
+}
+
+TEST_F(LightSwitchACTests, zero_cross_glitch_ignored)
+{
+    dimmer_jump(50);
+
+    now = 1000;
+    on_zero_cross_detect();
+    unsigned long delay = timer_service.get_next_delay();
+    ASSERT_NE(TimerService::NEVER, delay);
+
+    now = 1200;
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(PIN_OUT_AC, _)).Times(0);
+    on_zero_cross_detect();
+    EXPECT_EQ(delay - 200, timer_service.get_next_delay());
+}
+
+TEST_F(LightSwitchACTests, mains_60hz_rescales_delay)
+{
+    dimmer_jump(64);
+
+    for (unsigned long i = 0; i <= ZeroCrossTracker::LOCK_EDGES; i++) {
+        now = i * ZeroCrossTracker::HALF_PERIOD_60HZ;
+        on_zero_cross_detect();
+    }
+    ASSERT_EQ(60, zero_cross.get_frequency());
+
+    loop();
+    EXPECT_EQ(dimmer_curve.get_delay(64 << 8, ZeroCrossTracker::HALF_PERIOD_60HZ), phase_dimmer.get_delay(0));
+}
+
+TEST_F(LightSwitchACTests, dimmer_curve_is_perceptual)
+{
+    // Half the lightness is about a fifth of the power, so the triac fires well after the middle
+    unsigned int delay = dimmer_curve.get_delay((DIMMER_HIGH / 2) << 8, ZeroCrossTracker::HALF_PERIOD_50HZ);
+    EXPECT_GT(delay, ZeroCrossTracker::HALF_PERIOD_50HZ * 6 / 10);
+    EXPECT_EQ(PhaseDimmer::OFF, dimmer_curve.get_delay(DIMMER_HIGH << 8, ZeroCrossTracker::HALF_PERIOD_50HZ));
+}
@@ -0,0 +1,147 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "Logging/LogRing.h"
+
+using namespace ::testing;
+
+#define RING_SIZE   96
+
+// Stands in for Serial
+struct StringSink
+{
+    size_t write(uint8_t c)
+    {
+        text += (char)c;
+        return 1;
+    }
+
+    std::string text;
+};
+
+class LogRingTests : public testing::Test
+{
+public:
+    LogRingTests() :
+        from{0}
+    {
+    }
+
+    std::string pop()
+    {
+        StringSink sink;
+        if (!ring.print(sink, 0xFFFF, from)) {
+            return "<empty>";
+        }
+        return sink.text;
+    }
+
+    LogRing<RING_SIZE> ring;
+    uint16_t from;
+};
+
+TEST_F(LogRingTests, empty)
+{
+    EXPECT_TRUE(ring.is_empty());
+    EXPECT_EQ("<empty>", pop());
+}
+
+TEST_F(LogRingTests, integers)
+{
+    uint8_t level = 200;
+    ring.push("[INFO] %d %u %x %02x %c %lu", "file.ino", 12, -5, 40000U, 0xAB, level, 'z', 4000000000UL);
+
+    EXPECT_EQ("[INFO] -5 40000 ab c8 z 4000000000 [file.ino:12]\r\n", pop());
+    EXPECT_TRUE(ring.is_empty());
+}
+
+TEST_F(LogRingTests, strings_are_copied)
+{
+    char payload[] = "1;2;ff00ff";
+    ring.push("data=%s, dir=%s", "a.cpp", 1, payload, true ? "up" : "down");
+    strcpy(payload, "gone");
+
+    EXPECT_EQ("data=1;2;ff00ff, dir=up [a.cpp:1]\r\n", pop());
+}
+
+TEST_F(LogRingTests, precision_string)
+{
+    const char * token = "abcdef";
+    ring.push("token: %.*s!", "a.cpp", 1, 3, token);
+
+    EXPECT_EQ("token: abc! [a.cpp:1]\r\n", pop());
+}
+
+TEST_F(LogRingTests, long_string_cut)
+{
+    std::string text(100, 'x');
+    ring.push("%s", "a.cpp", 1, text.c_str());
+
+    EXPECT_EQ(std::string(LOG_STRING_MAX, 'x') + " [a.cpp:1]\r\n", pop());
+}
+
+TEST_F(LogRingTests, percent_and_suffix)
+{
+    ring.push("%d%% in %lums", "a.cpp", 7, 50, 20UL);
+
+    EXPECT_EQ("50% in 20ms [a.cpp:7]\r\n", pop());
+}
+
+TEST_F(LogRingTests, overflow_counted)
+{
+    int pushed = 0;
+    while (ring.push("%d", "a.cpp", 1, pushed)) {
+        pushed++;
+    }
+    ring.push("%d", "a.cpp", 1, 0);
+
+    EXPECT_EQ(2, ring.get_dropped());
+    EXPECT_EQ("[WARN] Log dropped 2 records\r\n", pop());
+    for (int i = 0; i < pushed; i++) {
+        EXPECT_EQ(std::to_string(i) + " [a.cpp:1]\r\n", pop());
+    }
+    EXPECT_TRUE(ring.is_empty());
+}
+
+TEST_F(LogRingTests, wraps_around)
+{
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(ring.push("n=%d s=%s", "a.cpp", 1, i, "abc"));
+        ASSERT_TRUE(ring.push("m=%ld", "a.cpp", 2, (long)i * 1000));
+        EXPECT_EQ("n=" + std::to_string(i) + " s=abc [a.cpp:1]\r\n", pop());
+        EXPECT_EQ("m=" + std::to_string(i * 1000) + " [a.cpp:2]\r\n", pop());
+    }
+}
+
+TEST_F(LogRingTests, printed_in_pieces)
+{
+    std::string text(20, 'y');
+    ring.push("%s-%d-%s", "a.cpp", 1, text.c_str(), 42, text.c_str());
+
+    // As a serial buffer with room for a few characters at a time
+    StringSink sink;
+    uint16_t printed;
+    while ((printed = ring.print(sink, 5, from)) == 5) {
+        ASSERT_NE(0, from);
+        ASSERT_FALSE(ring.is_empty());
+        ring.push("next", "b.cpp", 2);
+    }
+
+    // The records that didn't fit meanwhile are reported after the line, not in it
+    EXPECT_EQ(text + "-42-" + text + " [a.cpp:1]\r\n", sink.text);
+    EXPECT_EQ(0, from);
+    EXPECT_THAT(pop(), StartsWith("[WARN] Log dropped "));
+    EXPECT_EQ("next [b.cpp:2]\r\n", pop());
+}
+
+TEST_F(LogRingTests, long_line_not_cut)
+{
+    std::string text(20, 'z');
+    ring.push("A line longer than any buffer of the logger used to be, arguments: %s and %s, they are cut",
+              "a.cpp", 1, text.c_str(), text.c_str());
+
+    std::string line = pop();
+    EXPECT_EQ(86 + 2 * text.size() + 12, line.size());
+    EXPECT_THAT(line, EndsWith("they are cut [a.cpp:1]\r\n"));
+    EXPECT_TRUE(ring.is_empty());
+}
@@ -0,0 +1,17 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "Logging/LogSource.h"
+
+using namespace ::testing;
+
+static_assert(LogSource::basename_offset("/src/a.cpp") == 5, "");
+
+TEST(LogSourceTests, basename)
+{
+    EXPECT_STREQ("a.cpp", LOG_BASENAME("a.cpp"));
+    EXPECT_STREQ("a.cpp", LOG_BASENAME("/home/x/a.cpp"));
+    EXPECT_STREQ("a.cpp", LOG_BASENAME("C:\\sketches\\Kitchen\\a.cpp"));
+    EXPECT_STREQ("", LOG_BASENAME("dir/"));
+    EXPECT_STREQ("LogSourceTests.cpp", LOG_BASENAME(__FILE__));
+}
@@ -0,0 +1,120 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "Logging/LogTokens.h"
+
+using namespace ::testing;
+
+#define RING_SIZE   96
+
+// Tokens are computed at compile time
+static_assert(LOG_TOKEN("a.cpp", 300) != 0, "");
+
+// Stands in for Serial
+struct FrameSink
+{
+    size_t write(uint8_t c)
+    {
+        bytes.push_back(c);
+        return 1;
+    }
+
+    std::vector<uint8_t> bytes;
+};
+
+class LogTokensTests : public testing::Test
+{
+public:
+    LogTokensTests() :
+        from{0}
+    {
+    }
+
+    std::vector<uint8_t> pop()
+    {
+        FrameSink sink;
+        ring.print(sink, LogTokens<RING_SIZE>::FRAME_SIZE_MAX, from);
+        return sink.bytes;
+    }
+
+    LogTokens<RING_SIZE> ring;
+    uint16_t from;
+};
+
+TEST_F(LogTokensTests, tokens_match_host_tool)
+{
+    // Values of make_token() of tools/logtokens.py
+    EXPECT_EQ(0xe67e46b3U, LOG_TOKEN("/x/y/LightSwitchAC.ino", 42));
+    EXPECT_EQ(0x824a0680U, LOG_TOKEN("a.cpp", 300));
+    EXPECT_EQ(LOG_TOKEN("a.cpp", 300), LOG_TOKEN("C:\\sketches\\a.cpp", 300));
+    EXPECT_NE(LOG_TOKEN("a.cpp", 300), LOG_TOKEN("a.cpp", 301));
+}
+
+TEST_F(LogTokensTests, empty)
+{
+    EXPECT_TRUE(ring.is_empty());
+    EXPECT_TRUE(pop().empty());
+}
+
+TEST_F(LogTokensTests, frame)
+{
+    int16_t value = -2;
+    ring.push(0x12345678, value, "ab");
+
+    std::vector<uint8_t> frame = pop();
+    ASSERT_EQ(3 + 4 + sizeof(int) + 3, frame.size());
+    EXPECT_EQ(0x7E, frame[0]);
+    EXPECT_EQ(frame.size() - 3, frame[1]);
+    EXPECT_THAT(std::vector<uint8_t>(frame.begin() + 2, frame.begin() + 6), ElementsAre(0x78, 0x56, 0x34, 0x12));
+
+    int stored;
+    memcpy(&stored, &frame[6], sizeof(stored));
+    EXPECT_EQ(-2, stored);
+    EXPECT_THAT(std::vector<uint8_t>(frame.begin() + 6 + sizeof(int), frame.end() - 1), ElementsAre(2, 'a', 'b'));
+
+    uint8_t sum = 0;
+    for (size_t i = 1; i < frame.size(); i++) {
+        sum += frame[i];
+    }
+    EXPECT_EQ(0, sum);
+    EXPECT_TRUE(ring.is_empty());
+}
+
+TEST_F(LogTokensTests, no_arguments)
+{
+    ring.push(1);
+
+    EXPECT_THAT(pop(), ElementsAre(0x7E, 4, 1, 0, 0, 0, 0xFB));
+}
+
+TEST_F(LogTokensTests, frame_in_pieces)
+{
+    ring.push(1, 5);
+    std::vector<uint8_t> whole = pop();
+
+    ring.push(1, 5);
+    FrameSink sink;
+    while (ring.print(sink, 3, from) == 3) {
+        ASSERT_FALSE(ring.is_empty());
+    }
+    EXPECT_EQ(whole, sink.bytes);
+    EXPECT_TRUE(ring.is_empty());
+}
+
+TEST_F(LogTokensTests, overflow_counted)
+{
+    int pushed = 0;
+    while (ring.push(7, pushed)) {
+        pushed++;
+    }
+    ring.push(7, 0);
+
+    EXPECT_THAT(pop(), ElementsAre(0x7E, 6, 0, 0, 0, 0, 2, 0, 0xF8));
+    for (int i = 0; i < pushed; i++) {
+        std::vector<uint8_t> frame = pop();
+        ASSERT_EQ(3 + 4 + sizeof(int), frame.size());
+        EXPECT_EQ(7, frame[2]);
+        EXPECT_EQ(i, frame[6]);
+    }
+    EXPECT_TRUE(ring.is_empty());
+}
@@ -1,6 +1,12 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include <EEPROMSimulator.h>
+
 #include "../../mocks/Arduino.h"
 #include "../../mocks/MySensors.h"
 
@@ -11,20 +17,155 @@ using namespace testing;
 class MotionLightWithRelayTests : public testing::Test
 {
 public:
-    MotionLightWithRelayTests()
+    MotionLightWithRelayTests() :
+        now_ms{0},
+        real_ms{0},
+        motion{false},
+        button{false},
+        sent{0},
+        controller_time{0},
+        wakes{0}
     {
-        ON_CALL(ArduinoMock::mock(), digitalRead(3)).WillByDefault(Return(LOW));
+        ON_CALL(ArduinoMock::mock(), millis()).WillByDefault(Invoke([this]() {
+            return now_ms;
+        }));
+        ON_CALL(ArduinoMock::mock(), digitalRead(3)).WillByDefault(Invoke([this](uint8_t) {
+            return motion ? HIGH : LOW;
+        }));
         ON_CALL(ArduinoMock::mock(), analogRead(0)).WillByDefault(Return(1023));
         ON_CALL(debouncer, update()).WillByDefault(Return());
-        ON_CALL(debouncer, read()).WillByDefault(Return(false));
+        ON_CALL(debouncer, read()).WillByDefault(Invoke([this]() {
+            return button;
+        }));
+
+        ON_CALL(MySensorsMock::mock(), sleep(_, _, _)).WillByDefault(Invoke(
+            [this](uint8_t, uint8_t, unsigned long ms) {
+                return simulate_sleep(ms);
+            }));
+        ON_CALL(MySensorsMock::mock(), smartSleep(_, _, _)).WillByDefault(Invoke(
+            [this](uint8_t, uint8_t, unsigned long ms) {
+                // The heartbeat and the wait for the controller messages
+                wait(MY_SMART_SLEEP_WAIT_DURATION);
+                return simulate_sleep(ms);
+            }));
+        ON_CALL(MySensorsMock::mock(), send(_, _)).WillByDefault(Invoke([this](MyMessage &, bool) {
+            sent++;
+            return true;
+        }));
+        // The controller answers after REPLY_LATENCY_MS, if it knows the time
+        ON_CALL(MySensorsMock::mock(), requestTime()).WillByDefault(Invoke([this]() {
+            time_requests.push_back(real_ms);
+            if (controller_time != 0) {
+                reply([this]() {
+                    receiveTime(controller_time + real_ms / 1000);
+                    clock_errors.push_back((long) (clock_ms() - real_ms));
+                });
+            }
+        }));
+        // The rules are kept in the cells of the simulator
+        ON_CALL(EEPROM, read(_)).WillByDefault(Invoke([this](int idx) {
+            return eeprom.read(idx);
+        }));
+        ON_CALL(EEPROM, write(_, _)).WillByDefault(Invoke([this](int idx, uint8_t val) {
+            eeprom.write(idx, val);
+        }));
+        ON_CALL(EEPROM, update(_, _)).WillByDefault(Invoke([this](int idx, uint8_t val) {
+            eeprom.update(idx, val);
+        }));
+
+        rules.load();
 
         reset();
+        // As setup() does. The first light level is reported at once, the tests start after it
+        light_sensor.set_reporting(LIGHT_DEADBAND, LIGHT_MIN_INTERVAL_MS, TIMER_DELAY_MS);
+        light_sensor.process();
     }
     ~MotionLightWithRelayTests()
     {
         Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
         Mock::VerifyAndClearExpectations(&MySensorsMock::mock());
+        Mock::VerifyAndClearExpectations(&debouncer);
+    }
+
+    // Awake time passes for millis() and the real time
+    void advance(unsigned long ms)
+    {
+        now_ms += ms;
+        real_ms += ms;
+    }
+
+    // The controller sends a message a bit later, the node only gets it awake
+    void reply(std::function<void()> message)
+    {
+        replies.push_back(std::make_pair(real_ms + REPLY_LATENCY_MS, message));
+    }
+
+    void replies_deliver()
+    {
+        while (!replies.empty() && replies.front().first <= real_ms) {
+            std::function<void()> message = replies.front().second;
+            replies.pop_front();
+            message();
+        }
     }
+
+    // Awake, as wait() of MySensors
+    void wait(unsigned long ms)
+    {
+        for (unsigned long i = 0; i < ms; i++) {
+            replies_deliver();
+            advance(1);
+        }
+    }
+
+    // millis() stops while sleeping, a motion edge ends the sleep. The messages of the controller
+    // are lost.
+    int8_t simulate_sleep(unsigned long ms)
+    {
+        replies.clear();
+
+        unsigned long end = real_ms + ms;
+        if (!motion_edges.empty() && motion_edges.front() < end) {
+            real_ms = motion_edges.front();
+            motion_edges.pop_front();
+            motion = !motion;
+            wakes++;
+            return INTERRUPT;
+        }
+        real_ms = end;
+        return -1;
+    }
+
+    // Runs the loop, a millisecond each, until the real time
+    void run_until(unsigned long time)
+    {
+        while (real_ms < time) {
+            if (!motion_edges.empty() && motion_edges.front() <= real_ms) {
+                motion_edges.pop_front();
+                motion = !motion;
+            }
+            loop();
+            replies_deliver();
+            advance(1);
+        }
+    }
+
+    static const unsigned long REPLY_LATENCY_MS = 20;
+
+    unsigned long now_ms;
+    unsigned long real_ms;
+    bool motion;
+    bool button;
+    std::deque<unsigned long> motion_edges;
+    std::deque<std::pair<unsigned long, std::function<void()>>> replies;
+    EEPROMSimulator<> eeprom;
+    int sent;
+
+    unsigned long controller_time;
+    std::vector<unsigned long> time_requests;
+    // The clock of the node, less the real time, after each time of the controller
+    std::vector<long> clock_errors;
+    unsigned long wakes;
 };
 
 TEST_F(MotionLightWithRelayTests, loop_no_changes_pass)
@@ -59,27 +200,42 @@ TEST_F(MotionLightWithRelayTests, loop_on_movement_change_send_messages)
     loop();
 }
 
-TEST_F(MotionLightWithRelayTests, loop_on_light_change_send_messages)
+TEST_F(MotionLightWithRelayTests, light_change_send_messages)
 {
-    EXPECT_CALL(ArduinoMock::mock(), analogRead(0)).WillOnce(Return(1023));
+    EXPECT_CALL(ArduinoMock::mock(), analogRead(0)).WillRepeatedly(Return(1023));
     EXPECT_CALL(MySensorsMock::mock(), send(_, _)).Times(0);
-    loop();
+    light_level_process();
 
-    EXPECT_CALL(ArduinoMock::mock(), analogRead(0)).WillOnce(Return(1010));
-    EXPECT_CALL(MySensorsMock::mock(), send(msgLight.set(1), false)).WillOnce(Return(true));
-    loop();
+    // 2% is reported
+    now_ms = LIGHT_MIN_INTERVAL_MS;
+    EXPECT_CALL(ArduinoMock::mock(), analogRead(0)).WillRepeatedly(Return(1003));
+    EXPECT_CALL(MySensorsMock::mock(), send(msgLight.set(2), false)).WillOnce(Return(true));
+    light_level_process();
 
-    EXPECT_CALL(ArduinoMock::mock(), analogRead(0)).WillOnce(Return(1009));
+    // Less than the deadband isn't
+    now_ms += LIGHT_MIN_INTERVAL_MS / 2;
+    EXPECT_CALL(ArduinoMock::mock(), analogRead(0)).WillRepeatedly(Return(993));
     EXPECT_CALL(MySensorsMock::mock(), send(_, _)).Times(0);
-    loop();
+    light_level_process();
 
-    EXPECT_CALL(ArduinoMock::mock(), analogRead(0)).WillOnce(Return(1021));
-    EXPECT_CALL(MySensorsMock::mock(), send(msgLight.set(0), false)).WillOnce(Return(true));
-    loop();
+    // Nor is a change sooner than the minimal interval after the last report
+    now_ms = 2 * LIGHT_MIN_INTERVAL_MS - 1;
+    EXPECT_CALL(ArduinoMock::mock(), analogRead(0)).WillRepeatedly(Return(980));
+    EXPECT_CALL(MySensorsMock::mock(), send(_, _)).Times(0);
+    light_level_process();
 
-    EXPECT_CALL(ArduinoMock::mock(), analogRead(0)).WillOnce(Return(1010));
-    EXPECT_CALL(MySensorsMock::mock(), send(msgLight.set(1), false)).WillOnce(Return(true));
-    loop();
+    now_ms = 2 * LIGHT_MIN_INTERVAL_MS;
+    EXPECT_CALL(MySensorsMock::mock(), send(msgLight.set(4), false)).WillOnce(Return(true));
+    light_level_process();
+
+    // The same level is reported again after the maximal interval
+    now_ms += TIMER_DELAY_MS - 1;
+    EXPECT_CALL(MySensorsMock::mock(), send(_, _)).Times(0);
+    light_level_process();
+
+    now_ms += 1;
+    EXPECT_CALL(MySensorsMock::mock(), send(msgLight.set(4), false)).WillOnce(Return(true));
+    light_level_process();
 }
 
 TEST_F(MotionLightWithRelayTests, loop_on_button_press_send_messages)
@@ -152,3 +308,209 @@ TEST_F(MotionLightWithRelayTests, receive_message_switch_off_relay_pass)
 
     receive(message);
 }
+
+TEST_F(MotionLightWithRelayTests, status_sent_after_period_of_sleeps)
+{
+    setup();
+    EXPECT_CALL(MySensorsMock::mock(), sleep(INTERRUPT, CHANGE, SLEEP_SLICE_MS)).Times(AtLeast(1));
+    // The last slice before the status listens to the controller
+    EXPECT_CALL(MySensorsMock::mock(), smartSleep(INTERRUPT, CHANGE, _)).Times(1);
+    EXPECT_CALL(MySensorsMock::mock(), send(msgLight.set(0), false)).WillOnce(Return(true));
+    run_until(TIMER_DELAY_MS - 1);
+    Mock::VerifyAndClearExpectations(&MySensorsMock::mock());
+
+    EXPECT_CALL(MySensorsMock::mock(), send(msgMot.set(false), false)).WillOnce(Return(true));
+    EXPECT_CALL(MySensorsMock::mock(), send(msgLight.set(0), false)).WillOnce(Return(true));
+    run_until(TIMER_DELAY_MS + MY_SMART_SLEEP_WAIT_DURATION + AWAKE_MS);
+}
+
+TEST_F(MotionLightWithRelayTests, motion_wakes_up_and_is_sent)
+{
+    setup();
+    run_until(1000);
+
+    motion_edges = {30000, 35000};
+    EXPECT_CALL(MySensorsMock::mock(), send(msgMot.set(true), false)).WillOnce(Return(true));
+    run_until(30000 + AWAKE_MS);
+    Mock::VerifyAndClearExpectations(&MySensorsMock::mock());
+
+    EXPECT_CALL(MySensorsMock::mock(), send(msgMot.set(false), false)).WillOnce(Return(true));
+    run_until(35000 + AWAKE_MS);
+}
+
+TEST_F(MotionLightWithRelayTests, duty_cycle_of_hour)
+{
+    setup();
+
+    // Two people pass by
+    motion_edges = {10 * 60000UL, 10 * 60000UL + 30000, 40 * 60000UL, 41 * 60000UL};
+    run_until(60 * 60000UL);
+
+    double duty_cycle = (double) now_ms / real_ms;
+    RecordProperty("duty_cycle_permille", (int) (duty_cycle * 1000));
+    RecordProperty("messages", sent);
+
+    EXPECT_LT(duty_cycle, 0.01);
+    // The motion edges, and the status and the light of each period
+    EXPECT_GE(sent, 4 + 2 * 29);
+    EXPECT_LE(sent, 4 + 2 * 31);
+}
+
+TEST_F(MotionLightWithRelayTests, uploaded_rule_switches_relay_on_motion_in_dark)
+{
+    // Relay on on motion below 20% of light, off 5s after it stops
+    Rule rule{{{RULE_INPUT_MOTION, Rule::EQUAL, 1}, {RULE_INPUT_LIGHT, Rule::LESS, 20}},
+              Rule::ANY_TIME, 0, RULE_OUTPUT_RELAY, true, 5};
+    uint8_t data[1 + Rules::PAYLOAD_SIZE];
+    Rules::encode(0, rule, data);
+
+    MyMessage message{CHILD_ID_RULES, V_CUSTOM};
+    message.set(data, sizeof(data));
+    receive(message);
+    EXPECT_TRUE(rules.has_rule(0));
+
+    // Kept over a restart
+    setup();
+    EXPECT_TRUE(rules.has_rule(0));
+
+    motion_edges = {2000, 3000};
+    EXPECT_CALL(MySensorsMock::mock(), send(_, _)).WillRepeatedly(Return(true));
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(RELAY_PIN, RELAY_ON)).Times(1);
+    EXPECT_CALL(MySensorsMock::mock(), saveState(CHILD_ID_RELAY, true)).Times(1);
+    // The controller is told
+    EXPECT_CALL(MySensorsMock::mock(), send(msgRelay.set(true), false)).WillOnce(Return(true));
+    run_until(2000 + AWAKE_MS);
+    Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    Mock::VerifyAndClearExpectations(&MySensorsMock::mock());
+
+    // Off when the hold from the last motion seen ends, the node wakes up for it
+    unsigned long met_ms = clock_ms();
+    unsigned long off_ms = 0;
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(RELAY_PIN, RELAY_OFF)).WillOnce(Invoke([&off_ms](uint8_t, uint8_t) {
+        off_ms = clock_ms();
+    }));
+    EXPECT_CALL(MySensorsMock::mock(), saveState(CHILD_ID_RELAY, false)).Times(1);
+    run_until(3000 + 5000 + SLEEP_SLICE_MS);
+    EXPECT_GE(off_ms, met_ms + 5000);
+    EXPECT_LE(off_ms, met_ms + 5000 + AWAKE_MS);
+}
+
+TEST_F(MotionLightWithRelayTests, invalid_rule_is_refused)
+{
+    uint8_t data[] = {0, 1, 2};
+    MyMessage message{CHILD_ID_RULES, V_CUSTOM};
+    message.set(data, sizeof(data));
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(_, _)).Times(0);
+    receive(message);
+    EXPECT_FALSE(rules.has_rule(0));
+}
+
+TEST_F(MotionLightWithRelayTests, node_awake_for_ack_and_relay_command)
+{
+    setup();
+    run_until(2000);
+
+    // The controller acks the button and then switches the relay
+    EXPECT_CALL(MySensorsMock::mock(), send(msgRelay.set(true), true)).WillOnce(Invoke([this](MyMessage &, bool) {
+        reply([]() {
+            MyMessage ack{CHILD_ID_RELAY, V_LIGHT};
+            ack.setIsAck(true);
+            receive(ack);
+        });
+        reply([]() {
+            MyMessage command{CHILD_ID_RELAY, V_LIGHT};
+            receive(command.set(true));
+        });
+        return true;
+    }));
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(RELAY_PIN, RELAY_ON)).Times(1);
+    EXPECT_CALL(MySensorsMock::mock(), sleep(_, _, _)).Times(0);
+    button = true;
+    loop();
+    button = false;
+    loop();
+    unsigned long pressed = real_ms;
+    run_until(pressed + REPLY_LATENCY_MS + 1);
+    Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    Mock::VerifyAndClearExpectations(&MySensorsMock::mock());
+
+    // Sleeps again once they came
+    EXPECT_CALL(MySensorsMock::mock(), sleep(_, _, _)).Times(AtLeast(1));
+    run_until(pressed + REPLY_LATENCY_MS + 2);
+}
+
+TEST_F(MotionLightWithRelayTests, node_sleeps_after_reply_timeout)
+{
+    setup();
+    EXPECT_CALL(MySensorsMock::mock(), sleep(_, _, _)).Times(0);
+    run_until(REPLY_TIMEOUT_MS - 1);
+    Mock::VerifyAndClearExpectations(&MySensorsMock::mock());
+
+    EXPECT_CALL(MySensorsMock::mock(), sleep(_, _, _)).Times(AtLeast(1));
+    run_until(REPLY_TIMEOUT_MS + 1);
+}
+
+TEST_F(MotionLightWithRelayTests, clock_error_bounded_by_controller_time)
+{
+    controller_time = 1500000000;
+    setup();
+
+    // Someone passes by every 20s, the interrupted sleeps are guesses
+    for (unsigned long edge = 20000; edge < 20 * 60000UL; edge += 20000) {
+        motion_edges.push_back(edge);
+        motion_edges.push_back(edge + 5000);
+    }
+
+    unsigned long previous_request = 0;
+    unsigned long previous_wakes = 0;
+    for (unsigned long status = 1; status <= 8; status++) {
+        while (time_requests.size() < status + 1) {
+            run_until(real_ms + 1);
+        }
+
+        // The time is asked in the smart sleep before each status, the period is longer by the
+        // guesses since the last one
+        unsigned long period = time_requests.back() - previous_request;
+        unsigned long slack = (wakes - previous_wakes) * SLEEP_SLICE_MS / 2 + 1000;
+        EXPECT_GE(period + 1000, TIMER_DELAY_MS) << "status " << status;
+        EXPECT_LE(period, TIMER_DELAY_MS + slack) << "status " << status;
+        previous_request = time_requests.back();
+        previous_wakes = wakes;
+    }
+
+    // Each reply puts the clock within the second of the controller time
+    ASSERT_EQ(clock_errors.size(), time_requests.size());
+    for (long error : clock_errors) {
+        EXPECT_GT(error, -1000);
+        EXPECT_LE(error, 1000);
+    }
+}
+
+TEST_F(MotionLightWithRelayTests, time_window_opens_with_time_of_setup)
+{
+    // Relay on on motion from 22:00 to 06:00
+    Rule rule{{{RULE_INPUT_MOTION, Rule::EQUAL, 1}, {0, Rule::ALWAYS, 0}},
+              132, 36, RULE_OUTPUT_RELAY, true, 5};
+    uint8_t data[1 + Rules::PAYLOAD_SIZE];
+    Rules::encode(0, rule, data);
+    MyMessage message{CHILD_ID_RULES, V_CUSTOM};
+    message.set(data, sizeof(data));
+    receive(message);
+
+    // 23:00, the reply comes while the node waits for it
+    controller_time = 23 * 3600UL;
+    setup();
+
+    motion_edges = {5000};
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(RELAY_PIN, RELAY_ON)).Times(1);
+    run_until(5000 + AWAKE_MS);
+    EXPECT_EQ(1U, clock_errors.size());
+}
+
+TEST_F(MotionLightWithRelayTests, rules_above_saved_state)
+{
+    // saveState() takes the 256 cells after the MySensors config
+    EXPECT_GE(RULES_ADDRESS, EEPROM_LOCAL_CONFIG_ADDRESS + 256);
+    EXPECT_LE(RULES_ADDRESS + RULE_ENGINE_MAX_RULES * Rules::RULE_SIZE, 1024);
+}
@@ -0,0 +1,73 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "PhaseDimmer/LinearRamp.h"
+
+using namespace ::testing;
+
+class LinearRampTests : public testing::Test
+{
+public:
+    LinearRamp ramp;
+};
+
+TEST_F(LinearRampTests, idle_stays)
+{
+    ramp.jump(100);
+
+    EXPECT_FALSE(ramp.is_running());
+    EXPECT_EQ(100, ramp.update(12345));
+}
+
+TEST_F(LinearRampTests, follows_time)
+{
+    ramp.start(0, 1000, 100, 5000);
+
+    EXPECT_TRUE(ramp.is_running());
+    EXPECT_EQ(0, ramp.update(5000));
+    EXPECT_EQ(250, ramp.update(5025));
+    EXPECT_EQ(500, ramp.update(5050));
+    EXPECT_EQ(1000, ramp.update(5100));
+    EXPECT_FALSE(ramp.is_running());
+}
+
+TEST_F(LinearRampTests, goes_down)
+{
+    ramp.start(30720, 0, 2400, 0);
+
+    EXPECT_EQ(15360, ramp.update(1200));
+    EXPECT_EQ(0, ramp.update(2400));
+}
+
+TEST_F(LinearRampTests, catches_up_after_stall)
+{
+    ramp.start(0, 1000, 100, 0);
+
+    EXPECT_EQ(1000, ramp.update(100000));
+    EXPECT_FALSE(ramp.is_running());
+}
+
+TEST_F(LinearRampTests, zero_duration_jumps)
+{
+    ramp.start(10, 20, 0, 0);
+
+    EXPECT_FALSE(ramp.is_running());
+    EXPECT_EQ(20, ramp.get_value());
+}
+
+TEST_F(LinearRampTests, long_full_range_pass)
+{
+    const unsigned long duration = 3600000UL;
+    ramp.start(-32768, 32767, duration, 0);
+
+    EXPECT_NEAR(0, ramp.update(duration / 2), 2);
+    EXPECT_NEAR(16383, ramp.update(duration / 4 * 3), 2);
+}
+
+TEST_F(LinearRampTests, millis_overflow_pass)
+{
+    ramp.start(0, 1000, 100, (unsigned long)-50);
+
+    EXPECT_EQ(500, ramp.update(0));
+    EXPECT_EQ(1000, ramp.update(50));
+}
@@ -0,0 +1,119 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <math.h>
+
+#include "PhaseDimmer/PhaseCurve.h"
+#include "PhaseDimmer/PhaseDimmer.h"
+
+using namespace ::testing;
+
+#define STEPS           120
+#define HALF_PERIOD     10000
+
+// Generated by the compiler, not at startup
+static_assert(PhaseCurveMath::entry(PHASE_CURVE_POWER, STEPS / 2, STEPS) == 0x8000, "half power at the middle");
+
+static double power(double fraction)
+{
+    double angle = fraction * M_PI;
+    return 1 - angle / M_PI + sin(2 * angle) / (2 * M_PI);
+}
+
+class PhaseCurveTests : public testing::Test
+{
+public:
+    PhaseCurveTests() :
+        curves{PhaseCurve::make<PHASE_CURVE_LINEAR, STEPS>(),
+               PhaseCurve::make<PHASE_CURVE_POWER, STEPS>(),
+               PhaseCurve::make<PHASE_CURVE_CIE, STEPS>()}
+    {
+    }
+
+    PhaseCurve curves[3];
+};
+
+TEST_F(PhaseCurveTests, endpoints)
+{
+    for (const PhaseCurve & curve : curves) {
+        EXPECT_EQ(STEPS, curve.get_steps());
+        EXPECT_EQ(0, curve.get_entry(0));
+        EXPECT_EQ(0xFFFF, curve.get_entry(STEPS));
+        EXPECT_EQ(0U, curve.get_delay(0, HALF_PERIOD));
+        EXPECT_EQ(PhaseDimmer::OFF, curve.get_delay(STEPS << 8, HALF_PERIOD));
+        EXPECT_EQ(PhaseDimmer::OFF, curve.get_delay((STEPS + 10) << 8, HALF_PERIOD));
+    }
+}
+
+TEST_F(PhaseCurveTests, monotonic)
+{
+    for (const PhaseCurve & curve : curves) {
+        for (uint16_t level = 1; level <= STEPS; level++) {
+            EXPECT_GT(curve.get_entry(level), curve.get_entry(level - 1)) << "level " << level;
+        }
+
+        unsigned int last = 0;
+        for (uint16_t position = 0; position < STEPS << 8; position += 16) {
+            unsigned int delay = curve.get_delay(position, HALF_PERIOD);
+            EXPECT_GE(delay, last) << "position " << position;
+            EXPECT_LT(delay, (unsigned int)HALF_PERIOD);
+            last = delay;
+        }
+    }
+}
+
+TEST_F(PhaseCurveTests, dimmest_fires_before_next_zero_cross)
+{
+    // The largest shift ZeroCrossTracker applies, 3/4 of its window of 1/16 half-cycle
+    const unsigned int max_shift = HALF_PERIOD / 16 * 3 / 4;
+
+    for (const PhaseCurve & curve : curves) {
+        for (uint16_t position = (STEPS - 2) << 8; position < STEPS << 8; position++) {
+            unsigned int delay = curve.get_delay(position, HALF_PERIOD);
+            ASSERT_LE(delay, HALF_PERIOD - PhaseCurve::GUARD_US) << "position " << position;
+            ASSERT_LT(delay + max_shift, (unsigned int)HALF_PERIOD) << "position " << position;
+        }
+        EXPECT_EQ(HALF_PERIOD - PhaseCurve::GUARD_US, curve.get_delay((STEPS << 8) - 1, HALF_PERIOD));
+    }
+}
+
+TEST_F(PhaseCurveTests, linear_is_linear)
+{
+    const PhaseCurve & curve = curves[PHASE_CURVE_LINEAR];
+
+    EXPECT_EQ(HALF_PERIOD / 4, curve.get_delay((STEPS / 4) << 8, HALF_PERIOD));
+    EXPECT_EQ(HALF_PERIOD / 2, curve.get_delay((STEPS / 2) << 8, HALF_PERIOD));
+}
+
+TEST_F(PhaseCurveTests, power_follows_sine_integral)
+{
+    const PhaseCurve & curve = curves[PHASE_CURVE_POWER];
+
+    for (uint16_t level = 0; level < STEPS; level++) {
+        double brightness = (double)(STEPS - level) / STEPS;
+        EXPECT_NEAR(brightness, power(curve.get_entry(level) / 65536.0), 0.001) << "level " << level;
+    }
+}
+
+TEST_F(PhaseCurveTests, cie_follows_lightness)
+{
+    const PhaseCurve & curve = curves[PHASE_CURVE_CIE];
+
+    for (uint16_t level = 0; level < STEPS; level++) {
+        double lightness = 100.0 * (STEPS - level) / STEPS;
+        double luminance = power(curve.get_entry(level) / 65536.0);
+        double expected = lightness <= 8 ? lightness / 903.3 : pow((lightness + 16) / 116, 3);
+        EXPECT_NEAR(expected, luminance, 0.001) << "level " << level;
+    }
+}
+
+TEST_F(PhaseCurveTests, interpolated_between_steps)
+{
+    const PhaseCurve & curve = curves[PHASE_CURVE_CIE];
+
+    unsigned int from = curve.get_delay(60 << 8, HALF_PERIOD);
+    unsigned int to = curve.get_delay(61 << 8, HALF_PERIOD);
+    unsigned int middle = curve.get_delay((60 << 8) + 128, HALF_PERIOD);
+
+    EXPECT_NEAR((from + to) / 2, middle, 1);
+}
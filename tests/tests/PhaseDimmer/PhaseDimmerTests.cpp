@@ -0,0 +1,150 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <Arduino.h>
+
+#include "PhaseDimmer/PhaseDimmer.h"
+
+using namespace ::testing;
+
+static const uint8_t pins[] = {3, 4, 5, 6};
+static const FastPinHandle gates[] = {FastPin<3>::handle(), FastPin<4>::handle(),
+                                      FastPin<5>::handle(), FastPin<6>::handle()};
+
+class PhaseDimmerTests : public testing::Test
+{
+public:
+    PhaseDimmerTests() :
+        now{0},
+        dimmer(gates, 4, timers)
+    {
+        ON_CALL(ArduinoMock::mock(), micros()).WillByDefault(Invoke([this]() {
+            return now;
+        }));
+        dimmer.setup();
+    }
+
+    ~PhaseDimmerTests()
+    {
+        Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    }
+
+    // Runs the compare interrupt of the timer, `delay` after the previous event
+    void fire_timer(unsigned long delay)
+    {
+        now += delay;
+        timers.on_compare();
+    }
+
+    unsigned long now;
+    TimerService timers;
+    PhaseDimmer dimmer;
+};
+
+TEST_F(PhaseDimmerTests, all_off)
+{
+    for (uint8_t pin : pins) {
+        EXPECT_CALL(ArduinoMock::mock(), digitalWrite(pin, LOW));
+    }
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(_, HIGH)).Times(0);
+
+    dimmer.on_zero_cross();
+    EXPECT_EQ(TimerService::NEVER, timers.get_next_delay());
+}
+
+TEST_F(PhaseDimmerTests, schedule_is_sorted)
+{
+    dimmer.set_delay(0, 3000);
+    dimmer.set_delay(1, 1000);
+    dimmer.set_delay(2, PhaseDimmer::OFF);
+    dimmer.set_delay(3, 3010);
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(_, LOW)).Times(4);
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(_, HIGH)).Times(0);
+    dimmer.on_zero_cross();
+    EXPECT_EQ(1000U, timers.get_next_delay());
+    Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(4, HIGH));
+    fire_timer(1000);
+    EXPECT_EQ(2000U, timers.get_next_delay());
+    Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+
+    // Channels fired within MIN_STEP_US share an interrupt
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(3, HIGH));
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(6, HIGH));
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(5, HIGH)).Times(0);
+    fire_timer(2000);
+    EXPECT_EQ(TimerService::NEVER, timers.get_next_delay());
+}
+
+TEST_F(PhaseDimmerTests, early_interrupt_waits)
+{
+    dimmer.set_delay(0, 1000);
+    dimmer.on_zero_cross();
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(_, HIGH)).Times(0);
+    fire_timer(600);
+    EXPECT_EQ(400U, timers.get_next_delay());
+}
+
+TEST_F(PhaseDimmerTests, short_delay_fires_at_zero_cross)
+{
+    dimmer.set_delay(2, 0);
+    dimmer.set_delay(1, 500);
+
+    InSequence s;
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(_, LOW)).Times(4);
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(5, HIGH));
+    dimmer.on_zero_cross();
+    EXPECT_EQ(500U, timers.get_next_delay());
+}
+
+TEST_F(PhaseDimmerTests, delay_applies_next_half_cycle)
+{
+    dimmer.set_delay(0, 1000);
+
+    dimmer.on_zero_cross();
+    EXPECT_EQ(1000U, timers.get_next_delay());
+
+    dimmer.set_delay(0, 2000);
+    EXPECT_EQ(2000U, dimmer.get_delay(0));
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(3, HIGH));
+    fire_timer(1000);
+}
+
+TEST_F(PhaseDimmerTests, zero_cross_cancels_timer)
+{
+    dimmer.set_delay(0, 9000);
+    dimmer.on_zero_cross();
+
+    dimmer.set_delay(0, PhaseDimmer::OFF);
+    dimmer.on_zero_cross();
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(_, HIGH)).Times(0);
+    fire_timer(9000);
+}
+
+TEST_F(PhaseDimmerTests, wrong_channel_ignored)
+{
+    dimmer.set_delay(4, 1000);
+
+    EXPECT_EQ(PhaseDimmer::OFF, dimmer.get_delay(4));
+    dimmer.on_zero_cross();
+    EXPECT_EQ(TimerService::NEVER, timers.get_next_delay());
+}
+
+TEST_F(PhaseDimmerTests, shifted_schedule)
+{
+    dimmer.set_delay(0, 1000);
+    dimmer.set_delay(1, 100);
+
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(_, LOW)).Times(AnyNumber());
+    EXPECT_CALL(ArduinoMock::mock(), digitalWrite(4, HIGH));
+    dimmer.on_zero_cross(-150);
+    EXPECT_EQ(850U, timers.get_next_delay());
+
+    dimmer.on_zero_cross(150);
+    EXPECT_EQ(250U, timers.get_next_delay());
+}
@@ -0,0 +1,189 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "PhaseDimmer/ZeroCrossTracker.h"
+
+using namespace ::testing;
+
+// Simulated zero cross detector: a mains with jitter on every edge, contact bounce right after
+// some of the edges and spikes at random times in some of the half-cycles
+class MainsSimulator
+{
+public:
+    MainsSimulator(unsigned int half_period, unsigned int jitter) :
+        half_period{half_period},
+        jitter{jitter},
+        bounce_percent{0},
+        spike_percent{0},
+        crossing{100000},
+        m_seed{12345}
+    {
+    }
+
+    unsigned long random(unsigned long max)
+    {
+        m_seed = m_seed * 1103515245UL + 12345UL;
+        return (m_seed >> 8) % max;
+    }
+
+    unsigned long edge()
+    {
+        return crossing + random(2 * jitter + 1) - jitter;
+    }
+
+    void next()
+    {
+        crossing += half_period;
+    }
+
+    unsigned int half_period;
+    unsigned int jitter;
+    unsigned int bounce_percent;
+    unsigned int spike_percent;
+    unsigned long crossing;
+
+private:
+    uint32_t m_seed;
+};
+
+struct Stats
+{
+    unsigned long edges;
+    unsigned long edges_taken;
+    unsigned long glitches;
+    unsigned long glitches_taken;
+};
+
+class ZeroCrossTrackerTests : public testing::Test
+{
+public:
+    // Feeds the tracker `count` half-cycles
+    Stats run(MainsSimulator & mains, unsigned int count)
+    {
+        Stats stats = {};
+        for (unsigned int i = 0; i < count; i++) {
+            unsigned long edge = mains.edge();
+            stats.edges++;
+            stats.edges_taken += tracker.on_edge(edge);
+
+            if (mains.random(100) < mains.bounce_percent) {
+                stats.glitches++;
+                stats.glitches_taken += tracker.on_edge(edge + 20 + mains.random(800));
+            }
+            if (mains.random(100) < mains.spike_percent) {
+                stats.glitches++;
+                stats.glitches_taken += tracker.on_edge(edge + 1000 + mains.random(mains.half_period - 2000));
+            }
+            mains.next();
+        }
+        return stats;
+    }
+
+    ZeroCrossTracker tracker;
+};
+
+TEST_F(ZeroCrossTrackerTests, lock_50hz)
+{
+    MainsSimulator mains(ZeroCrossTracker::HALF_PERIOD_50HZ, 0);
+
+    run(mains, ZeroCrossTracker::LOCK_EDGES);
+    EXPECT_FALSE(tracker.is_locked());
+    EXPECT_EQ(0, tracker.get_frequency());
+    EXPECT_EQ(ZeroCrossTracker::HALF_PERIOD_50HZ, tracker.get_nominal_period());
+
+    run(mains, 1);
+    EXPECT_TRUE(tracker.is_locked());
+    EXPECT_EQ(50, tracker.get_frequency());
+}
+
+TEST_F(ZeroCrossTrackerTests, lock_60hz_with_jitter)
+{
+    MainsSimulator mains(ZeroCrossTracker::HALF_PERIOD_60HZ, 150);
+
+    run(mains, 20);
+
+    EXPECT_TRUE(tracker.is_locked());
+    EXPECT_EQ(60, tracker.get_frequency());
+    EXPECT_EQ(ZeroCrossTracker::HALF_PERIOD_60HZ, tracker.get_nominal_period());
+}
+
+TEST_F(ZeroCrossTrackerTests, glitches_rejected)
+{
+    MainsSimulator mains(ZeroCrossTracker::HALF_PERIOD_50HZ, 150);
+    mains.bounce_percent = 30;
+    mains.spike_percent = 10;
+
+    run(mains, 50);
+    ASSERT_TRUE(tracker.is_locked());
+
+    unsigned long rejected = tracker.get_rejected();
+    Stats stats = run(mains, 5000);
+
+    EXPECT_TRUE(tracker.is_locked());
+    EXPECT_GE(stats.edges_taken * 100, stats.edges * 99);
+    EXPECT_LE(stats.glitches_taken * 100, stats.glitches * 5);
+    EXPECT_EQ(stats.edges + stats.glitches - stats.edges_taken - stats.glitches_taken,
+              tracker.get_rejected() - rejected);
+}
+
+TEST_F(ZeroCrossTrackerTests, period_follows_mains)
+{
+    MainsSimulator mains(ZeroCrossTracker::HALF_PERIOD_50HZ + 80, 150);
+
+    run(mains, 500);
+
+    ASSERT_TRUE(tracker.is_locked());
+    EXPECT_NEAR(ZeroCrossTracker::HALF_PERIOD_50HZ + 80, tracker.get_period(), 20);
+}
+
+TEST_F(ZeroCrossTrackerTests, predicts_next_crossing)
+{
+    MainsSimulator mains(ZeroCrossTracker::HALF_PERIOD_50HZ, 150);
+    run(mains, 200);
+
+    unsigned long worst = 0;
+    for (int i = 0; i < 200; i++) {
+        run(mains, 1);
+        long error = (long)(tracker.predict_next() - mains.crossing);
+        worst = std::max(worst, (unsigned long)labs(error));
+    }
+    // The edges alone are off by up to the jitter
+    EXPECT_LT(worst, 150U);
+}
+
+TEST_F(ZeroCrossTrackerTests, missed_edges_coasted)
+{
+    MainsSimulator mains(ZeroCrossTracker::HALF_PERIOD_50HZ, 50);
+    run(mains, 20);
+
+    mains.next();
+    mains.next();
+
+    EXPECT_TRUE(tracker.on_edge(mains.edge()));
+    EXPECT_TRUE(tracker.is_locked());
+}
+
+TEST_F(ZeroCrossTrackerTests, relock_on_signal_change)
+{
+    MainsSimulator mains(ZeroCrossTracker::HALF_PERIOD_50HZ, 50);
+    run(mains, 20);
+    ASSERT_EQ(50, tracker.get_frequency());
+
+    mains.half_period = ZeroCrossTracker::HALF_PERIOD_60HZ;
+    run(mains, 40);
+
+    EXPECT_TRUE(tracker.is_locked());
+    EXPECT_EQ(60, tracker.get_frequency());
+}
+
+TEST_F(ZeroCrossTrackerTests, noise_does_not_lock)
+{
+    MainsSimulator mains(ZeroCrossTracker::HALF_PERIOD_50HZ, 0);
+
+    for (int i = 0; i < 500; i++) {
+        tracker.on_edge(mains.crossing);
+        mains.crossing += 5000 + mains.random(20000);
+    }
+
+    EXPECT_FALSE(tracker.is_locked());
+}
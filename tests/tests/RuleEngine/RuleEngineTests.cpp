@@ -0,0 +1,249 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include <EEPROMSimulator.h>
+
+#include "RuleEngine/RuleEngine.h"
+
+using namespace ::testing;
+
+#define ADDRESS     100
+
+#define MOTION      0
+#define LIGHT       1
+
+#define RELAY       0
+
+typedef RuleEngine<EEPROMSimulator<>> Rules;
+
+class RuleEngineTests : public testing::Test
+{
+public:
+    RuleEngineTests() :
+        rules(eeprom, ADDRESS, on_action)
+    {
+        actions.clear();
+    }
+
+    static void on_action(uint8_t output, bool value)
+    {
+        actions.push_back(std::make_pair(output, value));
+    }
+
+    // Light on on motion in the dark, off after a minute without motion
+    static Rule night_light()
+    {
+        return Rule{
+            {{MOTION, Rule::EQUAL, 1}, {LIGHT, Rule::LESS, 20}},
+            Rule::ANY_TIME, 0,
+            RELAY, true, 60
+        };
+    }
+
+    bool upload(uint8_t index, const Rule & rule)
+    {
+        uint8_t data[1 + Rules::PAYLOAD_SIZE];
+        Rules::encode(index, rule, data);
+        return rules.upload(data, sizeof(data));
+    }
+
+    EEPROMSimulator<> eeprom;
+    Rules rules;
+    static std::vector<std::pair<uint8_t, bool>> actions;
+};
+
+std::vector<std::pair<uint8_t, bool>> RuleEngineTests::actions;
+
+TEST_F(RuleEngineTests, erased_or_zeroed_eeprom_has_no_rules)
+{
+    EXPECT_EQ(0, rules.load());
+
+    eeprom.erase(0);
+    EXPECT_EQ(0, rules.load());
+
+    rules.process(0);
+    EXPECT_TRUE(actions.empty());
+}
+
+TEST_F(RuleEngineTests, conditions_must_all_hold)
+{
+    ASSERT_TRUE(upload(0, night_light()));
+
+    rules.set_input(MOTION, 1);
+    rules.set_input(LIGHT, 50);
+    rules.process(0);
+    EXPECT_TRUE(actions.empty());
+
+    rules.set_input(LIGHT, 10);
+    rules.process(100);
+    EXPECT_THAT(actions, ElementsAre(std::make_pair(RELAY, true)));
+
+    // Only on the edge
+    rules.process(200);
+    EXPECT_EQ(1U, actions.size());
+}
+
+TEST_F(RuleEngineTests, output_set_back_after_hold)
+{
+    ASSERT_TRUE(upload(0, night_light()));
+    rules.set_input(LIGHT, 10);
+
+    rules.set_input(MOTION, 1);
+    rules.process(1000);
+    rules.set_input(MOTION, 0);
+    rules.process(2000);
+
+    // Motion again within the hold restarts it
+    rules.process(30000);
+    rules.set_input(MOTION, 1);
+    rules.process(40000);
+    rules.set_input(MOTION, 0);
+    rules.process(40000 + 59999);
+    EXPECT_THAT(actions, ElementsAre(std::make_pair(RELAY, true)));
+
+    rules.process(40000 + 60000);
+    EXPECT_THAT(actions, ElementsAre(std::make_pair(RELAY, true), std::make_pair(RELAY, false)));
+}
+
+TEST_F(RuleEngineTests, hold_left_counts_down)
+{
+    ASSERT_TRUE(upload(0, night_light()));
+    rules.set_input(LIGHT, 10);
+    EXPECT_EQ(0UL, rules.get_hold_left(0));
+
+    // Not while the conditions hold
+    rules.set_input(MOTION, 1);
+    rules.process(1000);
+    EXPECT_EQ(0UL, rules.get_hold_left(1000));
+
+    rules.set_input(MOTION, 0);
+    EXPECT_EQ(60000UL, rules.get_hold_left(1000));
+    EXPECT_EQ(20000UL, rules.get_hold_left(41000));
+    // Overdue until process() runs
+    EXPECT_EQ(1UL, rules.get_hold_left(70000));
+
+    rules.process(61000);
+    EXPECT_EQ(0UL, rules.get_hold_left(61000));
+}
+
+TEST_F(RuleEngineTests, zero_hold_leaves_output)
+{
+    Rule rule{{{LIGHT, Rule::GREATER, 80}, {0, Rule::ALWAYS, 0}}, Rule::ANY_TIME, 0, RELAY, false, 0};
+    ASSERT_TRUE(upload(3, rule));
+
+    rules.set_input(LIGHT, 90);
+    rules.process(0);
+    rules.set_input(LIGHT, 50);
+    rules.process(1000000);
+    EXPECT_THAT(actions, ElementsAre(std::make_pair(RELAY, false)));
+
+    // And fires again on the next edge
+    rules.set_input(LIGHT, 90);
+    rules.process(1000001);
+    EXPECT_EQ(2U, actions.size());
+}
+
+TEST_F(RuleEngineTests, window_needs_time)
+{
+    // 22:00 to 06:00
+    Rule rule{{{MOTION, Rule::EQUAL, 1}, {0, Rule::ALWAYS, 0}}, 132, 36, RELAY, true, 10};
+    ASSERT_TRUE(upload(0, rule));
+    rules.set_input(MOTION, 1);
+
+    rules.process(0);
+    EXPECT_TRUE(actions.empty());
+
+    // 21:59:59, the window opens a second later
+    rules.set_time(21 * 3600UL + 59 * 60 + 59, 0);
+    rules.process(999);
+    EXPECT_TRUE(actions.empty());
+    rules.process(1000);
+    EXPECT_THAT(actions, ElementsAre(std::make_pair(RELAY, true)));
+
+    // Over midnight to 06:00, when it closes, then the hold
+    rules.process(1000 + 8 * 3600000UL - 1);
+    EXPECT_EQ(1U, actions.size());
+    rules.process(1000 + 8 * 3600000UL);
+    EXPECT_EQ(1U, actions.size());
+    rules.process(1000 + 8 * 3600000UL + 9999);
+    EXPECT_THAT(actions, ElementsAre(std::make_pair(RELAY, true), std::make_pair(RELAY, false)));
+}
+
+TEST_F(RuleEngineTests, rules_survive_reload)
+{
+    ASSERT_TRUE(upload(2, night_light()));
+    EXPECT_TRUE(rules.has_rule(2));
+
+    Rules reloaded(eeprom, ADDRESS, on_action);
+    EXPECT_EQ(1, reloaded.load());
+    EXPECT_TRUE(reloaded.has_rule(2));
+
+    reloaded.set_input(MOTION, 1);
+    reloaded.set_input(LIGHT, -5);
+    reloaded.process(0);
+    EXPECT_THAT(actions, ElementsAre(std::make_pair(RELAY, true)));
+}
+
+TEST_F(RuleEngineTests, index_alone_deletes_rule)
+{
+    ASSERT_TRUE(upload(1, night_light()));
+
+    uint8_t index = 1;
+    EXPECT_TRUE(rules.upload(&index, 1));
+    EXPECT_FALSE(rules.has_rule(1));
+    EXPECT_EQ(0, rules.load());
+}
+
+TEST_F(RuleEngineTests, corrupted_rule_is_skipped)
+{
+    ASSERT_TRUE(upload(0, night_light()));
+    ASSERT_TRUE(upload(1, night_light()));
+
+    eeprom.write(ADDRESS + 3, eeprom.read(ADDRESS + 3) ^ 0x01);
+    EXPECT_EQ(1, rules.load());
+    EXPECT_FALSE(rules.has_rule(0));
+    EXPECT_TRUE(rules.has_rule(1));
+}
+
+TEST_F(RuleEngineTests, invalid_uploads_are_refused)
+{
+    uint8_t data[1 + Rules::PAYLOAD_SIZE];
+
+    Rules::encode(RULE_ENGINE_MAX_RULES, night_light(), data);
+    EXPECT_FALSE(rules.upload(data, sizeof(data)));
+
+    Rules::encode(0, night_light(), data);
+    EXPECT_FALSE(rules.upload(data, sizeof(data) - 1));
+    EXPECT_FALSE(rules.upload(data, 0));
+
+    Rule rule = night_light();
+    rule.conditions[0].op = Rule::OP_COUNT;
+    Rules::encode(0, rule, data);
+    EXPECT_FALSE(rules.upload(data, sizeof(data)));
+
+    rule = night_light();
+    rule.window_start = 144;
+    Rules::encode(0, rule, data);
+    EXPECT_FALSE(rules.upload(data, sizeof(data)));
+
+    EXPECT_EQ(0, rules.load());
+}
+
+TEST_F(RuleEngineTests, reupload_writes_no_cells)
+{
+    ASSERT_TRUE(upload(0, night_light()));
+    unsigned long writes = 0;
+    for (int i = 0; i < Rules::RULE_SIZE; i++) {
+        writes += eeprom.writes(ADDRESS + i);
+    }
+
+    ASSERT_TRUE(upload(0, night_light()));
+    unsigned long rewrites = 0;
+    for (int i = 0; i < Rules::RULE_SIZE; i++) {
+        rewrites += eeprom.writes(ADDRESS + i);
+    }
+    EXPECT_EQ(writes, rewrites);
+}
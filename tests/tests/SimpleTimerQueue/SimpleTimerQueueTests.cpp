@@ -0,0 +1,147 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <Arduino.h>
+
+#include "SimpleTimer/SimpleTimerQueue.h"
+
+using namespace ::testing;
+
+static std::vector<int> calls;
+
+template <int ID>
+void on_timer()
+{
+    calls.push_back(ID);
+}
+
+class SimpleTimerQueueTests : public testing::Test
+{
+public:
+    SimpleTimerQueueTests() :
+        now{1000}
+    {
+        calls.clear();
+        ON_CALL(ArduinoMock::mock(), millis()).WillByDefault(Invoke([this]() {
+            return now;
+        }));
+    }
+
+    ~SimpleTimerQueueTests()
+    {
+        Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    }
+
+    void run_until(unsigned long time)
+    {
+        while (now != time) {
+            now++;
+            timers.run();
+        }
+    }
+
+    unsigned long now;
+    SimpleTimerQueue<4> timers;
+};
+
+TEST_F(SimpleTimerQueueTests, ordered_by_deadline)
+{
+    timers.setInterval(250, on_timer<1>);
+    timers.setTimeout(100, on_timer<2>);
+    timers.setInterval(200, on_timer<3>);
+
+    run_until(1600);
+
+    EXPECT_THAT(calls, ElementsAre(2, 3, 1, 3, 1, 3));
+}
+
+TEST_F(SimpleTimerQueueTests, time_until_next)
+{
+    EXPECT_EQ(SimpleTimerQueue<4>::NEVER, timers.timeUntilNext());
+
+    timers.setInterval(500, on_timer<1>);
+    timers.setTimeout(120, on_timer<2>);
+    EXPECT_EQ(120U, timers.timeUntilNext());
+
+    run_until(1120);
+    EXPECT_EQ(380U, timers.timeUntilNext());
+
+    // Late run
+    now = 1600;
+    EXPECT_EQ(0U, timers.timeUntilNext());
+    timers.run();
+    EXPECT_EQ(500U, timers.timeUntilNext());
+}
+
+TEST_F(SimpleTimerQueueTests, nothing_due_reads_millis_once)
+{
+    timers.setInterval(500, on_timer<1>);
+
+    EXPECT_CALL(ArduinoMock::mock(), millis()).WillOnce(Return(1200));
+    timers.run();
+    EXPECT_TRUE(calls.empty());
+}
+
+TEST_F(SimpleTimerQueueTests, repeats_then_deleted)
+{
+    int id = timers.setTimer(100, on_timer<1>, 3);
+
+    run_until(2000);
+
+    EXPECT_THAT(calls, ElementsAre(1, 1, 1));
+    EXPECT_EQ(0, timers.getNumTimers());
+    EXPECT_FALSE(timers.isEnabled(id));
+}
+
+TEST_F(SimpleTimerQueueTests, full)
+{
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(i, timers.setInterval(100 + i, on_timer<1>));
+    }
+    EXPECT_EQ(-1, timers.setTimeout(10, on_timer<2>));
+    EXPECT_EQ(0, timers.getNumAvailableTimers());
+
+    timers.deleteTimer(2);
+    EXPECT_EQ(2, timers.setTimeout(10, on_timer<2>));
+
+    run_until(1050);
+    EXPECT_THAT(calls, ElementsAre(2));
+}
+
+TEST_F(SimpleTimerQueueTests, delete_and_restart)
+{
+    int first = timers.setInterval(100, on_timer<1>);
+    int second = timers.setInterval(100, on_timer<2>);
+    timers.setInterval(150, on_timer<3>);
+
+    run_until(1050);
+    timers.restartTimer(second);
+    timers.deleteTimer(first);
+
+    run_until(1200);
+    EXPECT_THAT(calls, ElementsAre(2, 3));
+}
+
+TEST_F(SimpleTimerQueueTests, disabled_keeps_phase)
+{
+    int id = timers.setInterval(100, on_timer<1>);
+    timers.disable(id);
+
+    run_until(1250);
+    EXPECT_TRUE(calls.empty());
+
+    timers.toggle(id);
+    run_until(1300);
+    EXPECT_THAT(calls, ElementsAre(1));
+}
+
+TEST_F(SimpleTimerQueueTests, millis_overflow)
+{
+    now = (unsigned long)-50;
+    timers.setInterval(100, on_timer<1>);
+    timers.setInterval(30, on_timer<2>);
+
+    run_until(60);
+
+    EXPECT_THAT(calls, ElementsAre(2, 2, 2, 1));
+}
@@ -0,0 +1,100 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <Arduino.h>
+
+#include "SoftTimer/src/SoftTimer.h"
+
+using namespace ::testing;
+
+static std::vector<Task *> calls;
+
+static void on_task(Task * task)
+{
+    calls.push_back(task);
+}
+
+static void on_slow_down(Task * task)
+{
+    calls.push_back(task);
+    task->setPeriodMs(50);
+}
+
+class SoftTimerTests : public testing::Test
+{
+public:
+    SoftTimerTests() :
+        now{1000000},
+        fast(10, on_task),
+        slow(25, on_slow_down)
+    {
+        calls.clear();
+        ON_CALL(ArduinoMock::mock(), micros()).WillByDefault(Invoke([this]() {
+            return now;
+        }));
+    }
+
+    ~SoftTimerTests()
+    {
+        SoftTimer.remove(&fast);
+        SoftTimer.remove(&slow);
+        Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    }
+
+    unsigned long now;
+    Task fast;
+    Task slow;
+};
+
+TEST_F(SoftTimerTests, nothing_registered)
+{
+    EXPECT_EQ(SOFTTIMER_WAIT_FOREVER, SoftTimer.runDue());
+}
+
+TEST_F(SoftTimerTests, waits_for_nearest_task)
+{
+    SoftTimer.add(&fast);
+    SoftTimer.add(&slow);
+
+    // Both start right after registering
+    EXPECT_EQ(10000U, SoftTimer.runDue());
+    EXPECT_THAT(calls, ElementsAre(&fast, &slow));
+
+    now += 4000;
+    calls.clear();
+    EXPECT_EQ(6000U, SoftTimer.runDue());
+    EXPECT_TRUE(calls.empty());
+
+    now += 6000;
+    EXPECT_EQ(10000U, SoftTimer.runDue());
+    EXPECT_THAT(calls, ElementsAre(&fast));
+}
+
+TEST_F(SoftTimerTests, period_changed_by_callback)
+{
+    SoftTimer.add(&slow);
+
+    EXPECT_EQ(50000U, SoftTimer.runDue());
+}
+
+TEST_F(SoftTimerTests, removed_task_not_waited_for)
+{
+    SoftTimer.add(&fast);
+    SoftTimer.add(&slow);
+    SoftTimer.runDue();
+    SoftTimer.remove(&fast);
+
+    now += 1000;
+    EXPECT_EQ(49000U, SoftTimer.runDue());
+}
+
+TEST_F(SoftTimerTests, micros_overflow)
+{
+    now = (unsigned long)-3000;
+    SoftTimer.add(&fast);
+    SoftTimer.runDue();
+
+    now = 2000;
+    EXPECT_EQ(5000U, SoftTimer.runDue());
+    EXPECT_THAT(calls, ElementsAre(&fast));
+}
@@ -0,0 +1,169 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <Arduino.h>
+
+#include "TimerService/TimerService.h"
+
+using namespace ::testing;
+
+class TimerServiceTests : public testing::Test
+{
+public:
+    TimerServiceTests() :
+        now{5000},
+        calls{}
+    {
+        ON_CALL(ArduinoMock::mock(), micros()).WillByDefault(Invoke([this]() {
+            return now;
+        }));
+        timers.setup();
+    }
+
+    ~TimerServiceTests()
+    {
+        Mock::VerifyAndClearExpectations(&ArduinoMock::mock());
+    }
+
+    static void on_timer(void * data)
+    {
+        static_cast<std::vector<unsigned long> *>(data)->push_back(*current);
+    }
+
+    // Runs the compare interrupt at `time`, as the hardware would
+    void advance_to(unsigned long time)
+    {
+        now = time;
+        timers.on_compare();
+    }
+
+    static unsigned long * current;
+    unsigned long now;
+    std::vector<unsigned long> calls;
+    TimerService timers;
+};
+
+unsigned long * TimerServiceTests::current = nullptr;
+
+TEST_F(TimerServiceTests, nothing_armed)
+{
+    EXPECT_EQ(TimerService::NEVER, timers.get_next_delay());
+
+    TimerService::id_t id = timers.add(on_timer, &calls, TimerService::IN_ISR);
+    EXPECT_FALSE(timers.is_armed(id));
+    EXPECT_EQ(TimerService::NEVER, timers.get_next_delay());
+}
+
+TEST_F(TimerServiceTests, one_shot_in_isr)
+{
+    current = &now;
+    TimerService::id_t id = timers.add(on_timer, &calls, TimerService::IN_ISR);
+    timers.arm(id, 300);
+    EXPECT_EQ(300U, timers.get_next_delay());
+
+    advance_to(5299);
+    EXPECT_TRUE(calls.empty());
+
+    advance_to(5300);
+    EXPECT_THAT(calls, ElementsAre(5300));
+    EXPECT_FALSE(timers.is_armed(id));
+    EXPECT_EQ(TimerService::NEVER, timers.get_next_delay());
+}
+
+TEST_F(TimerServiceTests, earliest_of_many)
+{
+    current = &now;
+    std::vector<unsigned long> other;
+    TimerService::id_t slow = timers.add(on_timer, &calls, TimerService::IN_ISR);
+    TimerService::id_t fast = timers.add(on_timer, &other, TimerService::IN_ISR);
+    timers.arm(slow, 1000);
+    timers.arm(fast, 250, 250);
+    EXPECT_EQ(250U, timers.get_next_delay());
+
+    advance_to(5250);
+    advance_to(5500);
+    advance_to(5750);
+    EXPECT_EQ(250U, timers.get_next_delay());
+    advance_to(6000);
+
+    EXPECT_THAT(calls, ElementsAre(6000));
+    EXPECT_THAT(other, ElementsAre(5250, 5500, 5750, 6000));
+    EXPECT_EQ(250U, timers.get_next_delay());
+}
+
+TEST_F(TimerServiceTests, period_keeps_phase)
+{
+    current = &now;
+    TimerService::id_t id = timers.add(on_timer, &calls, TimerService::IN_ISR);
+    timers.arm(id, 100, 100);
+
+    // A late interrupt doesn't shift the next one
+    advance_to(5130);
+    EXPECT_EQ(70U, timers.get_next_delay());
+
+    // Too late for a whole period
+    advance_to(5450);
+    EXPECT_EQ(100U, timers.get_next_delay());
+    EXPECT_THAT(calls, ElementsAre(5130, 5450));
+}
+
+TEST_F(TimerServiceTests, in_loop_deferred)
+{
+    current = &now;
+    TimerService::id_t id = timers.add(on_timer, &calls, TimerService::IN_LOOP);
+    timers.arm(id, 100, 100);
+
+    advance_to(5100);
+    advance_to(5200);
+    EXPECT_TRUE(calls.empty());
+
+    // Missed periods are merged
+    now = 5210;
+    timers.process();
+    EXPECT_THAT(calls, ElementsAre(5210));
+
+    timers.process();
+    EXPECT_EQ(1U, calls.size());
+}
+
+TEST_F(TimerServiceTests, disarm_and_remove)
+{
+    TimerService::id_t first = timers.add(on_timer, &calls, TimerService::IN_ISR);
+    TimerService::id_t second = timers.add(on_timer, &calls, TimerService::IN_LOOP);
+    timers.arm(first, 100);
+    timers.arm(second, 200);
+
+    timers.disarm(first);
+    EXPECT_EQ(200U, timers.get_next_delay());
+
+    advance_to(5200);
+    timers.remove(second);
+    timers.process();
+    EXPECT_TRUE(calls.empty());
+    EXPECT_EQ(second, timers.add(on_timer, &calls, TimerService::IN_ISR));
+}
+
+TEST_F(TimerServiceTests, all_taken)
+{
+    for (int i = 0; i < TIMER_SERVICE_MAX_TIMERS; i++) {
+        EXPECT_EQ(i, timers.add(on_timer, &calls, TimerService::IN_ISR));
+    }
+    EXPECT_EQ(TimerService::NONE, timers.add(on_timer, &calls, TimerService::IN_ISR));
+
+    timers.arm(TimerService::NONE, 100);
+    EXPECT_EQ(TimerService::NEVER, timers.get_next_delay());
+}
+
+TEST_F(TimerServiceTests, micros_overflow)
+{
+    current = &now;
+    now = (unsigned long)-50;
+    TimerService::id_t id = timers.add(on_timer, &calls, TimerService::IN_ISR);
+    timers.arm(id, 100);
+    EXPECT_EQ(100U, timers.get_next_delay());
+
+    advance_to(49);
+    EXPECT_TRUE(calls.empty());
+    advance_to(50);
+    EXPECT_THAT(calls, ElementsAre(50));
+}